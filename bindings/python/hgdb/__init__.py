@@ -3,4 +3,4 @@ try:
 except ImportError:
     pass
 
-from .db import DebugSymbolTable
+from .db import DebugSymbolTable, DebugSymbolTableWriter
@@ -73,21 +73,32 @@ class HGDBClient:
         return res
 
     async def set_breakpoint(self, filename, line_num, column_num=0, token="", cond="",
-                             check_error=True):
+                             check_error=True, ignore_count=None, hit_every=None):
         payload = {"request": True, "type": "breakpoint", "token": token,
                    "payload": {"filename": filename, "line_num": line_num, "column_num": column_num,
                                "action": "add"}}
         if len(cond) > 0:
             payload["payload"]["condition"] = cond
+        self.__set_hit_policy(payload, ignore_count, hit_every)
         return await self.__send_check(payload, check_error)
 
-    async def set_breakpoint_id(self, bp_id, cond="", token="", check_error=True):
+    async def set_breakpoint_id(self, bp_id, cond="", token="", check_error=True, ignore_count=None,
+                                hit_every=None):
         payload = {"request": True, "type": "breakpoint-id", "token": token,
                    "payload": {"id": bp_id, "action": "add"}}
         if len(cond) > 0:
             payload["payload"]["condition"] = cond
+        self.__set_hit_policy(payload, ignore_count, hit_every)
         return await self.__send_check(payload, check_error)
 
+    @staticmethod
+    def __set_hit_policy(payload, ignore_count, hit_every):
+        # the simulator only pauses after ignore_count hits, then every hit_every hits
+        if ignore_count is not None:
+            payload["payload"]["ignore_count"] = ignore_count
+        if hit_every is not None:
+            payload["payload"]["hit_every"] = hit_every
+
     async def remove_breakpoint(self, filename, line_num, column_num=0, token="", check_error=True):
         payload = {"request": True, "type": "breakpoint", "token": token,
                    "payload": {"filename": filename, "line_num": line_num, "column_num": column_num,
@@ -107,14 +118,15 @@ class HGDBClient:
             payload["payload"]["column_num"] = column_num
         return await self.__send_check(payload)
 
-    async def continue_(self):
-        await self.__send_command("continue")
+    async def continue_(self, count=None, condition=None, trace=False):
+        await self.__send_command("continue", count, condition, trace)
 
     async def stop(self):
         await self.__send_command("stop")
 
-    async def step_over(self):
-        await self.__send_command("step_over")
+    async def step_over(self, count=None, condition=None, trace=False):
+        # with count or condition set, the server keeps stepping and only reports the final stop
+        await self.__send_command("step_over", count, condition, trace)
 
     async def step_back(self):
         await self.__send_command("step_back")
@@ -122,8 +134,20 @@ class HGDBClient:
     async def reverse_continue(self):
         await self.__send_command("reverse_continue")
 
-    async def __send_command(self, command_str):
+    async def run_to_time(self, time):
+        # the simulator pauses at the given time with a breakpoint message that has no location
+        await self.__send_command("run_to_time", time=time)
+
+    async def __send_command(self, command_str, count=None, condition=None, trace=False, time=None):
         payload = {"request": True, "type": "command", "payload": {"command": command_str}}
+        if time is not None:
+            payload["payload"]["time"] = time
+        if count is not None:
+            payload["payload"]["count"] = count
+        if condition is not None:
+            payload["payload"]["condition"] = condition
+        if trace:
+            payload["payload"]["trace"] = True
         await self.send(payload)
         # no care about the response
         await self.recv()
@@ -137,21 +161,40 @@ class HGDBClient:
                    "payload": {"scope": scope, "expression": expression, "is_context": is_context}}
         return await self.__send_check(payload, check_error=check_error)
 
+    async def get_variables(self, breakpoint_id, kind="local", prefix=None, offset=0, limit=None,
+                            check_error=True):
+        payload = {"request": True, "type": "variables",
+                   "payload": {"breakpoint_id": breakpoint_id, "kind": kind, "offset": offset}}
+        if prefix is not None:
+            payload["payload"]["prefix"] = prefix
+        if limit is not None:
+            payload["payload"]["limit"] = limit
+        return await self.__send_check(payload, check_error=check_error)
+
     async def change_option(self, check_error=True, **kwargs):
         payload = {"request": True, "type": "option-change", "payload": {}}
         for name, value in kwargs.items():
             payload["payload"][name] = value
         return await self.__send_check(payload, check_error=check_error)
 
-    async def add_monitor(self, name, instance_id=None, breakpoint_id=None, monitor_type="breakpoint"):
+    async def add_monitor(self, name, instance_id=None, breakpoint_id=None, monitor_type="breakpoint",
+                          sample_every=None, sample_interval=None, aggregate=None, is_expression=False):
         assert (instance_id is not None) or (breakpoint_id is None)
         assert monitor_type in {"breakpoint", "clock_edge"}
+        assert aggregate is None or aggregate in {"min", "max", "last", "toggle"}
         payload = {"request": True, "type": "monitor",
-                   "payload": {"action_type": "add", "monitor_type": monitor_type, "var_name": name}}
+                   "payload": {"action_type": "add", "monitor_type": monitor_type}}
+        payload["payload"]["expression" if is_expression else "var_name"] = name
         if breakpoint_id is not None:
             payload["payload"]["breakpoint_id"] = breakpoint_id
         if instance_id is not None:
             payload["payload"]["instance_id"] = instance_id
+        if sample_every is not None:
+            payload["payload"]["sample_every"] = sample_every
+        if sample_interval is not None:
+            payload["payload"]["sample_interval"] = sample_interval
+        if aggregate is not None:
+            payload["payload"]["aggregate"] = aggregate
         resp = await self.__send_check(payload, True)
         return resp["payload"]["track_id"]
 
@@ -163,10 +206,40 @@ class HGDBClient:
             payload["payload"]["breakpoint_id"] = breakpoint_id
         return await self.__send_check(payload, check_error=check_error)
 
+    async def add_watchpoint(self, name, condition=None, instance_id=None, breakpoint_id=None):
+        payload = {"request": True, "type": "watchpoint", "payload": {"action": "add", "var_name": name}}
+        if condition is not None:
+            payload["payload"]["condition"] = condition
+        if instance_id is not None:
+            payload["payload"]["instance_id"] = instance_id
+        if breakpoint_id is not None:
+            payload["payload"]["breakpoint_id"] = breakpoint_id
+        resp = await self.__send_check(payload, True)
+        return resp["payload"]["id"]
+
+    async def remove_watchpoint(self, watchpoint_id):
+        payload = {"request": True, "type": "watchpoint", "payload": {"action": "remove", "id": watchpoint_id}}
+        await self.__send_check(payload, True)
+
     async def remove_monitor(self, track_id):
         payload = {"request": True, "type": "monitor", "payload": {"action_type": "remove", "track_id": track_id}}
         await self.__send_check(payload, True)
 
+    async def batch(self, payloads, check_error=True):
+        # sends multiple requests in one message. responses are returned in the same order
+        for payload in payloads:
+            payload["request"] = True
+            if "token" not in payload:
+                payload["token"] = "python-{0}".format(self.token_count)
+                self.token_count += 1
+        payload = {"request": True, "type": "batch", "payload": {"requests": payloads}}
+        res = await self.__send_check(payload, True)
+        responses = res["payload"]["responses"]
+        if check_error:
+            for r in responses:
+                self.__check_status(r)
+        return responses
+
     async def close(self):
         await self.ws.close()
 
@@ -58,9 +58,28 @@ class DebugSymbolTable:
     def get_filenames(self):
         return _hgdb.get_filenames(self.db)
 
+    # bulk queries. results are dictionaries of columns, where integer columns can be
+    # converted to numpy arrays without copy, e.g. numpy.asarray(result["id"])
+    def get_breakpoints(self, filename=None):
+        return _hgdb.get_breakpoints(self.db, filename)
+
+    def get_instances(self):
+        return _hgdb.get_instances(self.db)
+
+    def get_context_variables(self, breakpoint_id=None):
+        return _hgdb.get_context_variables(self.db, breakpoint_id)
+
+    def get_generator_variables(self, instance_id=None):
+        return _hgdb.get_generator_variables(self.db, instance_id)
+
     # transaction based insertion
     def begin_transaction(self):
         return _hgdb.begin_transaction(self.db)
 
     def end_transaction(self):
         return _hgdb.end_transaction(self.db)
+
+
+# bulk writer. Unlike DebugSymbolTable, ids are not checked against existing rows, so it is much
+# faster when producing large symbol tables. Columns can be passed in as lists or numpy arrays
+DebugSymbolTableWriter = _hgdb.SymbolTableWriter
@@ -1,10 +1,210 @@
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <limits>
+#include <set>
+
 #include "schema.hh"
+#include "writer.hh"
 
 namespace py = pybind11;
 
+// integer columns can either be a python sequence or an object implementing the buffer
+// protocol, e.g. numpy arrays. numpy is only needed for the latter
+using IDArray = py::array_t<uint32_t, py::array::c_style | py::array::forcecast>;
+
+std::vector<uint32_t> to_vector(const py::object &obj) {
+    if (!PyObject_CheckBuffer(obj.ptr())) return py::cast<std::vector<uint32_t>>(obj);
+    auto array = py::cast<IDArray>(obj);
+    if (array.ndim() != 1) throw std::invalid_argument("Only 1-D array is supported");
+    auto const *data = array.data();
+    return std::vector<uint32_t>(data, data + array.size());
+}
+
+// optional columns use None as default value
+template <typename T>
+std::vector<T> to_optional_vector(const py::object &obj) {
+    if (obj.is_none()) return {};
+    return py::cast<std::vector<T>>(obj);
+}
+
+std::vector<uint32_t> to_optional_id_vector(const py::object &obj) {
+    if (obj.is_none()) return {};
+    return to_vector(obj);
+}
+
+// integer column returned by bulk queries. it implements the buffer protocol so that
+// numpy.asarray() and memoryview() can use it without any copy
+class IDColumn {
+public:
+    explicit IDColumn(std::vector<uint32_t> values) : values_(std::move(values)) {}
+
+    uint32_t operator[](int64_t index) const {
+        auto size = static_cast<int64_t>(values_.size());
+        if (index < 0) index += size;
+        if (index < 0 || index >= size) throw py::index_error();
+        return values_[index];
+    }
+    uint64_t size() const { return values_.size(); }
+    const std::vector<uint32_t> &values() const { return values_; }
+    uint32_t *data() { return values_.data(); }
+
+private:
+    std::vector<uint32_t> values_;
+};
+
+// missing foreign keys are reported as the max value
+constexpr uint32_t null_id = std::numeric_limits<uint32_t>::max();
+
+uint32_t get_id(const std::unique_ptr<uint32_t> &id) { return id ? *id : null_id; }
+
+struct BreakPointColumns {
+    std::vector<uint32_t> id;
+    std::vector<uint32_t> instance_id;
+    std::vector<std::string> filename;
+    std::vector<uint32_t> line_num;
+    std::vector<uint32_t> column_num;
+    std::vector<std::string> condition;
+    std::vector<std::string> trigger;
+};
+
+struct InstanceColumns {
+    std::vector<uint32_t> id;
+    std::vector<std::string> name;
+    std::vector<std::string> annotation;
+};
+
+struct VariableMappingColumns {
+    std::vector<std::string> name;
+    // either breakpoint id or instance id
+    std::vector<uint32_t> parent_id;
+    std::vector<uint32_t> variable_id;
+    std::vector<std::string> value;
+    std::vector<bool> is_rtl;
+    std::vector<std::string> annotation;
+};
+
+template <typename... Args>
+BreakPointColumns get_breakpoint_columns(hgdb::DebugDatabase &db, Args &&...args) {
+    using namespace sqlite_orm;
+    using hgdb::BreakPoint;
+    // NOLINTNEXTLINE
+    auto rows = db.select(columns(&BreakPoint::id, &BreakPoint::instance_id, &BreakPoint::filename,
+                                  &BreakPoint::line_num, &BreakPoint::column_num,
+                                  &BreakPoint::condition, &BreakPoint::trigger),
+                          std::forward<Args>(args)...,
+                          multi_order_by(order_by(&BreakPoint::filename), order_by(&BreakPoint::id)));
+    BreakPointColumns result;
+    result.id.reserve(rows.size());
+    result.instance_id.reserve(rows.size());
+    result.filename.reserve(rows.size());
+    result.line_num.reserve(rows.size());
+    result.column_num.reserve(rows.size());
+    result.condition.reserve(rows.size());
+    result.trigger.reserve(rows.size());
+    for (auto &row : rows) {
+        result.id.emplace_back(std::get<0>(row));
+        result.instance_id.emplace_back(get_id(std::get<1>(row)));
+        result.filename.emplace_back(std::move(std::get<2>(row)));
+        result.line_num.emplace_back(std::get<3>(row));
+        result.column_num.emplace_back(std::get<4>(row));
+        result.condition.emplace_back(std::move(std::get<5>(row)));
+        result.trigger.emplace_back(std::move(std::get<6>(row)));
+    }
+    return result;
+}
+
+template <typename T>
+void reserve_columns(VariableMappingColumns &result, const T &rows) {
+    result.name.reserve(rows.size());
+    result.parent_id.reserve(rows.size());
+    result.variable_id.reserve(rows.size());
+    result.value.reserve(rows.size());
+    result.is_rtl.reserve(rows.size());
+}
+
+template <typename T>
+VariableMappingColumns get_context_variable_columns(hgdb::DebugDatabase &db, const T &condition) {
+    using namespace sqlite_orm;
+    using hgdb::ContextVariable;
+    using hgdb::Variable;
+    // NOLINTNEXTLINE
+    auto rows = db.select(columns(&ContextVariable::name, &ContextVariable::breakpoint_id,
+                                  &ContextVariable::variable_id, &Variable::value,
+                                  &Variable::is_rtl),
+                          condition);
+    VariableMappingColumns result;
+    reserve_columns(result, rows);
+    for (auto &row : rows) {
+        result.name.emplace_back(std::move(std::get<0>(row)));
+        result.parent_id.emplace_back(get_id(std::get<1>(row)));
+        result.variable_id.emplace_back(get_id(std::get<2>(row)));
+        result.value.emplace_back(std::move(std::get<3>(row)));
+        result.is_rtl.emplace_back(std::get<4>(row));
+    }
+    return result;
+}
+
+template <typename T>
+VariableMappingColumns get_generator_variable_columns(hgdb::DebugDatabase &db,
+                                                      const T &condition) {
+    using namespace sqlite_orm;
+    using hgdb::GeneratorVariable;
+    using hgdb::Variable;
+    // NOLINTNEXTLINE
+    auto rows = db.select(columns(&GeneratorVariable::name, &GeneratorVariable::instance_id,
+                                  &GeneratorVariable::variable_id, &Variable::value,
+                                  &Variable::is_rtl, &GeneratorVariable::annotation),
+                          condition);
+    VariableMappingColumns result;
+    reserve_columns(result, rows);
+    result.annotation.reserve(rows.size());
+    for (auto &row : rows) {
+        result.name.emplace_back(std::move(std::get<0>(row)));
+        result.parent_id.emplace_back(get_id(std::get<1>(row)));
+        result.variable_id.emplace_back(get_id(std::get<2>(row)));
+        result.value.emplace_back(std::move(std::get<3>(row)));
+        result.is_rtl.emplace_back(std::get<4>(row));
+        result.annotation.emplace_back(std::move(std::get<5>(row)));
+    }
+    return result;
+}
+
+// python objects can only be created with GIL held
+py::dict to_dict(BreakPointColumns &columns) {
+    py::dict result;
+    result["id"] = IDColumn(std::move(columns.id));
+    result["instance_id"] = IDColumn(std::move(columns.instance_id));
+    result["filename"] = py::cast(columns.filename);
+    result["line_num"] = IDColumn(std::move(columns.line_num));
+    result["column_num"] = IDColumn(std::move(columns.column_num));
+    result["condition"] = py::cast(columns.condition);
+    result["trigger"] = py::cast(columns.trigger);
+    return result;
+}
+
+py::dict to_dict(InstanceColumns &columns) {
+    py::dict result;
+    result["id"] = IDColumn(std::move(columns.id));
+    result["name"] = py::cast(columns.name);
+    result["annotation"] = py::cast(columns.annotation);
+    return result;
+}
+
+py::dict to_dict(VariableMappingColumns &columns, const char *parent_name, bool has_annotation) {
+    py::dict result;
+    result["name"] = py::cast(columns.name);
+    result[parent_name] = IDColumn(std::move(columns.parent_id));
+    result["variable_id"] = IDColumn(std::move(columns.variable_id));
+    result["value"] = py::cast(columns.value);
+    result["is_rtl"] = py::cast(columns.is_rtl);
+    if (has_annotation) {
+        result["annotation"] = py::cast(columns.annotation);
+    }
+    return result;
+}
+
 template <typename T>
 bool has_type_id(hgdb::DebugDatabase &db, uint32_t id) {
     auto ptr = db.get_pointer<T>(id);
@@ -47,12 +247,200 @@ PYBIND11_MODULE(_hgdb, m) {
 
     // some helper functions for other tools to digest the symbol table
     // especially the local IDE
-    m.def("get_filenames", [](hgdb::DebugDatabase &db) {
-        std::set<std::string> filenames;
-        auto breakpoints = db.get_all<hgdb::BreakPoint>();
-        for (auto const &bp : breakpoints) {
-            filenames.emplace(bp.filename);
+    m.def(
+        "get_filenames",
+        [](hgdb::DebugDatabase &db) {
+            using namespace sqlite_orm;
+            auto filenames = db.select(distinct(&hgdb::BreakPoint::filename));
+            return std::set<std::string>(filenames.begin(), filenames.end());
+        },
+        py::call_guard<py::gil_scoped_release>());
+
+    // bulk queries. results are returned as a dictionary of columns. integer columns support
+    // the buffer protocol. queries run without GIL
+    py::class_<IDColumn>(m, "IDColumn", py::buffer_protocol())
+        .def_buffer([](IDColumn &column) -> py::buffer_info {
+            return py::buffer_info(column.data(), sizeof(uint32_t),
+                                   py::format_descriptor<uint32_t>::format(), 1,
+                                   {static_cast<py::ssize_t>(column.size())},
+                                   {static_cast<py::ssize_t>(sizeof(uint32_t))});
+        })
+        .def("__len__", &IDColumn::size)
+        .def("__getitem__", &IDColumn::operator[])
+        .def("tolist", &IDColumn::values);
+    m.attr("NULL_ID") = null_id;
+
+    m.def(
+        "get_breakpoints",
+        [](hgdb::DebugDatabase &db, const py::object &filename) {
+            using namespace sqlite_orm;
+            BreakPointColumns result;
+            if (filename.is_none()) {
+                py::gil_scoped_release release;
+                result = get_breakpoint_columns(db);
+            } else {
+                auto name = py::cast<std::string>(filename);
+                py::gil_scoped_release release;
+                result = get_breakpoint_columns(db, where(c(&hgdb::BreakPoint::filename) == name));
+            }
+            return to_dict(result);
+        },
+        py::arg("db"), py::arg("filename") = py::none());
+    m.def("get_instances", [](hgdb::DebugDatabase &db) {
+        using namespace sqlite_orm;
+        using hgdb::Instance;
+        InstanceColumns result;
+        {
+            py::gil_scoped_release release;
+            // NOLINTNEXTLINE
+            auto rows = db.select(columns(&Instance::id, &Instance::name, &Instance::annotation),
+                                  order_by(&Instance::id));
+            result.id.reserve(rows.size());
+            result.name.reserve(rows.size());
+            result.annotation.reserve(rows.size());
+            for (auto &row : rows) {
+                result.id.emplace_back(std::get<0>(row));
+                result.name.emplace_back(std::move(std::get<1>(row)));
+                result.annotation.emplace_back(std::move(std::get<2>(row)));
+            }
         }
-        return filenames;
+        return to_dict(result);
     });
+    m.def(
+        "get_context_variables",
+        [](hgdb::DebugDatabase &db, const py::object &breakpoint_id) {
+            using namespace sqlite_orm;
+            using hgdb::ContextVariable;
+            using hgdb::Variable;
+            VariableMappingColumns result;
+            if (breakpoint_id.is_none()) {
+                py::gil_scoped_release release;
+                result = get_context_variable_columns(
+                    db, where(c(&ContextVariable::variable_id) == &Variable::id));
+            } else {
+                auto id = py::cast<uint32_t>(breakpoint_id);
+                py::gil_scoped_release release;
+                result = get_context_variable_columns(
+                    db, where(c(&ContextVariable::breakpoint_id) == id &&
+                              c(&ContextVariable::variable_id) == &Variable::id));
+            }
+            return to_dict(result, "breakpoint_id", false);
+        },
+        py::arg("db"), py::arg("breakpoint_id") = py::none());
+    m.def(
+        "get_generator_variables",
+        [](hgdb::DebugDatabase &db, const py::object &instance_id) {
+            using namespace sqlite_orm;
+            using hgdb::GeneratorVariable;
+            using hgdb::Variable;
+            VariableMappingColumns result;
+            if (instance_id.is_none()) {
+                py::gil_scoped_release release;
+                result = get_generator_variable_columns(
+                    db, where(c(&GeneratorVariable::variable_id) == &Variable::id));
+            } else {
+                auto id = py::cast<uint32_t>(instance_id);
+                py::gil_scoped_release release;
+                result = get_generator_variable_columns(
+                    db, where(c(&GeneratorVariable::instance_id) == id &&
+                              c(&GeneratorVariable::variable_id) == &Variable::id));
+            }
+            return to_dict(result, "instance_id", true);
+        },
+        py::arg("db"), py::arg("instance_id") = py::none());
+
+    // bulk writer. notice that values are converted before releasing the GIL
+    using hgdb::SymbolTableWriter;
+    py::class_<SymbolTableWriter>(m, "SymbolTableWriter")
+        .def(py::init<const std::string &, uint64_t>(), py::arg("filename"),
+             py::arg("batch_size") = static_cast<uint64_t>(SymbolTableWriter::default_batch_size))
+        .def("store_instance", &SymbolTableWriter::store_instance, py::arg("id"),
+             py::arg("name"), py::arg("annotation") = "")
+        .def("store_variable", &SymbolTableWriter::store_variable, py::arg("id"),
+             py::arg("value"), py::arg("is_rtl") = true)
+        .def("store_breakpoint", &SymbolTableWriter::store_breakpoint, py::arg("id"),
+             py::arg("instance_id"), py::arg("filename"), py::arg("line_num"),
+             py::arg("column_num") = 0, py::arg("condition") = "", py::arg("trigger") = "")
+        .def("store_scope", &SymbolTableWriter::store_scope, py::arg("id"),
+             py::arg("breakpoints"))
+        .def("store_context_variable", &SymbolTableWriter::store_context_variable,
+             py::arg("name"), py::arg("breakpoint_id"), py::arg("variable_id"))
+        .def("store_generator_variable", &SymbolTableWriter::store_generator_variable,
+             py::arg("name"), py::arg("instance_id"), py::arg("variable_id"),
+             py::arg("annotation") = "")
+        .def("store_annotation", &SymbolTableWriter::store_annotation, py::arg("name"),
+             py::arg("value"))
+        .def("intern_variable", &SymbolTableWriter::intern_variable, py::arg("value"),
+             py::arg("is_rtl") = true)
+        .def(
+            "store_instances",
+            [](SymbolTableWriter &writer, const py::object &ids, const std::vector<std::string> &names,
+               const py::object &annotations) {
+                auto id_values = to_vector(ids);
+                auto annotation_values = to_optional_vector<std::string>(annotations);
+                py::gil_scoped_release release;
+                writer.store_instances(id_values, names, annotation_values);
+            },
+            py::arg("ids"), py::arg("names"), py::arg("annotations") = py::none())
+        .def(
+            "store_variables",
+            [](SymbolTableWriter &writer, const py::object &ids,
+               const std::vector<std::string> &values, const py::object &is_rtl) {
+                auto id_values = to_vector(ids);
+                auto is_rtl_values = to_optional_vector<bool>(is_rtl);
+                py::gil_scoped_release release;
+                writer.store_variables(id_values, values, is_rtl_values);
+            },
+            py::arg("ids"), py::arg("values"), py::arg("is_rtl") = py::none())
+        .def(
+            "store_breakpoints",
+            [](SymbolTableWriter &writer, const py::object &ids, const py::object &instance_ids,
+               const std::vector<std::string> &filenames, const py::object &line_nums,
+               const py::object &column_nums, const py::object &conditions,
+               const py::object &triggers) {
+                auto id_values = to_vector(ids);
+                auto instance_id_values = to_vector(instance_ids);
+                auto line_num_values = to_vector(line_nums);
+                auto column_num_values = to_optional_id_vector(column_nums);
+                auto condition_values = to_optional_vector<std::string>(conditions);
+                auto trigger_values = to_optional_vector<std::string>(triggers);
+                py::gil_scoped_release release;
+                writer.store_breakpoints(id_values, instance_id_values, filenames,
+                                         line_num_values, column_num_values, condition_values,
+                                         trigger_values);
+            },
+            py::arg("ids"), py::arg("instance_ids"), py::arg("filenames"), py::arg("line_nums"),
+            py::arg("column_nums") = py::none(), py::arg("conditions") = py::none(),
+            py::arg("triggers") = py::none())
+        .def(
+            "store_context_variables",
+            [](SymbolTableWriter &writer, const std::vector<std::string> &names,
+               const py::object &breakpoint_ids, const py::object &variable_ids) {
+                auto breakpoint_id_values = to_vector(breakpoint_ids);
+                auto variable_id_values = to_vector(variable_ids);
+                py::gil_scoped_release release;
+                writer.store_context_variables(names, breakpoint_id_values, variable_id_values);
+            },
+            py::arg("names"), py::arg("breakpoint_ids"), py::arg("variable_ids"))
+        .def(
+            "store_generator_variables",
+            [](SymbolTableWriter &writer, const std::vector<std::string> &names,
+               const py::object &instance_ids, const py::object &variable_ids,
+               const py::object &annotations) {
+                auto instance_id_values = to_vector(instance_ids);
+                auto variable_id_values = to_vector(variable_ids);
+                auto annotation_values = to_optional_vector<std::string>(annotations);
+                py::gil_scoped_release release;
+                writer.store_generator_variables(names, instance_id_values, variable_id_values,
+                                                 annotation_values);
+            },
+            py::arg("names"), py::arg("instance_ids"), py::arg("variable_ids"),
+            py::arg("annotations") = py::none())
+        .def("flush", &SymbolTableWriter::flush, py::call_guard<py::gil_scoped_release>())
+        .def("close", &SymbolTableWriter::close, py::call_guard<py::gil_scoped_release>())
+        .def(
+            "__enter__",
+            [](SymbolTableWriter &writer) -> SymbolTableWriter & { return writer; },
+            py::return_value_policy::reference)
+        .def("__exit__", [](SymbolTableWriter &writer, const py::args &) { writer.close(); });
 }
@@ -0,0 +1,498 @@
+#ifndef HGDB_WRITER_HH
+#define HGDB_WRITER_HH
+
+// notice that this header is also used by the python binding, which is compiled with C++14.
+// keep it free of C++17/20 features
+
+#include <sqlite3.h>
+
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "schema.hh"
+
+namespace hgdb {
+
+/**
+ * Indices used by the runtime to query the symbol table. They are not part of the schema
+ * since maintaining indices during bulk insertion is very slow. Tools that produce or
+ * rewrite symbol tables should create them once all the rows are stored.
+ */
+inline const std::vector<std::string> &symbol_table_indices() {
+    static const std::vector<std::string> indices = {
+        R"(CREATE INDEX IF NOT EXISTS "breakpoint_filename_line_num" ON "breakpoint" ("filename", "line_num"))",
+        R"(CREATE INDEX IF NOT EXISTS "breakpoint_instance_id" ON "breakpoint" ("instance_id"))",
+        R"(CREATE INDEX IF NOT EXISTS "instance_name" ON "instance" ("name"))",
+        R"(CREATE INDEX IF NOT EXISTS "context_variable_breakpoint_id" ON "context_variable" ("breakpoint_id"))",
+        R"(CREATE INDEX IF NOT EXISTS "generator_variable_instance_id" ON "generator_variable" ("instance_id"))",
+        R"(CREATE INDEX IF NOT EXISTS "annotation_name" ON "annotation" ("name"))"};
+    return indices;
+}
+
+inline void create_symbol_table_indices(sqlite3 *db) {
+    for (auto const &sql : symbol_table_indices()) {
+        char *error = nullptr;
+        if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &error) != SQLITE_OK) {
+            std::string msg = error ? error : "unknown error";
+            sqlite3_free(error);
+            throw std::runtime_error("Unable to create index: " + msg);
+        }
+    }
+}
+
+/**
+ * Bulk writer for the symbol table. Compared to the store_* helper functions, rows are
+ * buffered in columnar batches and flushed through prepared statements inside a single
+ * transaction, which is orders of magnitude faster when the symbol table is large.
+ *
+ * Repeated strings (filenames, conditions, variable values, etc.) are interned within a
+ * batch so that buffering millions of rows doesn't blow up the memory. If the producer
+ * doesn't want to keep track of variable ids, intern_variable() can be used to deduplicate
+ * variables across the entire symbol table.
+ *
+ * Indices are only created when the writer is closed. Notice that the writer doesn't
+ * check foreign keys. It is the producer's responsibility to provide valid ids.
+ */
+class SymbolTableWriter {
+public:
+    static constexpr uint64_t default_batch_size = 1u << 17u;
+
+    explicit SymbolTableWriter(const std::string &filename,
+                               uint64_t batch_size = default_batch_size)
+        : batch_size_(batch_size ? batch_size : default_batch_size) {
+        // let sqlite_orm create the schema so that the table layout is always in sync
+        init_debug_db(filename);
+        if (sqlite3_open(filename.c_str(), &db_) != SQLITE_OK) {
+            std::string msg = db_ ? sqlite3_errmsg(db_) : "out of memory";
+            sqlite3_close(db_);
+            db_ = nullptr;
+            throw std::runtime_error("Unable to open " + filename + ": " + msg);
+        }
+        // the table is written once and then read-only. if the process crashes half way the
+        // output is garbage anyway
+        exec("PRAGMA synchronous = OFF");
+        exec("PRAGMA journal_mode = MEMORY");
+        exec("PRAGMA temp_store = MEMORY");
+        exec("PRAGMA cache_size = -65536");
+
+        statements_.resize(static_cast<uint32_t>(Table::size), nullptr);
+        prepare(Table::instance,
+                R"(INSERT OR REPLACE INTO "instance" ("id", "name", "annotation") VALUES (?, ?, ?))");
+        prepare(Table::variable,
+                R"(INSERT OR REPLACE INTO "variable" ("id", "value", "is_rtl") VALUES (?, ?, ?))");
+        prepare(Table::breakpoint,
+                R"(INSERT OR REPLACE INTO "breakpoint" ("id", "instance_id", "filename", "line_num", )"
+                R"("column_num", "condition", "trigger") VALUES (?, ?, ?, ?, ?, ?, ?))");
+        prepare(Table::scope,
+                R"(INSERT OR REPLACE INTO "scope" ("scope", "breakpoints") VALUES (?, ?))");
+        prepare(Table::context_variable,
+                R"(INSERT INTO "context_variable" ("name", "breakpoint_id", "variable_id") )"
+                R"(VALUES (?, ?, ?))");
+        prepare(Table::generator_variable,
+                R"(INSERT INTO "generator_variable" ("name", "instance_id", "variable_id", )"
+                R"("annotation") VALUES (?, ?, ?, ?))");
+        prepare(Table::annotation,
+                R"(INSERT INTO "annotation" ("name", "value") VALUES (?, ?))");
+    }
+
+    SymbolTableWriter(const SymbolTableWriter &) = delete;
+    SymbolTableWriter &operator=(const SymbolTableWriter &) = delete;
+
+    // single row helpers. they have the same semantics as the store_* functions
+    void store_instance(uint32_t id, const std::string &name, const std::string &annotation = "") {
+        instances_.id.emplace_back(id);
+        instances_.name.emplace_back(intern(name));
+        instances_.annotation.emplace_back(intern(annotation));
+        row_added();
+    }
+
+    void store_variable(uint32_t id, const std::string &value, bool is_rtl = true) {
+        variables_.id.emplace_back(id);
+        variables_.value.emplace_back(intern(value));
+        variables_.is_rtl.emplace_back(is_rtl);
+        // keep variable ids allocated by intern_variable() away from user-provided ones
+        if (id >= next_variable_id_) next_variable_id_ = id + 1;
+        row_added();
+    }
+
+    void store_breakpoint(uint32_t id, uint32_t instance_id, const std::string &filename,
+                          uint32_t line_num, uint32_t column_num = 0,
+                          const std::string &condition = "", const std::string &trigger = "") {
+        breakpoints_.id.emplace_back(id);
+        breakpoints_.instance_id.emplace_back(instance_id);
+        breakpoints_.filename.emplace_back(intern(filename));
+        breakpoints_.line_num.emplace_back(line_num);
+        breakpoints_.column_num.emplace_back(column_num);
+        breakpoints_.condition.emplace_back(intern(condition));
+        breakpoints_.trigger.emplace_back(intern(trigger));
+        row_added();
+    }
+
+    void store_scope(uint32_t id, const std::vector<uint32_t> &breakpoints) {
+        std::string value;
+        for (auto i = 0u; i < breakpoints.size(); i++) {
+            if (i) value.append(" ");
+            value.append(std::to_string(breakpoints[i]));
+        }
+        scopes_.id.emplace_back(id);
+        scopes_.breakpoints.emplace_back(intern(value));
+        row_added();
+    }
+
+    void store_context_variable(const std::string &name, uint32_t breakpoint_id,
+                                uint32_t variable_id) {
+        context_variables_.name.emplace_back(intern(name));
+        context_variables_.parent_id.emplace_back(breakpoint_id);
+        context_variables_.variable_id.emplace_back(variable_id);
+        row_added();
+    }
+
+    void store_generator_variable(const std::string &name, uint32_t instance_id,
+                                  uint32_t variable_id, const std::string &annotation = "") {
+        generator_variables_.name.emplace_back(intern(name));
+        generator_variables_.parent_id.emplace_back(instance_id);
+        generator_variables_.variable_id.emplace_back(variable_id);
+        generator_variables_.annotation.emplace_back(intern(annotation));
+        row_added();
+    }
+
+    void store_annotation(const std::string &name, const std::string &value) {
+        annotations_.name.emplace_back(intern(name));
+        annotations_.value.emplace_back(intern(value));
+        row_added();
+    }
+
+    /**
+     * Returns the variable id for the given value. A new variable is created the first time
+     * a (value, is_rtl) pair is seen. Ids are allocated above any id explicitly stored so far.
+     */
+    uint32_t intern_variable(const std::string &value, bool is_rtl = true) {
+        auto &map = is_rtl ? rtl_variable_ids_ : variable_ids_;
+        auto it = map.find(value);
+        if (it != map.end()) return it->second;
+        auto id = next_variable_id_++;
+        map.emplace(value, id);
+        store_variable(id, value, is_rtl);
+        return id;
+    }
+
+    // columnar helpers. all the columns have to have the same size
+    void store_instances(const std::vector<uint32_t> &ids, const std::vector<std::string> &names,
+                         const std::vector<std::string> &annotations = {}) {
+        check_size(ids.size(), names.size(), "name");
+        check_optional_size(ids.size(), annotations.size(), "annotation");
+        for (auto i = 0u; i < ids.size(); i++) {
+            store_instance(ids[i], names[i], annotations.empty() ? empty_ : annotations[i]);
+        }
+    }
+
+    void store_variables(const std::vector<uint32_t> &ids, const std::vector<std::string> &values,
+                         const std::vector<bool> &is_rtl = {}) {
+        check_size(ids.size(), values.size(), "value");
+        check_optional_size(ids.size(), is_rtl.size(), "is_rtl");
+        for (auto i = 0u; i < ids.size(); i++) {
+            store_variable(ids[i], values[i], is_rtl.empty() || is_rtl[i]);
+        }
+    }
+
+    void store_breakpoints(const std::vector<uint32_t> &ids,
+                           const std::vector<uint32_t> &instance_ids,
+                           const std::vector<std::string> &filenames,
+                           const std::vector<uint32_t> &line_nums,
+                           const std::vector<uint32_t> &column_nums = {},
+                           const std::vector<std::string> &conditions = {},
+                           const std::vector<std::string> &triggers = {}) {
+        check_size(ids.size(), instance_ids.size(), "instance_id");
+        check_size(ids.size(), filenames.size(), "filename");
+        check_size(ids.size(), line_nums.size(), "line_num");
+        check_optional_size(ids.size(), column_nums.size(), "column_num");
+        check_optional_size(ids.size(), conditions.size(), "condition");
+        check_optional_size(ids.size(), triggers.size(), "trigger");
+        for (auto i = 0u; i < ids.size(); i++) {
+            store_breakpoint(ids[i], instance_ids[i], filenames[i], line_nums[i],
+                             column_nums.empty() ? 0 : column_nums[i],
+                             conditions.empty() ? empty_ : conditions[i],
+                             triggers.empty() ? empty_ : triggers[i]);
+        }
+    }
+
+    void store_context_variables(const std::vector<std::string> &names,
+                                 const std::vector<uint32_t> &breakpoint_ids,
+                                 const std::vector<uint32_t> &variable_ids) {
+        check_size(names.size(), breakpoint_ids.size(), "breakpoint_id");
+        check_size(names.size(), variable_ids.size(), "variable_id");
+        for (auto i = 0u; i < names.size(); i++) {
+            store_context_variable(names[i], breakpoint_ids[i], variable_ids[i]);
+        }
+    }
+
+    void store_generator_variables(const std::vector<std::string> &names,
+                                   const std::vector<uint32_t> &instance_ids,
+                                   const std::vector<uint32_t> &variable_ids,
+                                   const std::vector<std::string> &annotations = {}) {
+        check_size(names.size(), instance_ids.size(), "instance_id");
+        check_size(names.size(), variable_ids.size(), "variable_id");
+        check_optional_size(names.size(), annotations.size(), "annotation");
+        for (auto i = 0u; i < names.size(); i++) {
+            store_generator_variable(names[i], instance_ids[i], variable_ids[i],
+                                     annotations.empty() ? empty_ : annotations[i]);
+        }
+    }
+
+    /**
+     * Writes out all the buffered rows in one transaction
+     */
+    void flush() {
+        if (!num_rows_) return;
+        check_open();
+        exec("BEGIN TRANSACTION");
+        // insert in the order of foreign key dependencies
+        for (auto i = 0u; i < instances_.id.size(); i++) {
+            auto *stmt = statements_[static_cast<uint32_t>(Table::instance)];
+            bind(stmt, 1, instances_.id[i]);
+            bind_text(stmt, 2, instances_.name[i]);
+            bind_text(stmt, 3, instances_.annotation[i]);
+            step(stmt);
+        }
+        for (auto i = 0u; i < variables_.id.size(); i++) {
+            auto *stmt = statements_[static_cast<uint32_t>(Table::variable)];
+            bind(stmt, 1, variables_.id[i]);
+            bind_text(stmt, 2, variables_.value[i]);
+            bind(stmt, 3, static_cast<uint32_t>(variables_.is_rtl[i]));
+            step(stmt);
+        }
+        for (auto i = 0u; i < breakpoints_.id.size(); i++) {
+            auto *stmt = statements_[static_cast<uint32_t>(Table::breakpoint)];
+            bind(stmt, 1, breakpoints_.id[i]);
+            bind(stmt, 2, breakpoints_.instance_id[i]);
+            bind_text(stmt, 3, breakpoints_.filename[i]);
+            bind(stmt, 4, breakpoints_.line_num[i]);
+            bind(stmt, 5, breakpoints_.column_num[i]);
+            bind_text(stmt, 6, breakpoints_.condition[i]);
+            bind_text(stmt, 7, breakpoints_.trigger[i]);
+            step(stmt);
+        }
+        for (auto i = 0u; i < scopes_.id.size(); i++) {
+            auto *stmt = statements_[static_cast<uint32_t>(Table::scope)];
+            bind(stmt, 1, scopes_.id[i]);
+            bind_text(stmt, 2, scopes_.breakpoints[i]);
+            step(stmt);
+        }
+        for (auto i = 0u; i < context_variables_.name.size(); i++) {
+            auto *stmt = statements_[static_cast<uint32_t>(Table::context_variable)];
+            bind_text(stmt, 1, context_variables_.name[i]);
+            bind(stmt, 2, context_variables_.parent_id[i]);
+            bind(stmt, 3, context_variables_.variable_id[i]);
+            step(stmt);
+        }
+        for (auto i = 0u; i < generator_variables_.name.size(); i++) {
+            auto *stmt = statements_[static_cast<uint32_t>(Table::generator_variable)];
+            bind_text(stmt, 1, generator_variables_.name[i]);
+            bind(stmt, 2, generator_variables_.parent_id[i]);
+            bind(stmt, 3, generator_variables_.variable_id[i]);
+            bind_text(stmt, 4, generator_variables_.annotation[i]);
+            step(stmt);
+        }
+        for (auto i = 0u; i < annotations_.name.size(); i++) {
+            auto *stmt = statements_[static_cast<uint32_t>(Table::annotation)];
+            bind_text(stmt, 1, annotations_.name[i]);
+            bind_text(stmt, 2, annotations_.value[i]);
+            step(stmt);
+        }
+        exec("COMMIT");
+        clear_batch();
+    }
+
+    /**
+     * Flushes the remaining rows, builds the indices and closes the database. Calling it
+     * multiple times is a no-op
+     */
+    void close() {
+        if (!db_) return;
+        flush();
+        create_symbol_table_indices(db_);
+        exec("ANALYZE");
+        release();
+    }
+
+    uint64_t num_buffered_rows() const { return num_rows_; }
+
+    ~SymbolTableWriter() {
+        // destructors can't throw. users who care about errors should call close() explicitly
+        try {
+            close();
+        } catch (...) {
+            release();
+        }
+    }
+
+private:
+    enum class Table : uint32_t {
+        instance,
+        variable,
+        breakpoint,
+        scope,
+        context_variable,
+        generator_variable,
+        annotation,
+        size
+    };
+
+    // string columns store the index into the per-batch string pool
+    struct InstanceBatch {
+        std::vector<uint32_t> id;
+        std::vector<uint32_t> name;
+        std::vector<uint32_t> annotation;
+    };
+    struct VariableBatch {
+        std::vector<uint32_t> id;
+        std::vector<uint32_t> value;
+        std::vector<bool> is_rtl;
+    };
+    struct BreakPointBatch {
+        std::vector<uint32_t> id;
+        std::vector<uint32_t> instance_id;
+        std::vector<uint32_t> filename;
+        std::vector<uint32_t> line_num;
+        std::vector<uint32_t> column_num;
+        std::vector<uint32_t> condition;
+        std::vector<uint32_t> trigger;
+    };
+    struct ScopeBatch {
+        std::vector<uint32_t> id;
+        std::vector<uint32_t> breakpoints;
+    };
+    struct VariableMappingBatch {
+        std::vector<uint32_t> name;
+        std::vector<uint32_t> parent_id;
+        std::vector<uint32_t> variable_id;
+        std::vector<uint32_t> annotation;
+    };
+    struct AnnotationBatch {
+        std::vector<uint32_t> name;
+        std::vector<uint32_t> value;
+    };
+
+    sqlite3 *db_ = nullptr;
+    std::vector<sqlite3_stmt *> statements_;
+    uint64_t batch_size_;
+    uint64_t num_rows_ = 0;
+
+    InstanceBatch instances_;
+    VariableBatch variables_;
+    BreakPointBatch breakpoints_;
+    ScopeBatch scopes_;
+    VariableMappingBatch context_variables_;
+    VariableMappingBatch generator_variables_;
+    AnnotationBatch annotations_;
+
+    // per-batch string pool
+    std::vector<std::string> strings_;
+    std::unordered_map<std::string, uint32_t> string_ids_;
+
+    // used by intern_variable()
+    std::unordered_map<std::string, uint32_t> rtl_variable_ids_;
+    std::unordered_map<std::string, uint32_t> variable_ids_;
+    uint32_t next_variable_id_ = 0;
+
+    const std::string empty_;
+
+    uint32_t intern(const std::string &str) {
+        auto it = string_ids_.find(str);
+        if (it != string_ids_.end()) return it->second;
+        auto id = static_cast<uint32_t>(strings_.size());
+        strings_.emplace_back(str);
+        string_ids_.emplace(str, id);
+        return id;
+    }
+
+    void row_added() {
+        if (++num_rows_ >= batch_size_) flush();
+    }
+
+    void clear_batch() {
+        instances_ = {};
+        variables_ = {};
+        breakpoints_ = {};
+        scopes_ = {};
+        context_variables_ = {};
+        generator_variables_ = {};
+        annotations_ = {};
+        strings_.clear();
+        string_ids_.clear();
+        num_rows_ = 0;
+    }
+
+    void check_open() const {
+        if (!db_) throw std::runtime_error("Symbol table writer is already closed");
+    }
+
+    void exec(const char *sql) {
+        char *error = nullptr;
+        if (sqlite3_exec(db_, sql, nullptr, nullptr, &error) != SQLITE_OK) {
+            std::string msg = error ? error : "unknown error";
+            sqlite3_free(error);
+            throw std::runtime_error(std::string("Unable to execute ") + sql + ": " + msg);
+        }
+    }
+
+    void prepare(Table table, const char *sql) {
+        auto &stmt = statements_[static_cast<uint32_t>(table)];
+        if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+            std::string msg = sqlite3_errmsg(db_);
+            release();
+            throw std::runtime_error(std::string("Unable to prepare ") + sql + ": " + msg);
+        }
+    }
+
+    void bind(sqlite3_stmt *stmt, int index, uint32_t value) {
+        sqlite3_bind_int64(stmt, index, static_cast<sqlite3_int64>(value));
+    }
+
+    // string columns are indices into the string pool, which outlives the statement execution
+    void bind_text(sqlite3_stmt *stmt, int index, uint32_t string_id) {
+        auto const &value = strings_[string_id];
+        sqlite3_bind_text(stmt, index, value.c_str(), static_cast<int>(value.size()),
+                          SQLITE_STATIC);
+    }
+
+    void step(sqlite3_stmt *stmt) {
+        auto res = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        if (res != SQLITE_DONE) {
+            std::string msg = sqlite3_errmsg(db_);
+            sqlite3_exec(db_, "ROLLBACK", nullptr, nullptr, nullptr);
+            throw std::runtime_error("Unable to insert row: " + msg);
+        }
+    }
+
+    void release() {
+        for (auto *stmt : statements_) {
+            sqlite3_finalize(stmt);
+        }
+        statements_.clear();
+        if (db_) {
+            sqlite3_close(db_);
+            db_ = nullptr;
+        }
+    }
+
+    static void check_size(uint64_t expected, uint64_t actual, const char *name) {
+        if (expected != actual) {
+            throw std::invalid_argument(std::string("Column ") + name + " has " +
+                                        std::to_string(actual) + " rows, expected " +
+                                        std::to_string(expected));
+        }
+    }
+
+    static void check_optional_size(uint64_t expected, uint64_t actual, const char *name) {
+        if (actual) check_size(expected, actual, name);
+    }
+};
+
+}  // namespace hgdb
+
+#endif  // HGDB_WRITER_HH
@@ -0,0 +1,119 @@
+#include "cache.hh"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <unordered_map>
+
+#include "rtl.hh"
+#include "util.hh"
+
+namespace hgdb {
+
+// FNV-1a is good enough to detect changes. the cache is an optimization and never has to be
+// trusted for correctness beyond the key
+class FNVHash {
+public:
+    void update(const char *data, uint64_t size) {
+        for (uint64_t i = 0; i < size; i++) {
+            value_ ^= static_cast<uint8_t>(data[i]);
+            value_ *= prime;
+        }
+    }
+
+    void update(const std::string &str) {
+        update(str.c_str(), str.size());
+        // separator to avoid ambiguity between concatenated strings
+        update("", 1);
+    }
+
+    [[nodiscard]] uint64_t value() const { return value_; }
+
+private:
+    static constexpr uint64_t offset_basis = 0xcbf29ce484222325;
+    static constexpr uint64_t prime = 0x100000001b3;
+    uint64_t value_ = offset_basis;
+};
+
+NameCache::NameCache(std::string filename) : filename_(std::move(filename)) {}
+
+void NameCache::set_symbol_table(const std::string &filename) {
+    std::ifstream stream(filename, std::ios::binary);
+    if (!stream.good()) {
+        symbol_table_hash_ = std::nullopt;
+        return;
+    }
+    FNVHash hash;
+    std::array<char, 1 << 16> buffer{};
+    while (stream) {
+        stream.read(buffer.data(), buffer.size());
+        hash.update(buffer.data(), stream.gcount());
+    }
+    symbol_table_hash_ = hash.value();
+}
+
+bool NameCache::load(RTLSimulatorClient *rtl) {
+    if (!symbol_table_hash_ || !rtl) return false;
+    std::ifstream stream(filename_);
+    if (!stream.good()) return false;
+
+    std::string line;
+    if (!std::getline(stream, line) || line != header) return false;
+    if (!std::getline(stream, line) || line != fmt::format("{0:016x}", compute_key(rtl))) {
+        return false;
+    }
+
+    std::unordered_map<std::string, std::string> top_mapping;
+    std::unordered_map<std::string, bool> signals;
+    while (std::getline(stream, line)) {
+        auto tokens = util::get_tokens(line, "\t");
+        if (tokens.size() != 3) return false;
+        if (tokens[0] == "top") {
+            top_mapping.emplace(tokens[1], tokens[2]);
+        } else if (tokens[0] == "signal") {
+            signals.emplace(tokens[2], tokens[1] == "1");
+        } else {
+            return false;
+        }
+    }
+
+    rtl->set_top_mapping(top_mapping);
+    rtl->set_signal_validity(signals);
+    return true;
+}
+
+bool NameCache::save(RTLSimulatorClient *rtl) {
+    if (!symbol_table_hash_ || !rtl) return false;
+    std::ofstream stream(filename_, std::ios::trunc);
+    if (!stream.good()) return false;
+
+    stream << header << std::endl;
+    stream << fmt::format("{0:016x}", compute_key(rtl)) << std::endl;
+    auto top_mapping = rtl->get_top_mapping();
+    for (auto const &[src_name, tb_name] : top_mapping) {
+        stream << fmt::format("top\t{0}\t{1}", src_name, tb_name) << std::endl;
+    }
+    auto signals = rtl->get_signal_validity();
+    for (auto const &[name, valid] : signals) {
+        stream << fmt::format("signal\t{0}\t{1}", valid ? 1 : 0, name) << std::endl;
+    }
+    return stream.good();
+}
+
+uint64_t NameCache::compute_key(RTLSimulatorClient *rtl) const {
+    FNVHash hash;
+    auto symbol_table_hash = symbol_table_hash_ ? *symbol_table_hash_ : 0;
+    hash.update(std::to_string(symbol_table_hash));
+    hash.update(rtl->get_simulator_name());
+    hash.update(rtl->get_simulator_version());
+    auto top_names = rtl->get_top_module_names();
+    std::sort(top_names.begin(), top_names.end());
+    for (auto const &name : top_names) {
+        hash.update(name);
+    }
+    return hash.value();
+}
+
+}  // namespace hgdb
@@ -0,0 +1,40 @@
+#ifndef HGDB_CACHE_HH
+#define HGDB_CACHE_HH
+
+#include <optional>
+#include <string>
+
+namespace hgdb {
+
+class RTLSimulatorClient;
+
+/**
+ * On-disk cache of name resolution results that survives across simulation runs. The cache is
+ * keyed by the symbol table content, simulator name/version, and the top-level design
+ * hierarchy. It stores the top mapping and the validity of every signal queried so far
+ */
+class NameCache {
+public:
+    explicit NameCache(std::string filename);
+
+    // hash the symbol table content. without it the cache is never loaded or saved
+    void set_symbol_table(const std::string &filename);
+
+    // returns true if the cache matches the current run and has been loaded into the RTL client
+    bool load(RTLSimulatorClient *rtl);
+    bool save(RTLSimulatorClient *rtl);
+
+    [[nodiscard]] const std::string &filename() const { return filename_; }
+
+    static constexpr auto header = "hgdb-name-cache 1";
+
+private:
+    std::string filename_;
+    std::optional<uint64_t> symbol_table_hash_;
+
+    [[nodiscard]] uint64_t compute_key(RTLSimulatorClient *rtl) const;
+};
+
+}  // namespace hgdb
+
+#endif  // HGDB_CACHE_HH
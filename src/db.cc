@@ -205,6 +205,90 @@ std::vector<DebugDatabaseClient::GeneratorVariableInfo> DebugDatabaseClient::get
     return result;
 }
 
+std::vector<DebugDatabaseClient::ContextVariableInfo> DebugDatabaseClient::get_context_variables(
+    uint32_t breakpoint_id, const std::string &prefix, uint64_t offset, uint64_t limit,
+    bool resolve_hierarchy_value) {
+    using namespace sqlite_orm;
+    std::vector<DebugDatabaseClient::ContextVariableInfo> result;
+    auto prefix_size = static_cast<int>(prefix.size());
+    std::lock_guard guard(db_lock_);
+    // NOLINTNEXTLINE
+    auto values = db_->select(
+        columns(&ContextVariable::variable_id, &ContextVariable::name, &Variable::value,
+                &Variable::is_rtl, &Instance::name),
+        where(c(&ContextVariable::breakpoint_id) == breakpoint_id &&
+              c(&ContextVariable::variable_id) == &Variable::id &&
+              c(&Instance::id) == &BreakPoint::instance_id && c(&BreakPoint::id) == breakpoint_id &&
+              is_equal(substr(&ContextVariable::name, 1, prefix_size), prefix)),
+        order_by(&ContextVariable::name),
+        limit(static_cast<int64_t>(limit), sqlite_orm::offset(static_cast<int64_t>(offset))));
+    result.reserve(values.size());
+    for (auto const &[variable_id, name, value, is_rtl, instance_name] : values) {
+        auto id = *variable_id;
+        auto actual_value =
+            resolve_hierarchy_value ? get_var_value(is_rtl, value, instance_name) : value;
+        result.emplace_back(std::make_pair(
+            ContextVariable{.name = name,
+                            .breakpoint_id = std::make_unique<uint32_t>(breakpoint_id),
+                            .variable_id = std::make_unique<uint32_t>(id)},
+            Variable{.id = id, .value = actual_value, .is_rtl = is_rtl}));
+    }
+    return result;
+}
+
+std::vector<DebugDatabaseClient::GeneratorVariableInfo> DebugDatabaseClient::get_generator_variable(
+    uint32_t instance_id, const std::string &prefix, uint64_t offset, uint64_t limit,
+    bool resolve_hierarchy_value) {
+    using namespace sqlite_orm;
+    std::vector<DebugDatabaseClient::GeneratorVariableInfo> result;
+    auto prefix_size = static_cast<int>(prefix.size());
+    std::lock_guard guard(db_lock_);
+    // NOLINTNEXTLINE
+    auto values = db_->select(
+        columns(&GeneratorVariable::variable_id, &GeneratorVariable::name, &Variable::value,
+                &Variable::is_rtl, &Instance::name),
+        where(c(&GeneratorVariable::instance_id) == instance_id &&
+              c(&GeneratorVariable::variable_id) == &Variable::id &&
+              c(&Instance::id) == instance_id &&
+              is_equal(substr(&GeneratorVariable::name, 1, prefix_size), prefix)),
+        order_by(&GeneratorVariable::name),
+        limit(static_cast<int64_t>(limit), sqlite_orm::offset(static_cast<int64_t>(offset))));
+    result.reserve(values.size());
+    for (auto const &[variable_id, name, value, is_rtl, instance_name] : values) {
+        auto id = *variable_id;
+        auto actual_value =
+            resolve_hierarchy_value ? get_var_value(is_rtl, value, instance_name) : value;
+        result.emplace_back(
+            std::make_pair(GeneratorVariable{.name = name,
+                                             .instance_id = std::make_unique<uint32_t>(instance_id),
+                                             .variable_id = std::make_unique<uint32_t>(id)},
+                           Variable{.id = id, .value = actual_value, .is_rtl = is_rtl}));
+    }
+    return result;
+}
+
+uint64_t DebugDatabaseClient::get_context_variable_count(uint32_t breakpoint_id,
+                                                         const std::string &prefix) {
+    using namespace sqlite_orm;
+    auto prefix_size = static_cast<int>(prefix.size());
+    std::lock_guard guard(db_lock_);
+    auto count = db_->count<ContextVariable>(
+        where(c(&ContextVariable::breakpoint_id) == breakpoint_id &&
+              is_equal(substr(&ContextVariable::name, 1, prefix_size), prefix)));
+    return static_cast<uint64_t>(count);
+}
+
+uint64_t DebugDatabaseClient::get_generator_variable_count(uint32_t instance_id,
+                                                           const std::string &prefix) {
+    using namespace sqlite_orm;
+    auto prefix_size = static_cast<int>(prefix.size());
+    std::lock_guard guard(db_lock_);
+    auto count = db_->count<GeneratorVariable>(
+        where(c(&GeneratorVariable::instance_id) == instance_id &&
+              is_equal(substr(&GeneratorVariable::name, 1, prefix_size), prefix)));
+    return static_cast<uint64_t>(count);
+}
+
 std::vector<std::string> DebugDatabaseClient::get_instance_names() {
     using namespace sqlite_orm;
     std::lock_guard guard(db_lock_);
@@ -33,6 +33,17 @@ public:
     using GeneratorVariableInfo = std::pair<GeneratorVariable, Variable>;
     [[nodiscard]] std::vector<GeneratorVariableInfo> get_generator_variable(
         uint32_t instance_id, bool resolve_hierarchy_value = true);
+    // paged queries ordered by name. only variables whose names start with prefix are returned
+    [[nodiscard]] std::vector<ContextVariableInfo> get_context_variables(
+        uint32_t breakpoint_id, const std::string &prefix, uint64_t offset, uint64_t limit,
+        bool resolve_hierarchy_value = true);
+    [[nodiscard]] std::vector<GeneratorVariableInfo> get_generator_variable(
+        uint32_t instance_id, const std::string &prefix, uint64_t offset, uint64_t limit,
+        bool resolve_hierarchy_value = true);
+    [[nodiscard]] uint64_t get_context_variable_count(uint32_t breakpoint_id,
+                                                      const std::string &prefix = "");
+    [[nodiscard]] uint64_t get_generator_variable_count(uint32_t instance_id,
+                                                        const std::string &prefix = "");
     [[nodiscard]] std::vector<std::string> get_instance_names();
     [[nodiscard]] std::vector<std::string> get_annotation_values(const std::string &name);
     std::unordered_map<std::string, int64_t> get_context_static_values(uint32_t breakpoint_id);
@@ -2,12 +2,17 @@
 
 #include <filesystem>
 #include <functional>
+#include <limits>
 #include <thread>
 
 #include "fmt/format.h"
 #include "log.hh"
 #include "util.hh"
 
+#ifdef __linux__
+#include "shm.hh"
+#endif
+
 namespace fs = std::filesystem;
 
 namespace hgdb {
@@ -17,19 +22,48 @@ Debugger::Debugger(std::unique_ptr<AVPIProvider> vpi) {
     // initialize the RTL client first
     // using the default implementation
     rtl_ = std::make_unique<RTLSimulatorClient>(std::move(vpi));
-    // initialize the webserver here
-    server_ = std::make_unique<DebugServer>();
+    // initialize the webserver here. same-host clients can use shared memory instead
+#ifdef __linux__
+    if (auto shm_name = get_cli_value(debug_shm)) {
+        auto server = std::make_unique<ShmDebugServer>(*shm_name);
+        if (server->is_open()) {
+            server_ = std::move(server);
+        } else {
+            log_error("Fall back to websocket");
+        }
+    }
+#endif
+    if (!server_) {
+        auto server = std::make_unique<DebugServer>();
+        if (auto num_threads_str = get_cli_value(debug_server_threads)) {
+            auto num_threads = util::stoul(*num_threads_str);
+            if (num_threads && *num_threads <= std::numeric_limits<uint32_t>::max()) {
+                server->set_num_threads(static_cast<uint32_t>(*num_threads));
+            } else {
+                log_error(fmt::format("Invalid number of server threads {0}. Use {1} instead",
+                                      *num_threads_str, DebugServer::default_num_threads));
+            }
+        }
+        server_ = std::move(server);
+    }
     log_enabled_ = get_logging();
+    index_hierarchy_ = has_cli_flag(debug_index_hierarchy);
+    filter_clock_edge_ = has_cli_flag(debug_filter_clock_edge);
+    if (auto cache_filename = get_cli_value(debug_name_cache)) {
+        name_cache_ = std::make_unique<NameCache>(*cache_filename);
+    }
     // initialize the monitor
     monitor_ = Monitor([this](const std::string &name) { return this->get_value(name); });
 
     // set up some call backs
     server_->set_on_call_client_disconnect([this]() {
-        if (detach_after_disconnect_) detach();
+        // detaching touches the simulator
+        if (detach_after_disconnect_) server_->post_ordered([this]() { detach(); });
     });
 
     // set vendor specific options
     set_vendor_initial_options();
+    update_server_options();
 }
 
 bool Debugger::initialize_db(const std::string &filename) {
@@ -40,17 +74,35 @@ bool Debugger::initialize_db(const std::string &filename) {
         return false;
     }
     log_info(fmt::format("Debug database set to {0}", filename));
+    if (name_cache_) name_cache_->set_symbol_table(filename);
     initialize_db(std::make_unique<DebugDatabaseClient>(filename));
     return true;
 }
 
 void Debugger::initialize_db(std::unique_ptr<DebugDatabaseClient> db) {
     if (!db) return;
+    std::unique_lock guard(symbol_table_lock_);
     db_ = std::move(db);
     // get all the instance names
     auto instances = db_->get_instance_names();
-    log_info("Compute instance mapping");
-    rtl_->initialize_instance_mapping(instances);
+    if (name_cache_ && name_cache_->load(rtl_.get())) {
+        log_info(fmt::format("Load name cache from {0}", name_cache_->filename()));
+    } else {
+        log_info("Compute instance mapping");
+        rtl_->initialize_instance_mapping(instances);
+    }
+    if (index_hierarchy_) {
+        log_info("Index design hierarchy");
+        auto num_signals = rtl_->index_signals(db_->get_all_signal_names());
+        log_info(fmt::format("{0} signals indexed", num_signals));
+    }
+
+    // clocks may be different in the new symbol table
+    {
+        std::lock_guard guard(clock_values_lock_);
+        clock_values_.clear();
+        clock_values_initialized_ = false;
+    }
 
     // set up the scheduler
     scheduler_ =
@@ -69,7 +121,12 @@ void Debugger::run() {
         // need to get information about the port number
         auto port = get_port();
         is_running_ = true;
-        log_info(fmt::format("Debugging server started at :{0}", port));
+        if (dynamic_cast<DebugServer *>(server_.get())) {
+            log_info(fmt::format("Debugging server started at :{0}", port));
+        } else {
+            log_info(fmt::format("Debugging server started at shared memory {0}",
+                                 *get_cli_value(debug_shm)));
+        }
         server_->run(port);
     });
     // block this thread until we receive the continue from user
@@ -78,13 +135,25 @@ void Debugger::run() {
 
 void Debugger::stop() {
     server_->stop();
+    if (name_cache_ && name_cache_->save(rtl_.get())) {
+        log_info(fmt::format("Save name cache to {0}", name_cache_->filename()));
+    }
     if (is_running_.load()) {
         // just detach it from the simulator
         detach();
     }
 }
 
-void Debugger::eval() {
+void Debugger::eval(std::optional<uint32_t> clock_domain) {
+    // fast-forwarding. nothing is evaluated before the wake-up time
+    if (auto wake_up_time = wake_up_time_.load(std::memory_order_relaxed)) [[unlikely]] {
+        if (rtl_->get_simulation_time() < wake_up_time) return;
+        wake_up();
+    }
+    // skip time steps without any clock posedge
+    if (filter_clock_edge_ && !has_clock_posedge()) {
+        return;
+    }
     // if we set to pause at posedge, need to do that at the very beginning!
     if (pause_at_posedge) [[unlikely]] {
         lock_.wait();
@@ -95,7 +164,7 @@ void Debugger::eval() {
     // however, the server side can still takes breakpoint requests, hence modifying the
     // breakpoints_.
     log_info("Start breakpoint evaluation...");
-    start_breakpoint_evaluation();  // clean the state
+    start_breakpoint_evaluation(clock_domain);  // clean the state
     while (true) {
         auto bps = scheduler_->next_breakpoints();
         if (bps.empty()) break;
@@ -127,8 +196,10 @@ void Debugger::eval() {
         }
 
         if (!result.empty()) {
+            std::optional<std::vector<BreakPointResponse::TraceEntry>> trace;
+            if (!run_until_done(result, trace)) continue;
             // send the breakpoint hit information
-            send_breakpoint_hit(result);
+            send_breakpoint_hit(result, std::move(trace));
             // also send any breakpoint values
             send_monitor_values(true);
             // then pause the execution
@@ -148,6 +219,7 @@ void Debugger::eval() {
 void Debugger::set_option(const std::string &name, bool value) {
     auto options = get_options();
     options.set_option(name, value);
+    update_server_options();
 }
 
 void Debugger::set_on_client_connected(
@@ -158,6 +230,8 @@ void Debugger::set_on_client_connected(
 Debugger::~Debugger() { server_thread_.join(); }
 
 void Debugger::detach() {
+    // don't pause at a run-to-time once detached
+    cancel_fast_forward();
     // remove all the clock related callback
     // depends on whether it's verilator or not
     if (rtl_->is_verilator()) {
@@ -172,8 +246,11 @@ void Debugger::detach() {
                 rtl_->remove_call_back(callback_name);
             }
         }
+        clock_callback_signals_.clear();
     }
 
+    remove_watchpoints();
+
     // set evaluation mode to normal
     if (scheduler_) scheduler_->set_evaluation_mode(Scheduler::EvaluationMode::None);
     __sync_synchronize();
@@ -192,89 +269,161 @@ void Debugger::detach() {
     log_info("Debugger runtime detached since all clients have disconnected");
 }
 
+thread_local Debugger::BatchContext *Debugger::current_batch_ = nullptr;
+
 void Debugger::on_message(const std::string &message, uint64_t conn_id) {
     // server can only receives request
-    auto req = Request::parse_request(message);
-    if (req->status() != status_code::success) {
+    std::shared_ptr<Request> req = Request::parse_request(message);
+    bool read_only = is_read_only(req->type());
+    {
+        std::lock_guard guard(pending_ordered_tasks_lock_);
+        auto pos = pending_ordered_tasks_.find(conn_id);
+        // read-only requests can't skip ahead of work still queued from the same connection
+        if (!read_only || pos != pending_ordered_tasks_.end()) {
+            pending_ordered_tasks_[conn_id]++;
+            read_only = false;
+        }
+    }
+    if (read_only) {
+        // handled right away by whichever server thread received it, so a large symbol table
+        // lookup doesn't hold up commands from other clients
+        std::shared_lock guard(symbol_table_lock_);
+        handle_request(*req, conn_id);
+        return;
+    }
+    server_->post_ordered([this, req, conn_id]() {
+        if (is_read_only(req->type())) {
+            std::shared_lock guard(symbol_table_lock_);
+            handle_request(*req, conn_id);
+        } else {
+            handle_request(*req, conn_id);
+        }
+        std::lock_guard guard(pending_ordered_tasks_lock_);
+        if (--pending_ordered_tasks_[conn_id] == 0) pending_ordered_tasks_.erase(conn_id);
+    });
+}
+
+bool Debugger::is_read_only(RequestType type) {
+    // these requests only read the symbol table and never touch the simulator
+    switch (type) {
+        case RequestType::error:
+        case RequestType::bp_location:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void Debugger::handle_request(const Request &req, uint64_t conn_id) {
+    if (req.status() != status_code::success) {
         // send back error message
-        auto resp = GenericResponse(status_code::error, *req, req->error_reason());
-        send_message(resp.str(log_enabled_), conn_id);
+        auto resp = GenericResponse(status_code::error, req, req.error_reason());
+        send_message(resp, conn_id);
         return;
     }
-    switch (req->type()) {
+    switch (req.type()) {
         case RequestType::connection: {
             // this is a connection request
-            auto *r = reinterpret_cast<ConnectionRequest *>(req.get());
+            auto *r = reinterpret_cast<const ConnectionRequest *>(&req);
             handle_connection(*r, conn_id);
             break;
         }
         case RequestType::breakpoint: {
-            auto *r = reinterpret_cast<BreakPointRequest *>(req.get());
+            auto *r = reinterpret_cast<const BreakPointRequest *>(&req);
             handle_breakpoint(*r, conn_id);
             break;
         }
         case RequestType::breakpoint_id: {
-            auto *r = reinterpret_cast<BreakPointIDRequest *>(req.get());
+            auto *r = reinterpret_cast<const BreakPointIDRequest *>(&req);
             handle_breakpoint_id(*r, conn_id);
             break;
         }
         case RequestType::bp_location: {
-            auto *r = reinterpret_cast<BreakPointLocationRequest *>(req.get());
+            auto *r = reinterpret_cast<const BreakPointLocationRequest *>(&req);
             handle_bp_location(*r, conn_id);
             break;
         }
         case RequestType::command: {
-            auto *r = reinterpret_cast<CommandRequest *>(req.get());
+            auto *r = reinterpret_cast<const CommandRequest *>(&req);
             handle_command(*r, conn_id);
             break;
         }
         case RequestType::debugger_info: {
-            auto *r = reinterpret_cast<DebuggerInformationRequest *>(req.get());
+            auto *r = reinterpret_cast<const DebuggerInformationRequest *>(&req);
             handle_debug_info(*r, conn_id);
             break;
         }
         case RequestType::path_mapping: {
-            auto *r = reinterpret_cast<PathMappingRequest *>(req.get());
+            auto *r = reinterpret_cast<const PathMappingRequest *>(&req);
             handle_path_mapping(*r, conn_id);
             break;
         }
         case RequestType::evaluation: {
-            auto *r = reinterpret_cast<EvaluationRequest *>(req.get());
+            auto *r = reinterpret_cast<const EvaluationRequest *>(&req);
             handle_evaluation(*r, conn_id);
             break;
         }
         case RequestType::option_change: {
-            auto *r = reinterpret_cast<OptionChangeRequest *>(req.get());
+            auto *r = reinterpret_cast<const OptionChangeRequest *>(&req);
             handle_option_change(*r, conn_id);
             break;
         }
         case RequestType::monitor: {
-            auto *r = reinterpret_cast<MonitorRequest *>(req.get());
+            auto *r = reinterpret_cast<const MonitorRequest *>(&req);
             handle_monitor(*r, conn_id);
             break;
         }
         case RequestType::set_value: {
-            auto *r = reinterpret_cast<SetValueRequest *>(req.get());
+            auto *r = reinterpret_cast<const SetValueRequest *>(&req);
             handle_set_value(*r, conn_id);
             break;
         }
+        case RequestType::watchpoint: {
+            auto *r = reinterpret_cast<const WatchpointRequest *>(&req);
+            handle_watchpoint(*r, conn_id);
+            break;
+        }
+        case RequestType::batch: {
+            auto *r = reinterpret_cast<const BatchRequest *>(&req);
+            handle_batch(*r, conn_id);
+            break;
+        }
+        case RequestType::variables: {
+            auto *r = reinterpret_cast<const VariablesRequest *>(&req);
+            handle_variables(*r, conn_id);
+            break;
+        }
         case RequestType::error: {
-            auto *r = reinterpret_cast<ErrorRequest *>(req.get());
+            auto *r = reinterpret_cast<const ErrorRequest *>(&req);
             handle_error(*r, conn_id);
             break;
         }
     }
 }
 
-void Debugger::send_message(const std::string &message) {
-    if (server_) {
-        server_->send(message);
+void Debugger::send_message(const Response &resp, DebugServer::MessageKind kind) {
+    if (!server_) return;
+    // only encode the formats connected clients have asked for
+    if (server_->has_text_connections()) {
+        server_->send(resp.str(log_enabled_), kind);
+    }
+    if (server_->has_binary_connections()) {
+        server_->send(resp.serialize(MessageFormat::msgpack, false), kind, true);
     }
 }
 
-void Debugger::send_message(const std::string &message, uint64_t conn_id) {
-    if (server_) {
-        server_->send(message, conn_id);
+void Debugger::send_message(const Response &resp, uint64_t conn_id) {
+    // responses to batched requests are collected and sent together
+    if (current_batch_ && current_batch_->conn_id == conn_id) {
+        auto &responses = current_batch_->responses;
+        responses.emplace_back(resp.serialize(current_batch_->format, false));
+        return;
+    }
+    if (!server_) return;
+    if (server_->is_binary(conn_id)) {
+        server_->send(resp.serialize(MessageFormat::msgpack, false), conn_id, true);
+    } else {
+        server_->send(resp.str(log_enabled_), conn_id);
     }
 }
 
@@ -323,6 +472,17 @@ bool Debugger::has_cli_flag(const std::string &flag) {
     return std::any_of(argv.begin(), argv.end(), [&flag](const auto &v) { return v == flag; });
 }
 
+std::optional<std::string> Debugger::get_cli_value(const std::string &prefix) {
+    if (!rtl_) return std::nullopt;
+    const auto &argv = rtl_->get_argv();
+    for (auto const &arg : argv) {
+        if (arg.starts_with(prefix)) {
+            return arg.substr(prefix.size());
+        }
+    }
+    return std::nullopt;
+}
+
 std::string Debugger::get_monitor_topic(uint64_t watch_id) {
     return fmt::format("watch-{0}", watch_id);
 }
@@ -372,15 +532,48 @@ PLI_INT32 eval_hgdb_on_clk(p_cb_data cb_data) {
     // only if the clock value is high
     auto value = cb_data->value->value.integer;
     if (value) {
-        auto *raw_debugger = cb_data->user_data;
-        auto *debugger = reinterpret_cast<hgdb::Debugger *>(raw_debugger);
-        debugger->eval();
+        auto *raw_data = cb_data->user_data;
+        auto *data = reinterpret_cast<hgdb::Debugger::ClockDomainCallback *>(raw_data);
+        data->debugger->eval(data->clock_domain);
     }
 
     return 0;
 }
 
+PLI_INT32 eval_hgdb_on_watchpoint(p_cb_data cb_data) {
+    // simulators are not required to pass back the handle the callback is registered with
+    auto *callback = reinterpret_cast<hgdb::Debugger::WatchpointCallback *>(cb_data->user_data);
+    callback->debugger->eval_watchpoint(callback->watchpoint_id);
+    return 0;
+}
+
+bool Debugger::add_clock_callbacks() {
+    // only trigger eval at the posedge clk
+    // each clock only evaluates breakpoints in its own clock domain
+    auto clock_signals =
+        scheduler_ ? scheduler_->clock_signals() : util::get_clock_signals(rtl_.get(), db_.get());
+    // callback data is reused across reconnections
+    for (auto i = clock_domain_callbacks_.size(); i < clock_signals.size(); i++) {
+        clock_domain_callbacks_.emplace_back(std::make_unique<ClockDomainCallback>(
+            ClockDomainCallback{.debugger = this, .clock_domain = static_cast<uint32_t>(i)}));
+    }
+    bool r = !clock_signals.empty();
+    for (auto i = 0u; i < clock_signals.size() && r; i++) {
+        r = rtl_->monitor_signals({clock_signals[i]}, eval_hgdb_on_clk,
+                                  clock_domain_callbacks_[i].get());
+        if (r) clock_callback_signals_.emplace_back(clock_signals[i]);
+    }
+    return r;
+}
+
+void Debugger::remove_clock_callbacks() {
+    rtl_->unmonitor_signals(clock_callback_signals_);
+    clock_callback_signals_.clear();
+}
+
 void Debugger::handle_connection(const ConnectionRequest &req, uint64_t conn_id) {
+    // the response is already in the requested format
+    if (server_) server_->set_binary(conn_id, req.format() == MessageFormat::msgpack);
     // if we have a debug cli flag, don't load the db
     bool success = true;
     std::string db_filename = "debug symbol table";
@@ -393,24 +586,27 @@ void Debugger::handle_connection(const ConnectionRequest &req, uint64_t conn_id)
     // if success, need to register call backs on the clocks
     // Verilator is handled differently
     if (success && rtl_ && !rtl_->is_verilator()) {
-        // only trigger eval at the posedge clk
-        auto clock_signals = util::get_clock_signals(rtl_.get(), db_.get());
-        bool r = rtl_->monitor_signals(clock_signals, eval_hgdb_on_clk, this);
-        if (!r || clock_signals.empty()) log_error("Failed to register evaluation callback");
+        // the new symbol table may order the clocks differently, so callbacks from the previous
+        // connection can't be reused
+        remove_clock_callbacks();
+        if (!add_clock_callbacks()) log_error("Failed to register evaluation callback");
     }
 
     // need to set the remap
-    if (db_) db_->set_src_mapping(req.path_mapping());
+    if (db_) {
+        std::unique_lock guard(symbol_table_lock_);
+        db_->set_src_mapping(req.path_mapping());
+    }
 
     if (success) {
         auto resp = GenericResponse(status_code::success, req);
-        send_message(resp.str(log_enabled_), conn_id);
+        send_message(resp, conn_id);
         // set running to true
         is_running_ = true;
     } else {
         auto resp = GenericResponse(status_code::error, req,
                                     fmt::format("Unable to find {0}", db_filename));
-        send_message(resp.str(log_enabled_), conn_id);
+        send_message(resp, conn_id);
     }
 
     log_info("handle_connection finished");
@@ -434,15 +630,21 @@ void Debugger::handle_breakpoint(const BreakPointRequest &req, uint64_t conn_id)
             auto error_response = GenericResponse(status_code::error, req,
                                                   fmt::format("{0}:{1} is not a valid breakpoint",
                                                               bp_info.filename, bp_info.line_num));
-            send_message(error_response.str(log_enabled_), conn_id);
+            send_message(error_response, conn_id);
             return;
         }
 
         for (auto const &bp : bps) {
-            scheduler_->add_breakpoint(bp_info, bp);
+            scheduler_->add_breakpoint(bp_info, bp, req.ignore_count(), req.hit_every());
         }
+        cancel_fast_forward(true);
 
-        scheduler_->reorder_breakpoints();
+        // batched requests only reorder once at the end
+        if (current_batch_) {
+            current_batch_->reorder_breakpoints = true;
+        } else {
+            scheduler_->reorder_breakpoints();
+        }
     } else {
         // remove
         auto bps = db_->get_breakpoints(bp_info.filename, bp_info.line_num, bp_info.column_num);
@@ -454,7 +656,7 @@ void Debugger::handle_breakpoint(const BreakPointRequest &req, uint64_t conn_id)
     }
     // tell client we're good
     auto success_resp = GenericResponse(status_code::success, req);
-    send_message(success_resp.str(log_enabled_), conn_id);
+    send_message(success_resp, conn_id);
 }
 
 void Debugger::handle_breakpoint_id(const BreakPointIDRequest &req, uint64_t conn_id) {
@@ -468,16 +670,17 @@ void Debugger::handle_breakpoint_id(const BreakPointIDRequest &req, uint64_t con
             auto error_response =
                 GenericResponse(status_code::error, req,
                                 fmt::format("BP ({0}) is not a valid breakpoint", bp_info.id));
-            send_message(error_response.str(log_enabled_), conn_id);
+            send_message(error_response, conn_id);
             return;
         }
-        scheduler_->add_breakpoint(bp_info, *bp);
+        scheduler_->add_breakpoint(bp_info, *bp, req.ignore_count(), req.hit_every());
+        cancel_fast_forward(true);
     } else {
         scheduler_->remove_breakpoint(bp_info);
     }
     // tell client we're good
     auto success_resp = GenericResponse(status_code::success, req);
-    send_message(success_resp.str(log_enabled_), conn_id);
+    send_message(success_resp, conn_id);
 }
 
 void Debugger::handle_bp_location(const BreakPointLocationRequest &req, uint64_t conn_id) {
@@ -502,21 +705,63 @@ void Debugger::handle_bp_location(const BreakPointLocationRequest &req, uint64_t
     auto resp = BreakPointLocationResponse(bps_);
     req.set_token(resp);
     // we don't do pretty print if log is not enabled
-    send_message(resp.str(log_enabled_), conn_id);
+    send_message(resp, conn_id);
 }
 
 void Debugger::handle_command(const CommandRequest &req, uint64_t conn_id) {
+    // a stop without a location can only be reported while paused. a running simulation can't
+    // go back to a time it has already passed
+    if (req.command_type() == CommandRequest::CommandType::run_to_time && !lock_.paused() &&
+        req.time() <= rtl_->get_simulation_time()) {
+        auto resp = GenericResponse(status_code::error, req,
+                                    fmt::format("Time {0} has already passed", req.time()));
+        send_message(resp, conn_id);
+        return;
+    }
     // we don't care about the response. this is just set to conform the req-resp style
     auto resp = GenericResponse(status_code::success, req);
-    send_message(resp.str(log_enabled_), conn_id);
+    send_message(resp, conn_id);
+
+    // every command replaces the ongoing fast-forward and server-side stepping
+    cancel_fast_forward();
+    {
+        std::lock_guard guard(run_until_lock_);
+        if (req.count() > 1 || !req.condition().empty() || req.trace()) {
+            run_until_ = RunUntil{.remaining = req.count(),
+                                  .condition = req.condition(),
+                                  .trace = req.trace()};
+        } else {
+            run_until_.reset();
+        }
+    }
 
     switch (req.command_type()) {
         case CommandRequest::CommandType::continue_: {
             log_info("handle_command: continue_");
             scheduler_->set_evaluation_mode(Scheduler::EvaluationMode::BreakPointOnly);
+            // nothing can trigger before the earliest time guard. monitors still need every edge
+            if (auto time = scheduler_->earliest_breakpoint_time(); time && monitor_.empty()) {
+                if (start_fast_forward(*time, false)) {
+                    log_info(fmt::format("Fast-forward to time guard {0}", *time));
+                }
+            }
             lock_.ready();
             break;
         }
+        case CommandRequest::CommandType::run_to_time: {
+            log_info(fmt::format("handle_command: run_to_time {0}", req.time()));
+            scheduler_->set_evaluation_mode(Scheduler::EvaluationMode::BreakPointOnly);
+            if (start_fast_forward(req.time(), true)) {
+                lock_.ready();
+            } else if (lock_.paused()) {
+                // already there. stay paused
+                send_message(BreakPointResponse(rtl_->get_simulation_time(), "", 0));
+            } else {
+                // the simulation moved past it after the check above
+                log_error(fmt::format("Unable to run to time {0}", req.time()));
+            }
+            break;
+        }
         case CommandRequest::CommandType::stop: {
             log_info("handle_command: stop");
             scheduler_->clear();
@@ -560,7 +805,7 @@ void Debugger::handle_debug_info(const DebuggerInformationRequest &req, uint64_t
 
             auto resp = DebuggerInformationResponse(bps_);
             req.set_token(resp);
-            send_message(resp.str(log_enabled_), conn_id);
+            send_message(resp, conn_id);
             return;
         }
         case DebuggerInformationRequest::CommandType::options: {
@@ -569,7 +814,7 @@ void Debugger::handle_debug_info(const DebuggerInformationRequest &req, uint64_t
             auto options_map = options.get_options();
             auto resp = DebuggerInformationResponse(options_map);
             req.set_token(resp);
-            send_message(resp.str(log_enabled_), conn_id);
+            send_message(resp, conn_id);
             return;
         }
         case DebuggerInformationRequest::CommandType::status: {
@@ -583,7 +828,7 @@ void Debugger::handle_debug_info(const DebuggerInformationRequest &req, uint64_t
             ss << "Simulation paused: " << (is_running_.load() ? "true" : "false") << std::endl;
             auto resp = DebuggerInformationResponse(ss.str());
             req.set_token(resp);
-            send_message(resp.str(log_enabled_), conn_id);
+            send_message(resp, conn_id);
             return;
         }
         case DebuggerInformationRequest::CommandType::design: {
@@ -592,7 +837,7 @@ void Debugger::handle_debug_info(const DebuggerInformationRequest &req, uint64_t
             auto mapping = rtl_->get_top_mapping();
             auto resp = DebuggerInformationResponse(mapping);
             req.set_token(resp);
-            send_message(resp.str(log_enabled_), conn_id);
+            send_message(resp, conn_id);
             return;
         }
     }
@@ -600,12 +845,15 @@ void Debugger::handle_debug_info(const DebuggerInformationRequest &req, uint64_t
 
 void Debugger::handle_path_mapping(const PathMappingRequest &req, uint64_t conn_id) {
     if (db_ && req.status() == status_code::success) [[likely]] {
-        db_->set_src_mapping(req.path_mapping());
+        {
+            std::unique_lock guard(symbol_table_lock_);
+            db_->set_src_mapping(req.path_mapping());
+        }
         auto resp = GenericResponse(status_code::success, req);
-        send_message(resp.str(log_enabled_), conn_id);
+        send_message(resp, conn_id);
     } else {
         auto resp = GenericResponse(status_code::error, req, req.error_reason());
-        send_message(resp.str(log_enabled_), conn_id);
+        send_message(resp, conn_id);
     }
 }
 
@@ -614,7 +862,7 @@ void Debugger::handle_evaluation(const EvaluationRequest &req, uint64_t conn_id)
     // linux kernel style error handling
     auto send_error = [&error_reason, this, &req, conn_id]() {
         auto resp = GenericResponse(status_code::error, req, error_reason);
-        send_message(resp.str(log_enabled_), conn_id);
+        send_message(resp, conn_id);
     };
 
     if (db_ && req.status() == status_code::success) [[likely]] {
@@ -643,23 +891,17 @@ void Debugger::handle_evaluation(const EvaluationRequest &req, uint64_t conn_id)
             return;
         }
 
-        std::unordered_map<std::string, int64_t> values;
-        auto const &names = expr.resolved_symbol_names();
-        for (auto const &[name, full_name] : names) {
-            auto v = get_value(full_name);
-            if (v) values.emplace(name, *v);
-        }
-
-        if (values.size() != names.size()) {
+        auto values = get_expr_values(expr);
+        if (!values) {
             error_reason = "Unable to get symbol values";
             send_error();
             return;
         }
 
-        auto value = expr.eval(values);
+        auto value = expr.eval(*values);
         EvaluationResponse eval_resp(scope, std::to_string(value));
         req.set_token(eval_resp);
-        send_message(eval_resp.str(log_enabled_), conn_id);
+        send_message(eval_resp, conn_id);
         return;
     } else {
         send_error();
@@ -668,24 +910,28 @@ void Debugger::handle_evaluation(const EvaluationRequest &req, uint64_t conn_id)
 
 void Debugger::handle_option_change(const OptionChangeRequest &req, uint64_t conn_id) {
     if (req.status() == status_code::success) {
-        auto options = get_options();
-        for (auto const &[name, value] : req.bool_values()) {
-            log_info(fmt::format("option[{0}] set to {1}", name, value));
-            options.set_option(name, value);
-        }
-        for (auto const &[name, value] : req.int_values()) {
-            log_info(fmt::format("option[{0}] set to {1}", name, value));
-            options.set_option(name, value);
-        }
-        for (auto const &[name, value] : req.str_values()) {
-            log_info(fmt::format("option[{0}] set to {1}", name, value));
-            options.set_option(name, value);
+        {
+            std::unique_lock guard(symbol_table_lock_);
+            auto options = get_options();
+            for (auto const &[name, value] : req.bool_values()) {
+                log_info(fmt::format("option[{0}] set to {1}", name, value));
+                options.set_option(name, value);
+            }
+            for (auto const &[name, value] : req.int_values()) {
+                log_info(fmt::format("option[{0}] set to {1}", name, value));
+                options.set_option(name, value);
+            }
+            for (auto const &[name, value] : req.str_values()) {
+                log_info(fmt::format("option[{0}] set to {1}", name, value));
+                options.set_option(name, value);
+            }
+            update_server_options();
         }
         auto resp = GenericResponse(status_code::success, req);
-        send_message(resp.str(log_enabled_), conn_id);
+        send_message(resp, conn_id);
     } else {
         auto resp = GenericResponse(status_code::error, req, req.error_reason());
-        send_message(resp.str(log_enabled_), conn_id);
+        send_message(resp, conn_id);
     }
 }
 
@@ -693,22 +939,50 @@ void Debugger::handle_monitor(const MonitorRequest &req, uint64_t conn_id) {
     if (req.status() == status_code::success) {
         // depends on whether it is an add or remove action
         if (req.action_type() == MonitorRequest::ActionType::add) {
-            std::optional<std::string> full_name =
-                resolve_var_name(req.var_name(), req.instance_id(), req.breakpoint_id());
-            if (!full_name) {
-                auto resp =
-                    GenericResponse(status_code::error, req, "Unable to resolve " + req.var_name());
-                send_message(resp.str(log_enabled_), conn_id);
-                return;
+            auto options = Monitor::SampleOptions{.every = req.sample_every(),
+                                                  .interval = req.sample_interval(),
+                                                  .aggregate = req.aggregate()};
+            uint64_t track_id;
+            if (req.expression()) {
+                // same scope resolution as breakpoint conditions
+                auto expr = std::make_unique<DebugExpression>(*req.expression());
+                if (expr->correct() && db_) {
+                    if (req.instance_id()) {
+                        auto instance_id = static_cast<int64_t>(*req.instance_id());
+                        expr->set_static_values({{util::instance_var_name, instance_id}});
+                    }
+                    util::validate_expr(rtl_.get(), db_.get(), expr.get(), req.breakpoint_id(),
+                                        req.instance_id());
+                }
+                if (!expr->correct() || !db_) {
+                    auto resp = GenericResponse(status_code::error, req,
+                                                "Unable to resolve " + *req.expression());
+                    send_message(resp, conn_id);
+                    return;
+                }
+                track_id =
+                    monitor_.add_monitor_expression(std::move(expr), req.monitor_type(), options);
+            } else {
+                std::optional<std::string> full_name =
+                    resolve_var_name(req.var_name(), req.instance_id(), req.breakpoint_id());
+                if (!full_name) {
+                    auto resp = GenericResponse(status_code::error, req,
+                                                "Unable to resolve " + req.var_name());
+                    send_message(resp, conn_id);
+                    return;
+                }
+                track_id = monitor_.add_monitor_variable(*full_name, req.monitor_type(), options);
             }
-            auto track_id = monitor_.add_monitor_variable(*full_name, req.monitor_type());
             auto resp = GenericResponse(status_code::success, req);
             resp.set_value("track_id", track_id);
             // add topics
             auto topic = get_monitor_topic(track_id);
             this->server_->add_to_topic(topic, conn_id);
 
-            send_message(resp.str(log_enabled_), conn_id);
+            send_message(resp, conn_id);
+            // monitors need every clock edge. resumed after the response so that the client
+            // gets the track id before any value
+            cancel_fast_forward(true);
         } else {
             // it's remove
             auto track_id = req.track_id();
@@ -719,12 +993,12 @@ void Debugger::handle_monitor(const MonitorRequest &req, uint64_t conn_id) {
             this->server_->remove_from_topic(topic, conn_id);
 
             auto resp = GenericResponse(status_code::success, req);
-            send_message(resp.str(log_enabled_), conn_id);
+            send_message(resp, conn_id);
         }
 
     } else {
         auto resp = GenericResponse(status_code::error, req, req.error_reason());
-        send_message(resp.str(log_enabled_), conn_id);
+        send_message(resp, conn_id);
     }
 }
 
@@ -737,7 +1011,7 @@ void Debugger::handle_set_value(const SetValueRequest &req, uint64_t conn_id) {
         if (!full_name) {
             auto resp =
                 GenericResponse(status_code::error, req, "Unable to resolve " + req.var_name());
-            send_message(resp.str(log_enabled_), conn_id);
+            send_message(resp, conn_id);
             return;
         }
         // need to set the value
@@ -749,40 +1023,203 @@ void Debugger::handle_set_value(const SetValueRequest &req, uint64_t conn_id) {
                 cached_signal_values_.erase(*full_name);
             }
             auto resp = GenericResponse(status_code::success, req);
-            send_message(resp.str(log_enabled_), conn_id);
+            send_message(resp, conn_id);
             return;
         } else {
             auto resp =
                 GenericResponse(status_code::error, req, "Unable to set value for " + *full_name);
-            send_message(resp.str(log_enabled_), conn_id);
+            send_message(resp, conn_id);
             return;
         }
 
     } else {
         auto resp = GenericResponse(status_code::error, req, req.error_reason());
-        send_message(resp.str(log_enabled_), conn_id);
+        send_message(resp, conn_id);
     }
 }
 
+void Debugger::handle_watchpoint(const WatchpointRequest &req, uint64_t conn_id) {
+    if (req.status() != status_code::success || !rtl_) {
+        auto resp = GenericResponse(status_code::error, req, req.error_reason());
+        send_message(resp, conn_id);
+        return;
+    }
+    // value change callbacks can only be registered or removed while the simulator thread is
+    // not using VPI
+    if (!lock_.paused()) {
+        auto resp = GenericResponse(status_code::error, req,
+                                    "Watchpoints can only be changed while paused");
+        send_message(resp, conn_id);
+        return;
+    }
+    if (req.wp_action() == WatchpointRequest::action::remove) {
+        std::lock_guard guard(watchpoints_lock_);
+        if (watchpoints_.find(req.id()) != watchpoints_.end()) {
+            rtl_->remove_call_back(fmt::format("Watchpoint {0}", req.id()));
+            watchpoints_.erase(req.id());
+        }
+        auto resp = GenericResponse(status_code::success, req);
+        send_message(resp, conn_id);
+        return;
+    }
+
+    auto send_error = [&req, conn_id, this](const std::string &reason) {
+        auto resp = GenericResponse(status_code::error, req, reason);
+        send_message(resp, conn_id);
+    };
+
+    auto full_name = resolve_var_name(req.var_name(), req.instance_id(), req.breakpoint_id());
+    auto *handle = full_name ? rtl_->get_handle(*full_name) : nullptr;
+    if (!handle) {
+        send_error("Unable to resolve " + req.var_name());
+        return;
+    }
+
+    std::unique_ptr<DebugExpression> condition;
+    if (req.condition()) {
+        condition = std::make_unique<DebugExpression>(*req.condition());
+        if (condition->correct() && db_) {
+            util::validate_expr(rtl_.get(), db_.get(), condition.get(), req.breakpoint_id(),
+                                req.instance_id());
+        }
+        if (!condition->correct() || !db_) {
+            send_error("Unable to resolve " + *req.condition());
+            return;
+        }
+    }
+
+    auto instance_id = req.instance_id();
+    if (!instance_id && req.breakpoint_id()) {
+        instance_id = db_->get_instance_id(*req.breakpoint_id());
+    }
+
+    std::lock_guard guard(watchpoints_lock_);
+    auto id = watchpoint_id_count_++;
+    auto callback = std::make_unique<WatchpointCallback>(
+        WatchpointCallback{.debugger = this, .watchpoint_id = id});
+    auto *callback_data = callback.get();
+    watchpoints_.emplace(id, Watchpoint{.var_name = req.var_name(),
+                                        .handle = handle,
+                                        .condition = std::move(condition),
+                                        .instance_id = instance_id,
+                                        .value = rtl_->get_value(handle),
+                                        .callback = std::move(callback)});
+    // the simulator only calls us when the signal changes, so watching a signal doesn't cost
+    // anything per clock cycle
+    auto *cb = rtl_->add_call_back(fmt::format("Watchpoint {0}", id), cbValueChange,
+                                   eval_hgdb_on_watchpoint, handle, callback_data);
+    if (!cb) {
+        watchpoints_.erase(id);
+        send_error("Unable to register value change callback for " + req.var_name());
+        return;
+    }
+    auto resp = GenericResponse(status_code::success, req);
+    resp.set_value("id", id);
+    send_message(resp, conn_id);
+}
+
+void Debugger::handle_batch(const BatchRequest &req, uint64_t conn_id) {
+    if (current_batch_) [[unlikely]] {
+        // not reachable from the parser
+        auto resp = GenericResponse(status_code::error, req, "Nested batch request");
+        send_message(resp, conn_id);
+        return;
+    }
+    auto format = server_ && server_->is_binary(conn_id) ? MessageFormat::msgpack
+                                                         : MessageFormat::json;
+    BatchContext batch{.conn_id = conn_id, .format = format};
+    batch.responses.reserve(req.requests().size());
+    {
+        // breakpoint changes are applied atomically with respect to the simulation
+        std::unique_lock<std::recursive_mutex> guard;
+        if (scheduler_) guard = scheduler_->lock_breakpoints();
+        current_batch_ = &batch;
+        for (auto const &r : req.requests()) {
+            handle_request(*r, conn_id);
+        }
+        current_batch_ = nullptr;
+        if (batch.reorder_breakpoints && scheduler_) scheduler_->reorder_breakpoints();
+    }
+
+    auto resp = BatchResponse(std::move(batch.responses), format);
+    req.set_token(resp);
+    send_message(resp, conn_id);
+}
+
+void Debugger::handle_variables(const VariablesRequest &req, uint64_t conn_id) {
+    if (!check_send_db_error(req.type(), conn_id)) return;
+    auto bp_id = static_cast<uint32_t>(req.breakpoint_id());
+    auto instance_id = db_->get_instance_id(req.breakpoint_id());
+    if (!instance_id) {
+        auto resp = GenericResponse(status_code::error, req,
+                                    fmt::format("Invalid breakpoint id {0}", bp_id));
+        send_message(resp, conn_id);
+        return;
+    }
+
+    std::map<std::string, std::string> values;
+    uint64_t total;
+    if (req.kind() == VariablesRequest::VariableKind::local) {
+        total = db_->get_context_variable_count(bp_id, req.prefix());
+        auto vars = db_->get_context_variables(bp_id, req.prefix(), req.offset(), req.limit());
+        for (auto const &[gen_var, var] : vars) {
+            values.emplace(gen_var.name, get_var_value(var));
+        }
+    } else {
+        auto id = static_cast<uint32_t>(*instance_id);
+        total = db_->get_generator_variable_count(id, req.prefix());
+        auto vars = db_->get_generator_variable(id, req.prefix(), req.offset(), req.limit());
+        for (auto const &[gen_var, var] : vars) {
+            values.emplace(gen_var.name, get_var_value(var));
+        }
+    }
+
+    auto resp =
+        VariablesResponse(req.breakpoint_id(), req.kind(), total, req.offset(), std::move(values));
+    req.set_token(resp);
+    send_message(resp, conn_id);
+}
+
 void Debugger::handle_error(const ErrorRequest &req, uint64_t) {}
 
-void Debugger::send_breakpoint_hit(const std::vector<const DebugBreakPoint *> &bps) {
+void Debugger::send_breakpoint_hit(
+    const std::vector<const DebugBreakPoint *> &bps,
+    std::optional<std::vector<BreakPointResponse::TraceEntry>> trace) {
     // we send it here to avoid a round trip of client asking for context and send send it
     // back
     auto const *first_bp = bps.front();
     BreakPointResponse resp(rtl_->get_simulation_time(), first_bp->filename, first_bp->line_num,
                             first_bp->column_num);
+    if (trace) resp.set_trace(std::move(*trace));
     for (auto const *bp : bps) {
         // first need to query all the values
         auto bp_id = bp->id;
-        auto generator_values = db_->get_generator_variable(bp->instance_id);
-        auto context_values = db_->get_context_variables(bp_id);
         auto bp_ptr = db_->get_breakpoint(bp_id);
         auto instance_name = db_->get_instance_name_from_bp(bp_id);
         auto instance_name_str = instance_name ? *instance_name : "";
 
         BreakPointResponse::Scope scope(bp->instance_id, instance_name_str, bp_id);
 
+        if (lazy_variables_) {
+            // only the summary is read so pausing doesn't scale with the instance size
+            auto summary_size = static_cast<uint64_t>(std::max<int64_t>(variable_summary_size_, 0));
+            scope.generator_count = db_->get_generator_variable_count(bp->instance_id);
+            scope.local_count = db_->get_context_variable_count(bp_id);
+            for (auto const &[gen_var, var] :
+                 db_->get_generator_variable(bp->instance_id, "", 0, summary_size)) {
+                scope.add_generator_value(gen_var.name, get_var_value(var));
+            }
+            for (auto const &[gen_var, var] :
+                 db_->get_context_variables(bp_id, "", 0, summary_size)) {
+                scope.add_local_value(gen_var.name, get_var_value(var));
+            }
+            resp.add_scope(scope);
+            continue;
+        }
+
+        auto generator_values = db_->get_generator_variable(bp->instance_id);
+        auto context_values = db_->get_context_variables(bp_id);
+
         using namespace std::string_literals;
         for (auto const &[gen_var, var] : generator_values) {
             std::string value_str = get_var_value(var);
@@ -798,20 +1235,23 @@ void Debugger::send_breakpoint_hit(const std::vector<const DebugBreakPoint *> &b
         resp.add_scope(scope);
     }
 
-    auto str = resp.str(log_enabled_);
-    send_message(str);
+    send_message(resp);
 }
 
 void Debugger::send_monitor_values(bool has_breakpoint) {
     //  optimize for no monitored value
     if (monitor_.empty()) [[likely]]
         return;
-    auto values = monitor_.get_watched_values(has_breakpoint);
-    for (auto const &[id, value] : values) {
-        auto topic = get_monitor_topic(id);
-        auto resp = MonitorResponse(id, value);
-        send_message(resp.str(log_enabled_));
+    // clients can't keep up and missed some deltas. send everything again
+    if (server_ && server_->monitor_message_dropped()) [[unlikely]] {
+        monitor_.resend_all();
     }
+    auto time = rtl_ ? rtl_->get_simulation_time() : 0;
+    auto values = monitor_.get_watched_values(has_breakpoint, time);
+    // nothing changed
+    if (values.empty()) return;
+    auto resp = MonitorResponse(time, std::move(values));
+    send_message(resp, DebugServer::MessageKind::monitor);
 }
 
 util::Options Debugger::get_options() {
@@ -821,9 +1261,26 @@ util::Options Debugger::get_options() {
     options.add_option("detach_after_disconnect", &detach_after_disconnect_);
     options.add_option("use_hex_str", &use_hex_str_);
     options.add_option("pause_at_posedge", &pause_at_posedge);
+    options.add_option("index_hierarchy", &index_hierarchy_);
+    options.add_option("filter_clock_edge", &filter_clock_edge_);
+    options.add_option("monitor_high_water_mark", &monitor_high_water_mark_);
+    options.add_option("monitor_overflow_policy", &monitor_overflow_policy_);
+    options.add_option("lazy_variables", &lazy_variables_);
+    options.add_option("variable_summary_size", &variable_summary_size_);
+    options.add_option("compression_threshold", &compression_threshold_);
     return options;
 }
 
+void Debugger::update_server_options() {
+    if (!server_) return;
+    auto high_water_mark = std::max<int64_t>(monitor_high_water_mark_, 0);
+    server_->set_high_water_mark(static_cast<uint64_t>(high_water_mark));
+    auto policy = monitor_overflow_policy_ == "coalesce" ? DebugServer::OverflowPolicy::coalesce
+                                                         : DebugServer::OverflowPolicy::drop;
+    server_->set_overflow_policy(policy);
+    server_->set_compression_threshold(compression_threshold_);
+}
+
 void Debugger::set_vendor_initial_options() {
     // all the options already have initial values
     // this function is used to set
@@ -841,7 +1298,7 @@ bool Debugger::check_send_db_error(RequestType type, uint64_t conn_id) {
         // need to send error response
         auto resp = GenericResponse(status_code::error, type,
                                     "Database is not initialized or is initialized incorrectly");
-        send_message(resp.str(log_enabled_), conn_id);
+        send_message(resp, conn_id);
         return false;
     }
     return true;
@@ -916,37 +1373,205 @@ std::optional<int64_t> Debugger::get_value(const std::string &signal_name) {
     }
 }
 
-void Debugger::eval_breakpoint(DebugBreakPoint *bp, std::vector<bool> &result, uint32_t index) {
-    const auto &bp_expr = scheduler_->breakpoint_only() ? bp->expr : bp->enable_expr;
-    // if not correct just always enable
-    if (!bp_expr->correct()) return;
+std::optional<std::unordered_map<std::string, int64_t>> Debugger::get_expr_values(
+    const DebugExpression &expr, const DebugBreakPoint *bp) {
     // since at this point we have checked everything, just used the resolved name
-    auto const &symbol_full_names = bp_expr->resolved_symbol_names();
     std::unordered_map<std::string, int64_t> values;
-    for (auto const &[symbol_name, full_name] : symbol_full_names) {
-        if (symbol_name == util::instance_var_name) [[unlikely]] {
+    for (auto const &[symbol_name, full_name] : expr.resolved_symbol_names()) {
+        if (bp && symbol_name == util::instance_var_name) [[unlikely]] {
             values.emplace(symbol_name, bp->instance_id);
             continue;
         }
         auto v = get_value(full_name);
-        if (!v) break;
+        if (!v) return std::nullopt;
         values.emplace(symbol_name, *v);
     }
-    if (values.size() != symbol_full_names.size()) {
+    return values;
+}
+
+bool Debugger::has_clock_posedge() {
+    // only needed for Verilator. other simulators call eval from the clock value change callback
+    if (!rtl_->is_verilator()) return true;
+    std::lock_guard guard(clock_values_lock_);
+    if (!clock_values_initialized_) {
+        // we need the symbol table to know the clocks
+        if (!db_) return true;
+        auto clock_signals = util::get_clock_signals(rtl_.get(), db_.get());
+        for (auto const &name : clock_signals) {
+            auto *handle = rtl_->get_handle(name);
+            auto value = rtl_->get_value(handle);
+            if (value) clock_values_.emplace_back(handle, *value);
+        }
+        clock_values_initialized_ = true;
+        log_info(fmt::format("Filter evaluation on {0} clock signals", clock_values_.size()));
+        // we don't know the previous values yet. if there is no clock, nothing to filter on
+        return clock_values_.empty();
+    }
+    if (clock_values_.empty()) return true;
+
+    bool posedge = false;
+    for (auto &[handle, old_value] : clock_values_) {
+        auto value = rtl_->get_value(handle);
+        if (!value) [[unlikely]] {
+            continue;
+        }
+        if (!old_value && *value) posedge = true;
+        old_value = *value;
+    }
+    return posedge;
+}
+
+void Debugger::eval_breakpoint(DebugBreakPoint *bp, std::vector<bool> &result, uint32_t index) {
+    const auto &bp_expr = scheduler_->breakpoint_only() ? bp->expr : bp->enable_expr;
+    // if not correct just always enable
+    if (!bp_expr->correct()) return;
+    auto values = get_expr_values(*bp_expr, bp);
+    if (!values) {
         // something went wrong with the querying symbol
         log_error(fmt::format("Unable to evaluate breakpoint {0}", bp->id));
     } else {
-        auto eval_result = bp_expr->eval(values);
+        auto eval_result = bp_expr->eval(*values);
         auto trigger_result = should_trigger(bp);
         if (eval_result && trigger_result) {
             // trigger a breakpoint!
-            result[index] = true;
+            result[index] = should_pause(bp);
         }
     }
 }
 
-void Debugger::start_breakpoint_evaluation() {
-    scheduler_->start_breakpoint_evaluation();
+bool Debugger::should_pause(DebugBreakPoint *bp) {
+    // hit policy only applies to user breakpoints when running forward
+    if (scheduler_->evaluation_mode() != Scheduler::EvaluationMode::BreakPointOnly) return true;
+    auto hits = bp->hit_count.fetch_add(1, std::memory_order_relaxed) + 1;
+    auto ignore_count = bp->ignore_count.load(std::memory_order_relaxed);
+    if (hits <= ignore_count) return false;
+    return (hits - ignore_count - 1) % bp->hit_every.load(std::memory_order_relaxed) == 0;
+}
+
+void Debugger::eval_watchpoint(uint64_t watchpoint_id) {
+    std::optional<WatchpointResponse> hit;
+    {
+        std::lock_guard guard(watchpoints_lock_);
+        auto pos = watchpoints_.find(watchpoint_id);
+        // removed in the meantime
+        if (pos == watchpoints_.end()) [[unlikely]]
+            return;
+        auto &wp = pos->second;
+        // simulators may call us even though the value is the same, e.g. a write with
+        // the same value
+        auto value = rtl_->get_value(wp.handle);
+        if (value == wp.value) return;
+        wp.value = value;
+        if (wp.condition && !eval_watchpoint_condition(wp)) return;
+        auto value_str = value ? std::to_string(*value) : error_value_str;
+        hit.emplace(rtl_->get_simulation_time(), watchpoint_id, wp.var_name, value_str);
+    }
+
+    send_message(*hit);
+    // pause the simulation the same way as breakpoints
+    lock_.wait();
+}
+
+bool Debugger::eval_watchpoint_condition(const Watchpoint &wp) {
+    // value change callbacks happen in the middle of a time step, so the per-edge value cache
+    // can't be used
+    std::unordered_map<std::string, int64_t> values;
+    for (auto const &[symbol_name, full_name] : wp.condition->resolved_symbol_names()) {
+        std::optional<int64_t> v;
+        if (full_name == util::time_var_name) {
+            v = static_cast<int64_t>(rtl_->get_simulation_time());
+        } else if (full_name == util::instance_var_name) {
+            if (wp.instance_id) v = static_cast<int64_t>(*wp.instance_id);
+        } else {
+            v = rtl_->get_value(full_name);
+        }
+        if (!v) return false;
+        values.emplace(symbol_name, *v);
+    }
+    return wp.condition->eval(values);
+}
+
+bool Debugger::run_until_done(const std::vector<const DebugBreakPoint *> &bps,
+                              std::optional<std::vector<BreakPointResponse::TraceEntry>> &trace) {
+    std::lock_guard guard(run_until_lock_);
+    if (!run_until_) [[likely]]
+        return true;
+    auto &run_until = *run_until_;
+    bool counted = run_until.condition.empty();
+    for (auto i = 0u; i < bps.size() && !counted; i++) {
+        counted = eval_run_until_condition(run_until, bps[i]);
+    }
+    if (counted && --run_until.remaining == 0) {
+        if (run_until.trace) {
+            trace.emplace(run_until.trace_entries.begin(), run_until.trace_entries.end());
+        }
+        run_until_.reset();
+        return true;
+    }
+
+    if (run_until.trace) {
+        if (run_until.trace_entries.size() == max_trace_size) run_until.trace_entries.pop_front();
+        run_until.trace_entries.emplace_back(BreakPointResponse::TraceEntry{
+            .time = rtl_->get_simulation_time(), .breakpoint_id = bps.front()->id});
+    }
+    return false;
+}
+
+bool Debugger::eval_run_until_condition(RunUntil &run_until, const DebugBreakPoint *bp) {
+    auto &expr = run_until.conditions[bp->id];
+    if (!expr) {
+        expr = std::make_unique<DebugExpression>(run_until.condition);
+        util::validate_expr(rtl_.get(), db_.get(), expr.get(), bp->id, bp->instance_id);
+    }
+    // symbols that don't exist in this scope never satisfy the condition
+    if (!expr->correct()) return false;
+    auto values = get_expr_values(*expr, bp);
+    return values && expr->eval(*values);
+}
+
+void Debugger::remove_watchpoints() {
+    std::lock_guard guard(watchpoints_lock_);
+    for (auto const &iter : watchpoints_) {
+        auto callback_name = fmt::format("Watchpoint {0}", iter.first);
+        log_info("Remove callback " + callback_name);
+        rtl_->remove_call_back(callback_name);
+    }
+    watchpoints_.clear();
+}
+
+bool Debugger::start_fast_forward(uint64_t time, bool pause) {
+    auto now = rtl_->get_simulation_time();
+    if (time <= now) return false;
+    std::lock_guard guard(fast_forward_lock_);
+    pause_at_wake_up_ = pause;
+    wake_up_time_ = time;
+    return true;
+}
+
+void Debugger::cancel_fast_forward(bool keep_run_to_time) {
+    std::lock_guard guard(fast_forward_lock_);
+    if (!wake_up_time_ || (keep_run_to_time && pause_at_wake_up_)) return;
+    wake_up_time_ = 0;
+}
+
+void Debugger::wake_up() {
+    bool pause;
+    {
+        std::lock_guard guard(fast_forward_lock_);
+        // cancelled
+        if (!wake_up_time_) return;
+        wake_up_time_ = 0;
+        pause = pause_at_wake_up_;
+    }
+    if (!pause) return;
+    // there is no source location to report
+    BreakPointResponse resp(rtl_->get_simulation_time(), "", 0);
+    send_message(resp);
+    lock_.wait();
+}
+
+void Debugger::start_breakpoint_evaluation(std::optional<uint32_t> clock_domain) {
+    scheduler_->start_breakpoint_evaluation(clock_domain);
     cached_signal_values_.clear();
 }
 
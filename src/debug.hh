@@ -1,5 +1,9 @@
 #ifndef HGDB_DEBUG_HH
 #define HGDB_DEBUG_HH
+#include <deque>
+#include <shared_mutex>
+
+#include "cache.hh"
 #include "eval.hh"
 #include "monitor.hh"
 #include "proto.hh"
@@ -22,7 +26,10 @@ public:
     void initialize_db(std::unique_ptr<DebugDatabaseClient> db);
     void run();
     void stop();
-    void eval();
+    // if clock domain is set, only breakpoints in that clock domain are evaluated
+    void eval(std::optional<uint32_t> clock_domain = std::nullopt);
+    // called from the value change callback of watched signals
+    void eval_watchpoint(uint64_t watchpoint_id);
 
     // some public information about the debugger
     [[maybe_unused]] [[nodiscard]] bool is_verilator();
@@ -32,6 +39,13 @@ public:
     static constexpr bool default_logging = false;
     static constexpr auto error_value_str = "ERROR";
     static constexpr auto debug_skip_db_load = "+DEBUG_NO_DB";
+    static constexpr auto debug_index_hierarchy = "+DEBUG_INDEX_HIERARCHY";
+    static constexpr auto debug_name_cache = "+DEBUG_NAME_CACHE=";
+    static constexpr auto debug_filter_clock_edge = "+DEBUG_FILTER_CLOCK_EDGE";
+    static constexpr auto debug_shm = "+DEBUG_SHM=";
+    static constexpr auto debug_server_threads = "+DEBUG_SERVER_THREADS=";
+    static constexpr int64_t default_variable_summary_size = 16;
+    static constexpr uint64_t max_trace_size = 1024;
 
     // status to expose to outside world
     [[nodiscard]] const std::atomic<bool> &is_running() const { return is_running_; }
@@ -41,6 +55,17 @@ public:
     // directly set options from function API instead of through ws
     void set_option(const std::string &name, bool value);
 
+    // user data for the per-clock evaluation callbacks
+    struct ClockDomainCallback {
+        Debugger *debugger;
+        uint32_t clock_domain;
+    };
+    // user data for the watchpoint value change callbacks
+    struct WatchpointCallback {
+        Debugger *debugger;
+        uint64_t watchpoint_id;
+    };
+
     // set callbacks
     void set_on_client_connected(const std::function<void(hgdb::DebugDatabaseClient &)> &func);
 
@@ -49,7 +74,7 @@ public:
 private:
     std::unique_ptr<RTLSimulatorClient> rtl_;
     std::unique_ptr<DebugDatabaseClient> db_;
-    std::unique_ptr<DebugServer> server_;
+    std::unique_ptr<ADebugServer> server_;
     // logging
     bool log_enabled_ = default_logging;
 
@@ -72,6 +97,67 @@ private:
     // monitor logic
     Monitor monitor_;
 
+    // callback data has to outlive the simulator callbacks
+    std::vector<std::unique_ptr<ClockDomainCallback>> clock_domain_callbacks_;
+    // clocks that currently have an evaluation callback registered
+    std::vector<std::string> clock_callback_signals_;
+
+    // data watchpoints
+    struct Watchpoint {
+        std::string var_name;
+        vpiHandle handle;
+        std::unique_ptr<DebugExpression> condition;
+        // bound to $instance in the condition
+        std::optional<uint64_t> instance_id;
+        std::optional<int64_t> value;
+        std::unique_ptr<WatchpointCallback> callback;
+    };
+    std::unordered_map<uint64_t, Watchpoint> watchpoints_;
+    std::mutex watchpoints_lock_;
+    uint64_t watchpoint_id_count_ = 0;
+
+    // batched requests. responses sent to the batch connection are collected instead
+    struct BatchContext {
+        uint64_t conn_id;
+        MessageFormat format;
+        std::vector<std::string> responses;
+        bool reorder_breakpoints = false;
+    };
+    static thread_local BatchContext *current_batch_;
+
+    // server-side stepping. stops are skipped inside eval until the command is done
+    struct RunUntil {
+        // stops left to report, counting only the ones where the condition holds
+        uint64_t remaining;
+        std::string condition;
+        // symbols are resolved in the scope of each breakpoint
+        std::unordered_map<uint32_t, std::unique_ptr<DebugExpression>> conditions;
+        bool trace;
+        // only the most recent stops are kept
+        std::deque<BreakPointResponse::TraceEntry> trace_entries;
+    };
+    std::optional<RunUntil> run_until_;
+    std::mutex run_until_lock_;
+
+    // fast-forward. eval returns right away until the wake-up time. the clock callbacks stay
+    // registered since they can only be changed safely from the simulator thread.
+    // 0 means no fast-forward
+    std::atomic<uint64_t> wake_up_time_ = 0;
+    // run-to-time pauses at the wake-up time. time-guarded breakpoints just resume evaluation
+    bool pause_at_wake_up_ = false;
+    std::mutex fast_forward_lock_;
+
+    // read-only requests run concurrently on the server threads. everything else goes through
+    // the server's ordered executor. held exclusively while the symbol table, the path mapping
+    // or the options change
+    std::shared_mutex symbol_table_lock_;
+    // number of requests per connection still queued on the ordered executor
+    std::unordered_map<uint64_t, uint64_t> pending_ordered_tasks_;
+    std::mutex pending_ordered_tasks_lock_;
+
+    // persistent name resolution cache across simulation runs
+    std::unique_ptr<NameCache> name_cache_;
+
     // options
     // if in single thread mode, instances with the same fn/ln won't be evaluated as a batch
     bool single_thread_mode_ = false;
@@ -81,13 +167,35 @@ private:
     bool use_hex_str_ = false;
     // whether to pause at clock edge
     bool pause_at_posedge = false;
+    // whether to resolve all symbol table signals in one hierarchy walk when loading the table
+    bool index_hierarchy_ = false;
+    // Verilator calls eval at every time step. whether to only evaluate at clock posedges
+    bool filter_clock_edge_ = false;
+    // outbound monitor traffic control for slow clients
+    int64_t monitor_high_water_mark_ = DebugServer::default_high_water_mark;
+    std::string monitor_overflow_policy_ = "drop";
+    // breakpoint hits only carry variable counts and the first few values. clients fetch the
+    // rest on demand with variables requests
+    bool lazy_variables_ = false;
+    int64_t variable_summary_size_ = default_variable_summary_size;
+    // messages at least this large are compressed for clients that negotiated permessage-deflate.
+    // negative disables compression
+    int64_t compression_threshold_ = DebugServer::default_compression_threshold;
+    // previous clock values used to detect posedges
+    std::vector<std::pair<vpiHandle, int64_t>> clock_values_;
+    bool clock_values_initialized_ = false;
+    std::mutex clock_values_lock_;
 
     void detach();
 
     // message handler
     void on_message(const std::string &message, uint64_t conn_id);
-    void send_message(const std::string &message);
-    void send_message(const std::string &message, uint64_t conn_id);
+    void handle_request(const Request &req, uint64_t conn_id);
+    static bool is_read_only(RequestType type);
+    // responses are serialized once per wire format in use
+    void send_message(const Response &resp,
+                      DebugServer::MessageKind kind = DebugServer::MessageKind::normal);
+    void send_message(const Response &resp, uint64_t conn_id);
 
     // helper functions
     uint16_t get_port();
@@ -95,6 +203,7 @@ private:
     static void log_error(const std::string &msg);
     void log_info(const std::string &msg) const;
     bool has_cli_flag(const std::string &flag);
+    std::optional<std::string> get_cli_value(const std::string &prefix);
     [[nodiscard]] static std::string get_monitor_topic(uint64_t watch_id);
     std::string get_var_value(const Variable &var);
     std::optional<std::string> resolve_var_name(const std::string &var_name,
@@ -113,27 +222,55 @@ private:
     void handle_option_change(const OptionChangeRequest &req, uint64_t conn_id);
     void handle_monitor(const MonitorRequest &req, uint64_t conn_id);
     void handle_set_value(const SetValueRequest &req, uint64_t conn_id);
+    void handle_watchpoint(const WatchpointRequest &req, uint64_t conn_id);
+    void handle_batch(const BatchRequest &req, uint64_t conn_id);
+    void handle_variables(const VariablesRequest &req, uint64_t conn_id);
     void handle_error(const ErrorRequest &req, uint64_t conn_id);
 
     // send functions
-    void send_breakpoint_hit(const std::vector<const DebugBreakPoint *> &bps);
+    void send_breakpoint_hit(
+        const std::vector<const DebugBreakPoint *> &bps,
+        std::optional<std::vector<BreakPointResponse::TraceEntry>> trace = std::nullopt);
     void send_monitor_values(bool has_breakpoint);
 
     // options
     [[nodiscard]] util::Options get_options();
     // used to set initial options
     void set_vendor_initial_options();
+    void update_server_options();
 
     // common checker
     bool check_send_db_error(RequestType type, uint64_t conn_id);
 
     // scheduler
     bool should_trigger(DebugBreakPoint *bp);
+    // applies the breakpoint's hit policy
+    bool should_pause(DebugBreakPoint *bp);
+    bool has_clock_posedge();
     void eval_breakpoint(DebugBreakPoint *bp, std::vector<bool> &result, uint32_t index);
-    void start_breakpoint_evaluation();
+    bool eval_watchpoint_condition(const Watchpoint &wp);
+    // false if the stop is skipped by server-side stepping
+    bool run_until_done(const std::vector<const DebugBreakPoint *> &bps,
+                        std::optional<std::vector<BreakPointResponse::TraceEntry>> &trace);
+    bool eval_run_until_condition(RunUntil &run_until, const DebugBreakPoint *bp);
+    void remove_watchpoints();
+    void start_breakpoint_evaluation(std::optional<uint32_t> clock_domain);
+    bool add_clock_callbacks();
+    void remove_clock_callbacks();
+    // returns false if the time is not in the future
+    bool start_fast_forward(uint64_t time, bool pause);
+    // new breakpoints and monitors need the clock edges before the time guard, but not before
+    // the run-to-time
+    void cancel_fast_forward(bool keep_run_to_time = false);
+    // called from eval once the wake-up time is reached
+    void wake_up();
 
     // cached wrapper
     std::optional<int64_t> get_value(const std::string &signal_name);
+    // values of all the symbols in the expression, with $instance bound to the breakpoint's
+    // instance. nullopt if any of them can't be read
+    std::optional<std::unordered_map<std::string, int64_t>> get_expr_values(
+        const DebugExpression &expr, const DebugBreakPoint *bp = nullptr);
     std::string get_full_name(uint64_t instance_id, const std::string &var_name);
 
     // callbacks
@@ -1,5 +1,7 @@
 #include "eval.hh"
 
+#include <algorithm>
+#include <limits>
 #include <stack>
 #include <tao/pegtl.hpp>
 
@@ -362,6 +364,46 @@ ExpressionType Expr::eval() const {
     return 0;
 }
 
+std::optional<int64_t> lower_bound(const Expr* node, const Expr* symbol,
+                                   const std::unordered_map<std::string, Symbol*>& symbols) {
+    auto is_constant = [&symbols](const Expr* e) {
+        if (e->op != Operator::None) return false;
+        return std::none_of(symbols.begin(), symbols.end(),
+                            [e](auto const& iter) { return iter.second == e; });
+    };
+    switch (node->op) {
+        case Operator::And: {
+            auto left = expr::lower_bound(node->left, symbol, symbols);
+            auto right = expr::lower_bound(node->right, symbol, symbols);
+            if (left && right) return std::max(*left, *right);
+            return left ? left : right;
+        }
+        case Operator::GT:
+        case Operator::GE:
+        case Operator::LT:
+        case Operator::LE:
+        case Operator::Eq: {
+            auto const *left = node->left, *right = node->right;
+            auto op = node->op;
+            // normalize to symbol op constant
+            if (right == symbol) {
+                std::swap(left, right);
+                if (op == Operator::LT) op = Operator::GT;
+                else if (op == Operator::LE) op = Operator::GE;
+                else if (op == Operator::GT) op = Operator::LT;
+                else if (op == Operator::GE) op = Operator::LE;
+            }
+            if (left != symbol || !is_constant(right)) return std::nullopt;
+            auto value = right->eval();
+            if (op == Operator::GE || op == Operator::Eq) return value;
+            if (op == Operator::GT && value < std::numeric_limits<int64_t>::max()) return value + 1;
+            return std::nullopt;
+        }
+        default:
+            return std::nullopt;
+    }
+}
+
 }  // namespace expr
 
 DebugExpression::DebugExpression(const std::string& expression) : expression_(expression) {
@@ -417,6 +459,11 @@ std::unordered_set<std::string> DebugExpression::get_required_symbols() const {
     return result;
 }
 
+std::optional<int64_t> DebugExpression::lower_bound(const std::string& symbol) const {
+    if (!correct() || symbols_.find(symbol) == symbols_.end()) return std::nullopt;
+    return expr::lower_bound(root_, symbols_.at(symbol), symbols_);
+}
+
 void DebugExpression::set_resolved_symbol_name(const std::string& name, const std::string& value) {
     if (symbols_str_.find(name) != symbols_str_.end()) {
         resolved_symbol_names_.emplace(name, value);
@@ -2,6 +2,7 @@
 #define HGDB_EVAL_HH
 
 #include <memory>
+#include <optional>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -81,6 +82,9 @@ public:
     void set_static_values(const std::unordered_map<std::string, int64_t> &static_values);
     void set_resolved_symbol_name(const std::string &name, const std::string &value);
     [[nodiscard]] auto const &resolved_symbol_names() const { return resolved_symbol_names_; }
+    // smallest value of the symbol that can make the expression true. only set if the top-level
+    // conjunction compares the symbol against a constant, e.g. $time > 42 && a
+    [[nodiscard]] std::optional<int64_t> lower_bound(const std::string &symbol) const;
 
     // no copy construction
     DebugExpression(const DebugExpression &) = delete;
@@ -12,16 +12,35 @@ Monitor::Monitor(std::function<std::optional<int64_t>(const std::string&)> get_v
     : get_value(std::move(get_value)) {}
 
 uint64_t Monitor::add_monitor_variable(const std::string& full_name, WatchType watch_type) {
+    return add_monitor_variable(full_name, watch_type, SampleOptions{});
+}
+
+uint64_t Monitor::add_monitor_variable(const std::string& full_name, WatchType watch_type,
+                                       const SampleOptions& options) {
     // we assume full name is checked already
     // need to search if we have the same name already
-    for (auto const& [id, var] : watched_variables_) {
-        if (var.full_name == full_name && var.type == watch_type) [[unlikely]] {
-            // reuse the existing ID
+    for (auto& [id, var] : watched_variables_) {
+        auto same = !var.expression && var.full_name == full_name && var.type == watch_type &&
+                    var.options == options;
+        if (same) [[unlikely]] {
+            // reuse the existing ID. the new subscriber needs the current value as well
+            var.sent = false;
             return id;
         }
     }
     watched_variables_.emplace(
-        watch_id_count_, WatchVariable{.type = watch_type, .full_name = full_name, .value = 0});
+        watch_id_count_,
+        WatchVariable{.type = watch_type, .full_name = full_name, .options = options});
+    return watch_id_count_++;
+}
+
+uint64_t Monitor::add_monitor_expression(std::unique_ptr<DebugExpression> expression,
+                                         WatchType watch_type, const SampleOptions& options) {
+    auto full_name = expression->expression();
+    watched_variables_.emplace(watch_id_count_, WatchVariable{.type = watch_type,
+                                                              .full_name = full_name,
+                                                              .options = options,
+                                                              .expression = std::move(expression)});
     return watch_id_count_++;
 }
 
@@ -31,40 +50,33 @@ void Monitor::remove_monitor_variable(uint64_t watch_id) {
     }
 }
 
-std::vector<std::pair<uint64_t, std::string>> Monitor::get_watched_values(bool has_breakpoint) {
+void Monitor::resend_all() {
+    for (auto& iter : watched_variables_) {
+        iter.second.sent = false;
+    }
+}
+
+std::vector<std::pair<uint64_t, std::string>> Monitor::get_watched_values(bool has_breakpoint,
+                                                                          uint64_t time) {
     std::vector<std::pair<uint64_t, std::string>> result;
-    // this is the maximum size
-    result.reserve(watched_variables_.size());
 
     for (auto& [watch_id, watch_var] : watched_variables_) {
         switch (watch_var.type) {
             case WatchType::breakpoint: {
                 // only if we hit a breakpoint
                 if (has_breakpoint) {
-                    auto value = get_value(watch_var.full_name);
-                    std::string str_value;
-                    if (value) {
-                        str_value = std::to_string(*value);
-                    } else {
-                        str_value = Debugger::error_value_str;
-                    }
-                    result.emplace_back(std::make_pair(watch_id, str_value));
+                    auto value = get_changed_value(watch_var, read_value(watch_var));
+                    if (value) result.emplace_back(std::make_pair(watch_id, std::move(*value)));
                 }
                 break;
             }
             case WatchType::clock_edge: {
                 // only if we are not in a breakpoint
                 if (!has_breakpoint) {
-                    auto value = get_value(watch_var.full_name);
-                    std::string str_value;
-                    if (value) {
-                        str_value = std::to_string(*value);
-                    } else {
-                        str_value = Debugger::error_value_str;
-                    }
-                    result.emplace_back(std::make_pair(watch_id, str_value));
-                    break;
+                    auto value = sample_value(watch_var, time);
+                    if (value) result.emplace_back(std::make_pair(watch_id, std::move(*value)));
                 }
+                break;
             }
         }
     }
@@ -72,6 +84,86 @@ std::vector<std::pair<uint64_t, std::string>> Monitor::get_watched_values(bool h
     return result;
 }
 
+std::optional<std::string> Monitor::sample_value(WatchVariable& watch_var, uint64_t time) {
+    auto const& options = watch_var.options;
+    if (!options.every && !options.interval) [[likely]] {
+        return get_changed_value(watch_var, read_value(watch_var));
+    }
+
+    auto& window = watch_var.window;
+    if (!window.started) {
+        window.started = true;
+        window.start_time = time;
+    }
+
+    // aggregation needs to look at every edge
+    if (options.aggregate != AggregateType::none) {
+        auto value = read_value(watch_var);
+        if (value) {
+            switch (options.aggregate) {
+                case AggregateType::min: {
+                    window.value = window.value ? std::min(*window.value, *value) : *value;
+                    break;
+                }
+                case AggregateType::max: {
+                    window.value = window.value ? std::max(*window.value, *value) : *value;
+                    break;
+                }
+                case AggregateType::last: {
+                    window.value = value;
+                    break;
+                }
+                case AggregateType::toggle: {
+                    bool toggled = window.previous && *window.previous != *value;
+                    window.value = window.value.value_or(0) + (toggled ? 1 : 0);
+                    window.previous = value;
+                    break;
+                }
+                case AggregateType::none: {
+                    break;
+                }
+            }
+        }
+    }
+
+    // only send at the end of the window
+    window.num_edges++;
+    bool window_end = options.every ? window.num_edges >= options.every
+                                    : time >= window.start_time + options.interval;
+    if (!window_end) return std::nullopt;
+
+    auto value = options.aggregate == AggregateType::none ? read_value(watch_var) : window.value;
+    window.num_edges = 0;
+    window.start_time = time;
+    window.value = std::nullopt;
+    return get_changed_value(watch_var, value);
+}
+
+std::optional<int64_t> Monitor::read_value(WatchVariable& watch_var) {
+    if (!watch_var.expression) [[likely]] {
+        return get_value(watch_var.full_name);
+    }
+    // symbol values share the same per-edge cache as normal watches
+    auto const& symbol_full_names = watch_var.expression->resolved_symbol_names();
+    std::unordered_map<std::string, int64_t> values;
+    for (auto const& [symbol_name, full_name] : symbol_full_names) {
+        auto v = get_value(full_name);
+        if (!v) return std::nullopt;
+        values.emplace(symbol_name, *v);
+    }
+    return watch_var.expression->eval(values);
+}
+
+std::optional<std::string> Monitor::get_changed_value(WatchVariable& watch_var,
+                                                      std::optional<int64_t> value) {
+    if (watch_var.sent && value == watch_var.value) [[likely]] {
+        return std::nullopt;
+    }
+    watch_var.value = value;
+    watch_var.sent = true;
+    return value ? std::to_string(*value) : Debugger::error_value_str;
+}
+
 uint64_t Monitor::num_watches(const std::string& name, WatchType type) const {
     uint64_t result = 0;
     for (auto const& iter : watched_variables_) {
@@ -3,6 +3,7 @@
 
 #include <functional>
 
+#include "eval.hh"
 #include "proto.hh"
 
 namespace hgdb {
@@ -10,14 +11,35 @@ namespace hgdb {
 class Monitor {
 public:
     using WatchType = MonitorRequest::MonitorType;
+    using AggregateType = MonitorRequest::AggregateType;
+
+    // server-side sampling for clock edge watches. the sampling window is either a number of
+    // clock edges or a simulation time interval. if neither is set, every edge is sampled
+    struct SampleOptions {
+        uint64_t every = 0;
+        uint64_t interval = 0;
+        AggregateType aggregate = AggregateType::none;
+
+        bool operator==(const SampleOptions&) const = default;
+    };
 
     Monitor();
     explicit Monitor(std::function<std::optional<int64_t>(const std::string&)> get_value);
     uint64_t add_monitor_variable(const std::string& full_name, WatchType watch_type);
+    uint64_t add_monitor_variable(const std::string& full_name, WatchType watch_type,
+                                  const SampleOptions& options);
+    // symbols in the expression need to be resolved to full RTL names already.
+    // expression watches are never shared
+    uint64_t add_monitor_expression(std::unique_ptr<DebugExpression> expression,
+                                    WatchType watch_type, const SampleOptions& options);
     void remove_monitor_variable(uint64_t watch_id);
+    // next call to get_watched_values will return every value, changed or not
+    void resend_all();
     // called every cycle
-    // compute a list of signals that need to be sent
-    std::vector<std::pair<uint64_t, std::string>> get_watched_values(bool has_breakpoint);
+    // compute a list of signals that need to be sent. only values that changed since they were
+    // last sent are returned
+    std::vector<std::pair<uint64_t, std::string>> get_watched_values(bool has_breakpoint,
+                                                                     uint64_t time = 0);
 
     [[nodiscard]] bool empty() const { return watched_variables_.empty(); }
     [[nodiscard]] uint64_t num_watches(const std::string& name, WatchType type) const;
@@ -28,12 +50,31 @@ private:
     // as a result, it needs to take these from the constructor
     std::function<std::optional<int64_t>(const std::string&)> get_value;
 
+    // fixed-size state of the current sampling window
+    struct SampleWindow {
+        uint64_t num_edges = 0;
+        uint64_t start_time = 0;
+        bool started = false;
+        std::optional<int64_t> value;     // aggregated value
+        std::optional<int64_t> previous;  // previous sample, used to count toggles
+    };
+
     struct WatchVariable {
         WatchType type;
-        std::string full_name;  // RTL name
-        int64_t value;          // actual value
+        std::string full_name;         // RTL name
+        std::optional<int64_t> value;  // last sent value. nullopt if it can't be read
+        bool sent = false;             // whether the value has been sent before
+        SampleOptions options;
+        SampleWindow window;
+        // null for signal watches
+        std::unique_ptr<DebugExpression> expression;
     };
 
+    std::optional<int64_t> read_value(WatchVariable& watch_var);
+    std::optional<std::string> sample_value(WatchVariable& watch_var, uint64_t time);
+    static std::optional<std::string> get_changed_value(WatchVariable& watch_var,
+                                                        std::optional<int64_t> value);
+
     uint64_t watch_id_count_ = 0;
     std::unordered_map<uint64_t, WatchVariable> watched_variables_;
 };
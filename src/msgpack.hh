@@ -0,0 +1,356 @@
+#ifndef HGDB_MSGPACK_HH
+#define HGDB_MSGPACK_HH
+
+// minimal MessagePack codec that speaks rapidjson's SAX handler interface, so any rapidjson
+// value can be written as MessagePack and MessagePack can be read into a rapidjson document.
+// only the types that appear in JSON are supported
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace hgdb {
+
+class MsgPackWriter {
+public:
+    MsgPackWriter() = default;
+    explicit MsgPackWriter(std::string &buffer) : buffer_(&buffer) {}
+    // writers are reused across messages to avoid reallocating the container stack
+    void Reset(std::string &buffer) {
+        buffer_ = &buffer;
+        containers_.clear();
+    }
+
+    bool Null() {
+        add_element();
+        put(0xc0);
+        return true;
+    }
+    bool Bool(bool b) {
+        add_element();
+        put(b ? 0xc3 : 0xc2);
+        return true;
+    }
+    bool Int(int i) { return Int64(i); }
+    bool Uint(unsigned u) { return Uint64(u); }
+    bool Int64(int64_t i) {
+        add_element();
+        put_int(i);
+        return true;
+    }
+    bool Uint64(uint64_t u) {
+        add_element();
+        put_uint(u);
+        return true;
+    }
+    bool Double(double d) {
+        add_element();
+        uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        put(0xcb);
+        put_be<uint64_t>(bits);
+        return true;
+    }
+    bool RawNumber(const char *str, unsigned length, bool copy = false) {
+        return String(str, length, copy);
+    }
+    bool String(const char *str, unsigned length, bool = false) {
+        add_element();
+        put_string(str, length);
+        return true;
+    }
+    // already encoded value
+    bool RawValue(const char *data, uint64_t size) {
+        add_element();
+        buffer_->append(data, size);
+        return true;
+    }
+    bool Key(const char *str, unsigned length, bool = false) {
+        containers_.back().count++;
+        put_string(str, length);
+        return true;
+    }
+    // the number of elements is only known at the end. reserve the largest header and shrink
+    // it afterwards. elements are counted here so SAX users don't have to
+    bool StartObject() { return start_container(true); }
+    bool EndObject(unsigned = 0) { return end_container(0x80, 0xde, 0xdf); }
+    bool StartArray() { return start_container(false); }
+    bool EndArray(unsigned = 0) { return end_container(0x90, 0xdc, 0xdd); }
+
+private:
+    struct Container {
+        uint64_t pos;
+        uint64_t count;
+        bool is_object;
+    };
+    std::string *buffer_ = nullptr;
+    std::vector<Container> containers_;
+
+    static constexpr uint64_t max_header_size = 5;
+
+    void put(uint8_t c) { buffer_->push_back(static_cast<char>(c)); }
+
+    template <typename T>
+    void put_be(T value) {
+        auto v = static_cast<std::make_unsigned_t<T>>(value);
+        for (auto i = static_cast<int>(sizeof(T)) - 1; i >= 0; i--) {
+            put(static_cast<uint8_t>(v >> (i * 8)));
+        }
+    }
+
+    // object members are counted by their keys
+    void add_element() {
+        if (!containers_.empty() && !containers_.back().is_object) {
+            containers_.back().count++;
+        }
+    }
+
+    void put_int(int64_t i) {
+        if (i >= 0) {
+            put_uint(static_cast<uint64_t>(i));
+        } else if (i >= -32) {
+            put(static_cast<uint8_t>(i));
+        } else if (i >= INT8_MIN) {
+            put(0xd0);
+            put_be<int8_t>(static_cast<int8_t>(i));
+        } else if (i >= INT16_MIN) {
+            put(0xd1);
+            put_be<int16_t>(static_cast<int16_t>(i));
+        } else if (i >= INT32_MIN) {
+            put(0xd2);
+            put_be<int32_t>(static_cast<int32_t>(i));
+        } else {
+            put(0xd3);
+            put_be<int64_t>(i);
+        }
+    }
+
+    void put_uint(uint64_t u) {
+        if (u < 128) {
+            put(static_cast<uint8_t>(u));
+        } else if (u <= UINT8_MAX) {
+            put(0xcc);
+            put_be<uint8_t>(static_cast<uint8_t>(u));
+        } else if (u <= UINT16_MAX) {
+            put(0xcd);
+            put_be<uint16_t>(static_cast<uint16_t>(u));
+        } else if (u <= UINT32_MAX) {
+            put(0xce);
+            put_be<uint32_t>(static_cast<uint32_t>(u));
+        } else {
+            put(0xcf);
+            put_be<uint64_t>(u);
+        }
+    }
+
+    void put_string(const char *str, unsigned length) {
+        if (length < 32) {
+            put(static_cast<uint8_t>(0xa0 | length));
+        } else if (length <= UINT8_MAX) {
+            put(0xd9);
+            put_be<uint8_t>(static_cast<uint8_t>(length));
+        } else if (length <= UINT16_MAX) {
+            put(0xda);
+            put_be<uint16_t>(static_cast<uint16_t>(length));
+        } else {
+            put(0xdb);
+            put_be<uint32_t>(length);
+        }
+        buffer_->append(str, length);
+    }
+
+    bool start_container(bool is_object) {
+        add_element();
+        containers_.emplace_back(Container{buffer_->size(), 0, is_object});
+        buffer_->append(max_header_size, '\0');
+        return true;
+    }
+
+    bool end_container(uint8_t fix, uint8_t type16, uint8_t type32) {
+        auto [pos, count, is_object] = containers_.back();
+        containers_.pop_back();
+        auto *header = reinterpret_cast<uint8_t *>(buffer_->data() + pos);
+        uint64_t header_size;
+        if (count < 16) {
+            header[0] = fix | count;
+            header_size = 1;
+        } else if (count <= UINT16_MAX) {
+            header[0] = type16;
+            header[1] = static_cast<uint8_t>(count >> 8);
+            header[2] = static_cast<uint8_t>(count);
+            header_size = 3;
+        } else {
+            header[0] = type32;
+            for (auto i = 0; i < 4; i++) {
+                header[1 + i] = static_cast<uint8_t>(count >> ((3 - i) * 8));
+            }
+            header_size = 5;
+        }
+        if (header_size < max_header_size) {
+            buffer_->erase(pos + header_size, max_header_size - header_size);
+        }
+        return true;
+    }
+};
+
+// used as a rapidjson generator, i.e. document.Populate(reader)
+class MsgPackReader {
+public:
+    MsgPackReader(const char *data, uint64_t size)
+        : data_(reinterpret_cast<const uint8_t *>(data)), size_(size) {}
+
+    template <typename Handler>
+    bool operator()(Handler &handler) {
+        error_ = !parse_value(handler, 0) || pos_ != size_;
+        return !error_;
+    }
+    // rapidjson does not flag generator failures as parse errors
+    [[nodiscard]] bool has_error() const { return error_; }
+
+    // top level requests and responses are always maps
+    static bool is_msgpack_map(const std::string &data) {
+        if (data.empty()) return false;
+        auto c = static_cast<uint8_t>(data[0]);
+        return (c & 0xf0) == 0x80 || c == 0xde || c == 0xdf;
+    }
+
+private:
+    const uint8_t *data_;
+    uint64_t size_;
+    uint64_t pos_ = 0;
+    bool error_ = false;
+
+    static constexpr uint32_t max_depth = 64;
+
+    template <typename T>
+    bool get_be(T &value) {
+        if (pos_ + sizeof(T) > size_) return false;
+        std::make_unsigned_t<T> v = 0;
+        for (auto i = 0u; i < sizeof(T); i++) {
+            v = static_cast<std::make_unsigned_t<T>>((v << 8) | data_[pos_++]);
+        }
+        value = static_cast<T>(v);
+        return true;
+    }
+
+    template <typename Handler>
+    bool parse_string(Handler &handler, uint64_t length, bool is_key) {
+        if (pos_ + length > size_) return false;
+        const auto *str = reinterpret_cast<const char *>(data_ + pos_);
+        pos_ += length;
+        auto len = static_cast<unsigned>(length);
+        return is_key ? handler.Key(str, len, true) : handler.String(str, len, true);
+    }
+
+    template <typename Handler>
+    bool parse_map(Handler &handler, uint64_t count, uint32_t depth) {
+        if (!handler.StartObject()) return false;
+        for (auto i = 0u; i < count; i++) {
+            if (!parse_value(handler, depth + 1, true)) return false;
+            if (!parse_value(handler, depth + 1)) return false;
+        }
+        return handler.EndObject(static_cast<unsigned>(count));
+    }
+
+    template <typename Handler>
+    bool parse_array(Handler &handler, uint64_t count, uint32_t depth) {
+        if (!handler.StartArray()) return false;
+        for (auto i = 0u; i < count; i++) {
+            if (!parse_value(handler, depth + 1)) return false;
+        }
+        return handler.EndArray(static_cast<unsigned>(count));
+    }
+
+    template <typename T, typename Handler>
+    bool parse_int(Handler &handler) {
+        T value;
+        if (!get_be(value)) return false;
+        if constexpr (std::is_signed_v<T>) {
+            return handler.Int64(value);
+        } else {
+            return handler.Uint64(value);
+        }
+    }
+
+    template <typename T, typename Handler>
+    bool parse_sized(Handler &handler, uint8_t type, uint32_t depth, bool is_key) {
+        T size;
+        if (!get_be(size)) return false;
+        switch (type) {
+            case 0xd9:
+            case 0xda:
+            case 0xdb:
+                return parse_string(handler, size, is_key);
+            case 0xdc:
+            case 0xdd:
+                return !is_key && parse_array(handler, size, depth);
+            default:
+                return !is_key && parse_map(handler, size, depth);
+        }
+    }
+
+    template <typename Handler>
+    bool parse_value(Handler &handler, uint32_t depth, bool is_key = false) {
+        if (pos_ >= size_ || depth > max_depth) return false;
+        auto c = data_[pos_++];
+        // keys have to be strings
+        if ((c & 0xe0) == 0xa0) return parse_string(handler, c & 0x1f, is_key);
+        if (c == 0xd9) return parse_sized<uint8_t>(handler, c, depth, is_key);
+        if (c == 0xda) return parse_sized<uint16_t>(handler, c, depth, is_key);
+        if (c == 0xdb) return parse_sized<uint32_t>(handler, c, depth, is_key);
+        if (is_key) return false;
+
+        if (c < 0x80) return handler.Uint64(c);
+        if (c >= 0xe0) return handler.Int64(static_cast<int8_t>(c));
+        if ((c & 0xf0) == 0x80) return parse_map(handler, c & 0x0f, depth);
+        if ((c & 0xf0) == 0x90) return parse_array(handler, c & 0x0f, depth);
+        switch (c) {
+            case 0xc0:
+                return handler.Null();
+            case 0xc2:
+                return handler.Bool(false);
+            case 0xc3:
+                return handler.Bool(true);
+            case 0xcb: {
+                uint64_t bits;
+                if (!get_be(bits)) return false;
+                double d;
+                std::memcpy(&d, &bits, sizeof(d));
+                return handler.Double(d);
+            }
+            case 0xcc:
+                return parse_int<uint8_t>(handler);
+            case 0xcd:
+                return parse_int<uint16_t>(handler);
+            case 0xce:
+                return parse_int<uint32_t>(handler);
+            case 0xcf:
+                return parse_int<uint64_t>(handler);
+            case 0xd0:
+                return parse_int<int8_t>(handler);
+            case 0xd1:
+                return parse_int<int16_t>(handler);
+            case 0xd2:
+                return parse_int<int32_t>(handler);
+            case 0xd3:
+                return parse_int<int64_t>(handler);
+            case 0xdc:
+                return parse_sized<uint16_t>(handler, c, depth, false);
+            case 0xdd:
+                return parse_sized<uint32_t>(handler, c, depth, false);
+            case 0xde:
+                return parse_sized<uint16_t>(handler, c, depth, false);
+            case 0xdf:
+                return parse_sized<uint32_t>(handler, c, depth, false);
+            default:
+                // binary, ext and float32 are never produced by hgdb
+                return false;
+        }
+    }
+};
+
+}  // namespace hgdb
+
+#endif  // HGDB_MSGPACK_HH
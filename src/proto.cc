@@ -2,8 +2,11 @@
 
 #include <fmt/format.h>
 
+#include <array>
+#include <string_view>
 #include <utility>
 
+#include "msgpack.hh"
 #include "rapidjson/document.h"
 #include "rapidjson/prettywriter.h"
 #include "rapidjson/stringbuffer.h"
@@ -21,6 +24,11 @@ namespace hgdb {
  * payload: [required] - object
  * token: [optional] - string -> used to identify a unique request/response
  *
+ * Messages are JSON text frames by default. If the client sets "protocol" to "msgpack" in the
+ * connection request, all messages sent to that client are MessagePack binary frames with the
+ * same structure. Requests can be sent in either format; MessagePack requests are detected by
+ * the leading map marker
+ *
  * Response structure
  * request: false
  * type: [required] - string
@@ -50,6 +58,7 @@ namespace hgdb {
  * payload:
  *     db_filename: [required] - string
  *     path-mapping: [optional] - map<string, string>
+ *     protocol: [optional] - [enum] string (json/msgpack) - wire format of messages sent back
  *
  *
  * Breakpoint Location Request
@@ -91,10 +100,16 @@ namespace hgdb {
  * payload:
  *      action: [required] - [enum] string (add/remove)
  *      monitor_type: [required for add] - [enum] string
- *      var_name: [required for add] - string
+ *      var_name: [required for add unless expression is set] - string
+ *      expression: [optional] - string - evaluated in the instance or breakpoint scope
  *      instance_id: [optional] - uint64_t
  *      breakpoint_id: [optional] - uint64_t
  *      track_id: [required for remove] - uint64_t
+ *      # optional sampling for clock_edge monitors. at most one of them can be set
+ *      sample_every: [optional] - uint64_t - sample every N clock edges
+ *      sample_interval: [optional] - uint64_t - sample every T time units
+ *      # aggregate all edges in a sampling window. requires sample_every or sample_interval
+ *      aggregate: [optional] - [enum] string (min/max/last/toggle)
  * # notice that add request will get track_id in the generic response. clients are required
  * # to parse the value and use that as tracking id
  *
@@ -107,6 +122,34 @@ namespace hgdb {
  *     breakpoint_id: [optional] - uint64_t
  * # instance_id and breakpoint_id can be used to scope var_name
  *
+ * Watchpoint Request
+ * type: watchpoint
+ * payload:
+ *     action: [required] - [enum] string (add/remove)
+ *     var_name: [required for add] - string
+ *     condition: [optional] - string - checked after every value change
+ *     instance_id: [optional] - uint64_t
+ *     breakpoint_id: [optional] - uint64_t
+ *     id: [required for remove] - uint64_t
+ * # add request will get the watchpoint id in the generic response
+ *
+ * Batch Request
+ * type: batch
+ * payload:
+ *     requests: [required] - Array: requests with the same structure as above
+ * # sub-requests are handled in order and answered by a single batch response. nested batch
+ * # requests are not allowed
+ *
+ * Variables Request
+ * type: variables
+ * payload:
+ *     breakpoint_id: [required] - uint64_t - breakpoint id of the instance in the hit
+ *     kind: [required] - [enum] string (local/generator)
+ *     prefix: [optional] - string - only variables whose names start with the prefix
+ *     offset: [optional] - uint64_t
+ *     limit: [optional] - uint64_t - default to 100
+ * # variables are ordered by name
+ *
  *
  * Generic Response
  * type: generic
@@ -140,6 +183,11 @@ namespace hgdb {
  *         breakpoint_id: uint64_t
  *         local: map<string, string> - name -> value
  *         generator: Array: map<string, string> - name -> value
+ *         # only exist if lazy_variables is on. local and generator then only hold the first
+ *         # variable_summary_size variables ordered by name, the rest is fetched with
+ *         # variables requests
+ *         local_count: uint64_t
+ *         generator_count: uint64_t
  *
  *
  * Debugger Information Response
@@ -157,14 +205,40 @@ namespace hgdb {
  *
  * Monitor Response
  * type: monitor
+ * # only values changed since they were last sent are included
+ * payload:
+ *     time: uint64_t
+ *     values: Array:
+ *         track_id: uint64_t
+ *         value: string
+ *
+ * Watchpoint Response
+ * type: watchpoint
+ * payload:
+ *     time: uint64_t
+ *     id: uint64_t
+ *     var_name: string
+ *     value: string
+ *
+ * Variables Response
+ * type: variables
  * payload:
- *     track_id: uint64_t
- *     value: uint64_t
+ *     breakpoint_id: uint64_t
+ *     kind: [enum] string (local/generator)
+ *     total: uint64_t - number of variables matching the prefix
+ *     offset: uint64_t
+ *     values: map<string, string> - name -> value
+ *
+ * Batch Response
+ * type: batch
+ * payload:
+ *     responses: Array: responses to the sub-requests in order, each with its own status and
+ *                token
  *
  */
 
-static bool check_member(rapidjson::Document &document, const char *member_name, std::string &error,
-                         bool set_error = true) {
+static bool check_member(const rapidjson::Value &document, const char *member_name,
+                         std::string &error, bool set_error = true) {
     if (!document.HasMember(member_name)) {
         if (set_error) error = fmt::format("Unable to find member {0}", member_name);
         return false;
@@ -173,7 +247,7 @@ static bool check_member(rapidjson::Document &document, const char *member_name,
 }
 
 template <typename T>
-static std::optional<T> get_member(rapidjson::Document &document, const char *member_name,
+static std::optional<T> get_member(const rapidjson::Value &document, const char *member_name,
                                    std::string &error, bool set_error = true,
                                    bool check_type = true) {
     if (!check_member(document, member_name, error, set_error)) return std::nullopt;
@@ -239,6 +313,12 @@ std::string to_string(RequestType type) noexcept {
             return "monitor";
         case RequestType::set_value:
             return "set-value";
+        case RequestType::watchpoint:
+            return "watchpoint";
+        case RequestType::batch:
+            return "batch";
+        case RequestType::variables:
+            return "variables";
     }
     return "error";
 }
@@ -251,148 +331,246 @@ GenericResponse::GenericResponse(status_code status, const Request &req, std::st
 GenericResponse::GenericResponse(status_code status, RequestType type, std::string reason)
     : Response(status), request_type_(to_string(type)), reason_(std::move(reason)) {}
 
-template <typename T, typename K, typename A>
-void set_member(K &json_value, A &allocator, const char *name, const T &value) {
-    rapidjson::Value key(name, allocator);  // NOLINT
-    if constexpr (std::is_same<T, std::string>::value) {
-        rapidjson::Value v(value.c_str(), allocator);
-        json_value.AddMember(key, v, allocator);
-    } else if constexpr (std::is_integral<T>::value) {
-        json_value.AddMember(key.Move(), value, allocator);
-    } else if constexpr (std::is_same<T, rapidjson::Value>::value) {
-        rapidjson::Value v_copy(value, allocator);
-        json_value.AddMember(key.Move(), v_copy.Move(), allocator);
-    } else if constexpr (std::is_same<T, std::map<std::string, std::string>>::value) {
-        rapidjson::Value v(rapidjson::kObjectType);
-        for (auto const &[name, value_] : value) {
-            set_member(v, allocator, name.c_str(), value_);
+// rapidjson output stream that appends to a std::string
+class StringOutputStream {
+public:
+    using Ch = char;
+
+    void reset(std::string &buffer) { buffer_ = &buffer; }
+    void Put(char c) { buffer_->push_back(c); }
+    void Flush() {}
+
+private:
+    std::string *buffer_ = nullptr;
+};
+
+// format independent SAX interface used by the responses
+class ResponseWriter {
+public:
+    virtual ~ResponseWriter() = default;
+
+    virtual void start_object() = 0;
+    virtual void end_object() = 0;
+    virtual void start_array() = 0;
+    virtual void end_array() = 0;
+    virtual void key(std::string_view name) = 0;
+    virtual void value(std::string_view value) = 0;
+    virtual void value(uint64_t value) = 0;
+    virtual void value(int64_t value) = 0;
+    virtual void value(bool value) = 0;
+    // already serialized value in the given format
+    virtual void raw_value(std::string_view value, MessageFormat format) = 0;
+
+    template <typename T>
+    void member(std::string_view name, const T &v) {
+        key(name);
+        if constexpr (std::is_same<T, bool>::value) {
+            value(v);
+        } else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+            value(static_cast<int64_t>(v));
+        } else if constexpr (std::is_integral<T>::value) {
+            value(static_cast<uint64_t>(v));
+        } else if constexpr (std::is_same<T, std::map<std::string, std::string>>::value) {
+            start_object();
+            for (auto const &[k, str] : v) {
+                member(k, str);
+            }
+            end_object();
+        } else {
+            value(std::string_view(v));
         }
-        json_value.AddMember(key.Move(), v.Move(), allocator);
-    } else {
-        throw std::runtime_error(fmt::format("Unable type for {0}", name));
     }
+};
+
+template <typename Writer>
+class ResponseWriterImpl : public ResponseWriter {
+public:
+    explicit ResponseWriterImpl(Writer &writer) : writer_(writer) {}
+
+    void start_object() override { writer_.StartObject(); }
+    void end_object() override { writer_.EndObject(); }
+    void start_array() override { writer_.StartArray(); }
+    void end_array() override { writer_.EndArray(); }
+    void key(std::string_view name) override {
+        writer_.Key(name.data(), static_cast<rapidjson::SizeType>(name.size()));
+    }
+    void value(std::string_view value) override {
+        writer_.String(value.data(), static_cast<rapidjson::SizeType>(value.size()));
+    }
+    void value(uint64_t value) override { writer_.Uint64(value); }
+    void value(int64_t value) override { writer_.Int64(value); }
+    void value(bool value) override { writer_.Bool(value); }
+    void raw_value(std::string_view value, MessageFormat format) override {
+        if constexpr (std::is_same<Writer, MsgPackWriter>::value) {
+            if (format == MessageFormat::msgpack) {
+                writer_.RawValue(value.data(), value.size());
+            } else {
+                auto v = json_to_msgpack(std::string(value));
+                writer_.RawValue(v.data(), v.size());
+            }
+        } else {
+            if (format == MessageFormat::json) {
+                writer_.RawValue(value.data(), value.size(), rapidjson::kObjectType);
+            } else {
+                auto v = msgpack_to_json(std::string(value));
+                if (v) {
+                    writer_.RawValue(v->data(), v->size(), rapidjson::kObjectType);
+                } else {
+                    writer_.Null();
+                }
+            }
+        }
+    }
+
+private:
+    Writer &writer_;
+};
+
+// per-thread writers. they are reset for every message, which keeps their internal stacks
+// allocated
+struct SerializeContext {
+    StringOutputStream stream;
+    rapidjson::Writer<StringOutputStream> json{stream};
+    rapidjson::PrettyWriter<StringOutputStream> pretty_json{stream};
+    MsgPackWriter msgpack;
+};
+
+std::string Response::serialize(MessageFormat format, bool pretty_print) const {
+    thread_local std::string buffer;
+    buffer.clear();
+    serialize(buffer, format, pretty_print);
+    // the buffer keeps its capacity, so the copy is the only allocation
+    return buffer;
 }
 
-template <typename T>
-void set_member(rapidjson::Document &document, const char *name, const T &value) {
-    auto &allocator = document.GetAllocator();
-    set_member(document, allocator, name, value);
+void Response::serialize(std::string &buffer, MessageFormat format, bool pretty_print) const {
+    thread_local SerializeContext context;
+    auto write = [this](auto &writer) {
+        ResponseWriterImpl w(writer);
+        w.start_object();
+        w.member("request", false);
+        w.member("type", type());
+        if (!token_.empty()) {
+            w.member("token", token_);
+        }
+        w.member("status", status_ == status_code::success ? "success" : "error");
+        w.key("payload");
+        write_payload(w);
+        w.end_object();
+    };
+
+    if (format == MessageFormat::msgpack) {
+        context.msgpack.Reset(buffer);
+        write(context.msgpack);
+        return;
+    }
+    context.stream.reset(buffer);
+    if (pretty_print) {
+        context.pretty_json.Reset(context.stream);
+        write(context.pretty_json);
+    } else {
+        context.json.Reset(context.stream);
+        write(context.json);
+    }
 }
 
-void set_status(rapidjson::Document &document, status_code status) {
-    std::string status_str = status == status_code::success ? "success" : "error";
-    set_member(document, "status", status_str);
+std::string json_to_msgpack(const std::string &json) {
+    // convert the token stream directly
+    std::string result;
+    MsgPackWriter writer(result);
+    rapidjson::Reader reader;
+    rapidjson::StringStream stream(json.c_str());
+    if (!reader.Parse(stream, writer)) return {};
+    return result;
 }
 
-std::string to_string(rapidjson::Document &document, bool pretty_print) {
+std::optional<std::string> msgpack_to_json(const std::string &data, bool pretty_print) {
     using namespace rapidjson;
+    MsgPackReader reader(data.data(), data.size());
     StringBuffer buffer;
+    bool success;
     if (pretty_print) {
         PrettyWriter w(buffer);
-        document.Accept(w);
+        success = reader(w);
     } else {
         Writer w(buffer);
-        document.Accept(w);
-    }
-    const auto *s = buffer.GetString();
-    return s;
-}
-
-void set_response_header(rapidjson::Document &document, const Response *response) {
-    set_member(document, "request", false);
-    set_member(document, "type", response->type());
-    if (!response->token().empty()) {
-        set_member(document, "token", response->token());
+        success = reader(w);
     }
+    if (!success) return std::nullopt;
+    return buffer.GetString();
 }
 
-std::string GenericResponse::str(bool pretty_print) const {
-    using namespace rapidjson;
-    Document document(rapidjson::kObjectType);
-    auto &allocator = document.GetAllocator();
-    set_response_header(document, this);
-    set_status(document, status_);
-
-    // payload
-    Value payload(kObjectType);
-    set_member(payload, allocator, "request-type", request_type_);
+void GenericResponse::write_payload(ResponseWriter &writer) const {
+    writer.start_object();
+    writer.member("request-type", request_type_);
 
     if (status_ == status_code::error) [[unlikely]] {
-        set_member(payload, allocator, "reason", reason_);
+        writer.member("reason", reason_);
     }
     for (auto const &[name, value] : bool_values_) {
-        set_member(payload, allocator, name.c_str(), value);
+        writer.member(name, value);
     }
     for (auto const &[name, value] : int_values_) {
-        set_member(payload, allocator, name.c_str(), value);
+        writer.member(name, value);
     }
     for (auto const &[name, value] : string_values_) {
-        set_member(payload, allocator, name.c_str(), value);
+        writer.member(name, value);
     }
-
-    set_member(document, "payload", payload);
-
-    return to_string(document, pretty_print);
+    writer.end_object();
 }
 
-std::string BreakPointLocationResponse::str(bool pretty_print) const {
-    using namespace rapidjson;
-    Document document(rapidjson::kObjectType);
-    auto &allocator = document.GetAllocator();
-    set_response_header(document, this);
-    set_status(document, status_);
-
-    // set an array of elements
-    Value values(kArrayType);
-
+void BreakPointLocationResponse::write_payload(ResponseWriter &writer) const {
+    // an array of elements
+    writer.start_array();
     for (auto const &bp_p : bps_) {
         auto &bp = *bp_p;
-        Value value(kObjectType);
-        set_member(value, allocator, "id", bp.id);
-        set_member(value, allocator, "filename", bp.filename);
-        set_member(value, allocator, "line_num", bp.line_num);
-        set_member(value, allocator, "column_num", bp.column_num);
-        values.PushBack(value.Move(), allocator);
+        writer.start_object();
+        writer.member("id", bp.id);
+        writer.member("filename", bp.filename);
+        writer.member("line_num", bp.line_num);
+        writer.member("column_num", bp.column_num);
+        writer.end_object();
     }
-    set_member(document, "payload", values);
-
-    return to_string(document, pretty_print);
+    writer.end_array();
 }
 
 BreakPointResponse::BreakPointResponse(uint64_t time, std::string filename, uint64_t line_num,
                                        uint64_t column_num)
     : time_(time), filename_(std::move(filename)), line_num_(line_num), column_num_(column_num) {}
 
-std::string BreakPointResponse::str(bool pretty_print) const {
-    using namespace rapidjson;
-    Document document(rapidjson::kObjectType);
-    auto &allocator = document.GetAllocator();
-    set_response_header(document, this);
-    set_status(document, status_);
-
-    Value payload(kObjectType);
-    set_member(payload, allocator, "time", time_);
-    set_member(payload, allocator, "filename", filename_);
-    set_member(payload, allocator, "line_num", line_num_);
-    set_member(payload, allocator, "column_num", column_num_);
-
-    Value instances(kArrayType);
-    for (auto const &scope : scopes_) {
-        Value entry(kObjectType);
-
-        set_member(entry, allocator, "instance_id", scope.instance_id);
-        set_member(entry, allocator, "instance_name", scope.instance_name);
-        set_member(entry, allocator, "breakpoint_id", scope.breakpoint_id);
-        set_member(entry, allocator, "local", scope.local_values);
-        set_member(entry, allocator, "generator", scope.generator_values);
+void BreakPointResponse::write_payload(ResponseWriter &writer) const {
+    writer.start_object();
+    writer.member("time", time_);
+    writer.member("filename", filename_);
+    writer.member("line_num", line_num_);
+    writer.member("column_num", column_num_);
 
-        instances.PushBack(entry, allocator);
+    writer.key("instances");
+    writer.start_array();
+    for (auto const &scope : scopes_) {
+        writer.start_object();
+        writer.member("instance_id", scope.instance_id);
+        writer.member("instance_name", scope.instance_name);
+        writer.member("breakpoint_id", scope.breakpoint_id);
+        writer.member("local", scope.local_values);
+        writer.member("generator", scope.generator_values);
+        if (scope.local_count) writer.member("local_count", *scope.local_count);
+        if (scope.generator_count) writer.member("generator_count", *scope.generator_count);
+        writer.end_object();
     }
-    set_member(payload, allocator, "instances", instances);
-
-    set_member(document, "payload", payload);
-
-    return to_string(document, pretty_print);
+    writer.end_array();
+    if (trace_) {
+        writer.key("trace");
+        writer.start_array();
+        for (auto const &entry : *trace_) {
+            writer.start_object();
+            writer.member("time", entry.time);
+            writer.member("breakpoint_id", entry.breakpoint_id);
+            writer.end_object();
+        }
+        writer.end_array();
+    }
+    writer.end_object();
 }
 
 BreakPointResponse::Scope::Scope(uint64_t instance_id, std::string instance_name,
@@ -425,60 +603,53 @@ DebuggerInformationResponse::DebuggerInformationResponse(
     std::unordered_map<std::string, std::string> design)
     : command_type_(DebuggerInformationRequest::CommandType::design), design_(std::move(design)) {}
 
-std::string DebuggerInformationResponse::str(bool pretty_print) const {
-    using namespace rapidjson;
-    Document document(rapidjson::kObjectType);  // NOLINT
-    auto &allocator = document.GetAllocator();
-    set_response_header(document, this);
-    set_status(document, status_);
-
-    Value payload(kObjectType);
-    set_member(payload, allocator, "command", get_command_str());
+void DebuggerInformationResponse::write_payload(ResponseWriter &writer) const {
+    writer.start_object();
+    writer.member("command", get_command_str());
 
     switch (command_type_) {
         case DebuggerInformationRequest::CommandType::breakpoints: {
-            Value array(kArrayType);
+            writer.key("breakpoints");
+            writer.start_array();
             for (auto *bp : bps_) {
-                Value entry(kObjectType);
-                set_member(entry, allocator, "id", bp->id);
-                set_member(entry, allocator, "filename", bp->filename);
-                set_member(entry, allocator, "line_num", bp->line_num);
-                set_member(entry, allocator, "column_num", bp->column_num);
-                array.PushBack(entry, allocator);
+                writer.start_object();
+                writer.member("id", bp->id);
+                writer.member("filename", bp->filename);
+                writer.member("line_num", bp->line_num);
+                writer.member("column_num", bp->column_num);
+                writer.end_object();
             }
-            set_member(payload, allocator, "breakpoints", array);
+            writer.end_array();
             break;
         }
         case DebuggerInformationRequest::CommandType::options: {
-            Value v(kObjectType);
+            writer.key("options");
+            writer.start_object();
             for (auto const &[key, value] : options_) {
                 if (value == "true" || value == "false") {
-                    set_member(v, allocator, key.c_str(), value == "true");
+                    writer.member(key, value == "true");
                 } else if (std::all_of(value.begin(), value.end(), isdigit)) {
                     int64_t i = std::stoll(value);
-                    set_member(v, allocator, key.c_str(), i);
+                    writer.member(key, i);
                 } else {
-                    set_member(v, allocator, key.c_str(), value);
+                    writer.member(key, value);
                 }
             }
-            set_member(payload, allocator, "options", v);
+            writer.end_object();
             break;
         }
         case DebuggerInformationRequest::CommandType::status: {
-            set_member(payload, allocator, "status", status_str_);
+            writer.member("status", status_str_);
             break;
         }
         case DebuggerInformationRequest::CommandType::design: {
             // make it ordered here
             auto design = std::map<std::string, std::string>(design_.begin(), design_.end());
-            set_member(payload, allocator, "design", design);
+            writer.member("design", design);
             break;
         }
     }
-
-    set_member(document, "payload", payload);
-
-    return to_string(document, pretty_print);
+    writer.end_object();
 }
 
 std::string DebuggerInformationResponse::get_command_str() const {
@@ -502,48 +673,159 @@ std::string DebuggerInformationResponse::get_command_str() const {
 EvaluationResponse::EvaluationResponse(std::string scope, std::string result)
     : scope_(std::move(scope)), result_(std::move(result)) {}
 
-std::string EvaluationResponse::str(bool pretty_print) const {
-    using namespace rapidjson;
-    Document document(rapidjson::kObjectType);  // NOLINT
-    auto &allocator = document.GetAllocator();
-    set_response_header(document, this);
-    set_status(document, status_);
+void EvaluationResponse::write_payload(ResponseWriter &writer) const {
+    writer.start_object();
+    writer.member("scope", scope_);
+    writer.member("result", result_);
+    writer.end_object();
+}
 
-    Value payload(kObjectType);
-    set_member(payload, allocator, "scope", scope_);
-    set_member(payload, allocator, "result", result_);
+MonitorResponse::MonitorResponse(uint64_t time,
+                                 std::vector<std::pair<uint64_t, std::string>> values)
+    : time_(time), values_(std::move(values)) {}
+
+void MonitorResponse::write_payload(ResponseWriter &writer) const {
+    writer.start_object();
+    writer.member("time", time_);
+    writer.key("values");
+    writer.start_array();
+    for (auto const &[track_id, value] : values_) {
+        writer.start_object();
+        writer.member("track_id", track_id);
+        writer.member("value", value);
+        writer.end_object();
+    }
+    writer.end_array();
+    writer.end_object();
+}
 
-    set_member(document, "payload", payload);
+WatchpointResponse::WatchpointResponse(uint64_t time, uint64_t id, std::string var_name,
+                                       std::string value)
+    : time_(time), id_(id), var_name_(std::move(var_name)), value_(std::move(value)) {}
+
+void WatchpointResponse::write_payload(ResponseWriter &writer) const {
+    writer.start_object();
+    writer.member("time", time_);
+    writer.member("id", id_);
+    writer.member("var_name", var_name_);
+    writer.member("value", value_);
+    writer.end_object();
+}
 
-    return to_string(document, pretty_print);
+VariablesResponse::VariablesResponse(uint64_t breakpoint_id,
+                                     VariablesRequest::VariableKind kind, uint64_t total,
+                                     uint64_t offset, std::map<std::string, std::string> values)
+    : breakpoint_id_(breakpoint_id),
+      kind_(kind),
+      total_(total),
+      offset_(offset),
+      values_(std::move(values)) {}
+
+void VariablesResponse::write_payload(ResponseWriter &writer) const {
+    writer.start_object();
+    writer.member("breakpoint_id", breakpoint_id_);
+    writer.member("kind",
+                  kind_ == VariablesRequest::VariableKind::local ? "local" : "generator");
+    writer.member("total", total_);
+    writer.member("offset", offset_);
+    writer.member("values", values_);
+    writer.end_object();
 }
 
-MonitorResponse::MonitorResponse(uint64_t track_id, std::string value)
-    : track_id_(track_id), value_(std::move(value)) {}
+BatchResponse::BatchResponse(std::vector<std::string> responses, MessageFormat format)
+    : responses_(std::move(responses)), format_(format) {}
 
-std::string MonitorResponse::str(bool pretty_print) const {
-    using namespace rapidjson;
-    Document document(rapidjson::kObjectType);  // NOLINT
-    auto &allocator = document.GetAllocator();
-    set_response_header(document, this);
-    set_status(document, status_);
+void BatchResponse::write_payload(ResponseWriter &writer) const {
+    writer.start_object();
+    writer.key("responses");
+    writer.start_array();
+    for (auto const &response : responses_) {
+        writer.raw_value(response, format_);
+    }
+    writer.end_array();
+    writer.end_object();
+}
 
-    Value payload(kObjectType);
-    set_member(payload, allocator, "track_id", track_id_);
-    set_member(payload, allocator, "value", value_);
+// inbound messages are parsed in-situ into per-thread memory pools, so steady-state parsing
+// doesn't touch the heap. the pools are reset once the document is done
+struct ParsePool {
+    static constexpr uint64_t value_buffer_size = 64 * 1024;
+    static constexpr uint64_t stack_buffer_size = 16 * 1024;
+
+    std::array<char, value_buffer_size> value_buffer;
+    std::array<char, stack_buffer_size> stack_buffer;
+    rapidjson::MemoryPoolAllocator<> value_allocator{value_buffer.data(), value_buffer.size()};
+    rapidjson::MemoryPoolAllocator<> stack_allocator{stack_buffer.data(), stack_buffer.size()};
+    // in-situ parsing modifies the input
+    std::string input;
+    bool in_use = false;
+};
+
+class PooledDocument {
+public:
+    using Document = rapidjson::GenericDocument<rapidjson::UTF8<>, rapidjson::MemoryPoolAllocator<>,
+                                                rapidjson::MemoryPoolAllocator<>>;
+
+    PooledDocument() {
+        thread_local auto pool = std::make_unique<ParsePool>();
+        if (pool->in_use) [[unlikely]] {
+            // nested parsing gets its own pool
+            owned_pool_ = std::make_unique<ParsePool>();
+            pool_ = owned_pool_.get();
+        } else {
+            pool_ = pool.get();
+        }
+        pool_->in_use = true;
+        document_.emplace(&pool_->value_allocator, stack_capacity, &pool_->stack_allocator);
+    }
 
-    set_member(document, "payload", payload);
+    ~PooledDocument() {
+        document_.reset();
+        pool_->value_allocator.Clear();
+        pool_->stack_allocator.Clear();
+        pool_->in_use = false;
+    }
 
-    return to_string(document, pretty_print);
-}
+    PooledDocument(const PooledDocument &) = delete;
+    PooledDocument &operator=(const PooledDocument &) = delete;
+
+    Document &operator*() { return *document_; }
+    Document *operator->() { return &(*document_); }
+
+    char *copy_input(const std::string &str) {
+        pool_->input.assign(str);
+        return pool_->input.data();
+    }
+
+private:
+    static constexpr uint64_t stack_capacity = 1024;
+
+    ParsePool *pool_;
+    std::unique_ptr<ParsePool> owned_pool_;
+    std::optional<Document> document_;
+};
 
 std::unique_ptr<Request> Request::parse_request(const std::string &str) {
-    using namespace rapidjson;
-    Document document;
-    document.Parse(str.c_str());
+    PooledDocument pooled_document;
+    auto &document = *pooled_document;
+    if (MsgPackReader::is_msgpack_map(str)) {
+        MsgPackReader reader(str.data(), str.size());
+        document.Populate(reader);
+        if (reader.has_error() || !document.IsObject()) {
+            return std::make_unique<ErrorRequest>("Invalid msgpack object");
+        }
+    } else {
+        document.ParseInsitu(pooled_document.copy_input(str));
+        if (document.HasParseError() || !document.IsObject()) {
+            return std::make_unique<ErrorRequest>("Invalid json object");
+        }
+    }
 
-    if (document.HasParseError()) return std::make_unique<ErrorRequest>("Invalid json object");
+    return parse_request_object(document, true);
+}
 
+std::unique_ptr<Request> Request::parse_request_object(const rapidjson::Value &document,
+                                                       bool allow_batch) {
     std::string error;
     auto request = get_member<bool>(document, "request", error);
     if (!request || !(*request)) return std::make_unique<ErrorRequest>(error);
@@ -558,7 +840,12 @@ std::unique_ptr<Request> Request::parse_request(const std::string &str) {
 
     auto const &type_str = *type;
     std::unique_ptr<Request> result;
-    if (type_str == "breakpoint") {
+    if (!allow_batch && (type_str == "connection" || type_str == "command")) {
+        // these replace the symbol table or resume the simulation, which can't happen while
+        // the batch holds the breakpoints
+        result = std::make_unique<ErrorRequest>(
+            fmt::format("{0} request is not supported in a batch", type_str));
+    } else if (type_str == "breakpoint") {
         result = std::make_unique<BreakPointRequest>();
     } else if (type_str == "breakpoint-id") {
         result = std::make_unique<BreakPointIDRequest>();
@@ -580,43 +867,51 @@ std::unique_ptr<Request> Request::parse_request(const std::string &str) {
         result = std::make_unique<MonitorRequest>();
     } else if (type_str == "set-value") {
         result = std::make_unique<SetValueRequest>();
+    } else if (type_str == "watchpoint") {
+        result = std::make_unique<WatchpointRequest>();
+    } else if (type_str == "variables") {
+        result = std::make_unique<VariablesRequest>();
+    } else if (type_str == "batch" && allow_batch) {
+        result = std::make_unique<BatchRequest>();
+    } else if (type_str == "batch") {
+        result = std::make_unique<ErrorRequest>("Nested batch request is not supported");
     } else {
         result = std::make_unique<ErrorRequest>("Unknown request");
     }
 
-    // get payload string
-    auto &payload_member = document["payload"];
-    // notice that we serialize it again. ideally we shouldn't, but since the json parser is
-    // fast, it should not be a major concern for our use cases
-    StringBuffer buffer;
-    Writer writer(buffer);
-    payload_member.Accept(writer);
-    std::string payload_str = buffer.GetString();
-    result->parse_payload(payload_str);
+    // the payload is read straight from the parsed document
+    auto const &payload_member = document["payload"];
+    if (result->check_payload(payload_member)) result->parse(payload_member);
     // set token if not empty
     if (token) result->token_ = *token;
 
     return result;
 }
 
-bool check_json(rapidjson::Document &document, status_code &status, std::string &error_reason) {
-    if (document.HasParseError()) {
-        status = status_code::error;
-        error_reason = "Invalid JSON file";
+void Request::parse_payload(const std::string &payload) {
+    PooledDocument document;
+    document->ParseInsitu(document.copy_input(payload));
+    if (document->HasParseError()) {
+        status_code_ = status_code::error;
+        error_reason_ = "Invalid JSON file";
+        return;
+    }
+    if (check_payload(*document)) parse(*document);
+}
+
+bool Request::check_payload(const rapidjson::Value &payload) {
+    if (!payload.IsObject()) {
+        status_code_ = status_code::error;
+        error_reason_ = "Payload has to be an object";
         return false;
     }
     return true;
 }
 
-void BreakPointRequest::parse_payload(const std::string &payload) {
+void BreakPointRequest::parse(const rapidjson::Value &payload) {
     // parse the breakpoint based on the API specification
-    using namespace rapidjson;
-    Document document;
-    document.Parse(payload.c_str());
-    if (!check_json(document, status_code_, error_reason_)) return;
-
-    auto filename = get_member<std::string>(document, "filename", error_reason_);
-    auto bp_act = get_member<std::string>(document, "action", error_reason_);
+    auto filename = get_member<std::string>(payload, "filename", error_reason_);
+    auto bp_act = get_member<std::string>(payload, "action", error_reason_);
     if (!filename || !bp_act) {
         status_code_ = status_code::error;
         return;
@@ -635,29 +930,39 @@ void BreakPointRequest::parse_payload(const std::string &payload) {
     }
 
     bool line_num_required = bp_action_ == action::add;
-    auto line_num = get_member<uint64_t>(document, "line_num", error_reason_, line_num_required);
+    auto line_num = get_member<uint64_t>(payload, "line_num", error_reason_, line_num_required);
     if (line_num_required || line_num)
         bp_.line_num = *line_num;
     else
         bp_.line_num = 0;
 
-    auto column_num = get_member<uint64_t>(document, "column_num", error_reason_, false);
-    auto condition = get_member<std::string>(document, "condition", error_reason_, false);
+    auto column_num = get_member<uint64_t>(payload, "column_num", error_reason_, false);
+    auto condition = get_member<std::string>(payload, "condition", error_reason_, false);
     if (column_num)
         bp_.column_num = *column_num;
     else
         bp_.column_num = 0;
     if (condition) bp_.condition = *condition;
+    parse_hit_policy(payload);
 }
 
-void BreakPointIDRequest::parse_payload(const std::string &payload) {
-    using namespace rapidjson;
-    Document document;
-    document.Parse(payload.c_str());
-    if (!check_json(document, status_code_, error_reason_)) return;
+void BreakPointRequest::parse_hit_policy(const rapidjson::Value &payload) {
+    auto ignore_count = get_member<uint64_t>(payload, "ignore_count", error_reason_, false);
+    if (ignore_count) ignore_count_ = *ignore_count;
+    auto hit_every = get_member<uint64_t>(payload, "hit_every", error_reason_, false);
+    if (hit_every) {
+        if (*hit_every == 0) {
+            status_code_ = status_code::error;
+            error_reason_ = "hit_every has to be positive";
+            return;
+        }
+        hit_every_ = *hit_every;
+    }
+}
 
-    auto id = get_member<uint64_t>(document, "id", error_reason_);
-    auto bp_act = get_member<std::string>(document, "action", error_reason_);
+void BreakPointIDRequest::parse(const rapidjson::Value &payload) {
+    auto id = get_member<uint64_t>(payload, "id", error_reason_);
+    auto bp_act = get_member<std::string>(payload, "action", error_reason_);
     if (!id || !bp_act) {
         status_code_ = status_code::error;
         return;
@@ -675,8 +980,9 @@ void BreakPointIDRequest::parse_payload(const std::string &payload) {
         return;
     }
 
-    auto condition = get_member<std::string>(document, "condition", error_reason_, false);
+    auto condition = get_member<std::string>(payload, "condition", error_reason_, false);
     if (condition) bp_.condition = *condition;
+    parse_hit_policy(payload);
 }
 
 ErrorRequest::ErrorRequest(std::string reason) {
@@ -684,13 +990,8 @@ ErrorRequest::ErrorRequest(std::string reason) {
     error_reason_ = std::move(reason);
 }
 
-void ConnectionRequest::parse_payload(const std::string &payload) {
-    using namespace rapidjson;
-    Document document;
-    document.Parse(payload.c_str());
-    if (!check_json(document, status_code_, error_reason_)) return;
-
-    auto db = get_member<std::string>(document, "db_filename", error_reason_);
+void ConnectionRequest::parse(const rapidjson::Value &payload) {
+    auto db = get_member<std::string>(payload, "db_filename", error_reason_);
     if (!db) {
         status_code_ = status_code::error;
         return;
@@ -698,37 +999,37 @@ void ConnectionRequest::parse_payload(const std::string &payload) {
     db_filename_ = *db;
 
     // get optional mapping
-    auto mapping = get_member<std::map<std::string, std::string>>(document, "path-mapping",
+    auto mapping = get_member<std::map<std::string, std::string>>(payload, "path-mapping",
                                                                   error_reason_, false);
     if (mapping) {
         path_mapping_ = *mapping;
     }
-}
 
-void BreakPointLocationRequest::parse_payload(const std::string &payload) {
-    using namespace rapidjson;
-    Document document;
-    document.Parse(payload.c_str());
-    if (!check_json(document, status_code_, error_reason_)) return;
+    auto protocol = get_member<std::string>(payload, "protocol", error_reason_, false);
+    if (protocol) {
+        if (*protocol == "msgpack") {
+            format_ = MessageFormat::msgpack;
+        } else if (*protocol != "json") {
+            status_code_ = status_code::error;
+            error_reason_ = fmt::format("Unsupported protocol {0}", *protocol);
+        }
+    }
+}
 
-    auto filename = get_member<std::string>(document, "filename", error_reason_);
+void BreakPointLocationRequest::parse(const rapidjson::Value &payload) {
+    auto filename = get_member<std::string>(payload, "filename", error_reason_);
     if (!filename) {
         status_code_ = status_code::error;
         return;
     }
     filename_ = *filename;
 
-    line_num_ = get_member<uint64_t>(document, "line_num", error_reason_);
-    column_num_ = get_member<uint64_t>(document, "column_num", error_reason_);
+    line_num_ = get_member<uint64_t>(payload, "line_num", error_reason_);
+    column_num_ = get_member<uint64_t>(payload, "column_num", error_reason_);
 }
 
-void CommandRequest::parse_payload(const std::string &payload) {
-    using namespace rapidjson;
-    Document document;
-    document.Parse(payload.c_str());
-    if (!check_json(document, status_code_, error_reason_)) return;
-
-    auto command_str = get_member<std::string>(document, "command", error_reason_);
+void CommandRequest::parse(const rapidjson::Value &payload) {
+    auto command_str = get_member<std::string>(payload, "command", error_reason_);
     if (!command_str) {
         status_code_ = status_code::error;
         return;
@@ -744,19 +1045,37 @@ void CommandRequest::parse_payload(const std::string &payload) {
         command_type_ = CommandType::step_back;
     } else if (command == "reverse_continue") {
         command_type_ = CommandType::reverse_continue;
+    } else if (command == "run_to_time") {
+        command_type_ = CommandType::run_to_time;
+        auto time = get_member<uint64_t>(payload, "time", error_reason_);
+        if (!time) {
+            status_code_ = status_code::error;
+            return;
+        }
+        time_ = *time;
     } else {
         status_code_ = status_code::error;
         error_reason_ = "Unknown command type " + command;
+        return;
     }
-}
 
-void DebuggerInformationRequest::parse_payload(const std::string &payload) {
-    using namespace rapidjson;
-    Document document;
-    document.Parse(payload.c_str());
-    if (!check_json(document, status_code_, error_reason_)) return;
+    auto count = get_member<uint64_t>(payload, "count", error_reason_, false);
+    if (count) {
+        if (*count == 0) {
+            status_code_ = status_code::error;
+            error_reason_ = "count has to be positive";
+            return;
+        }
+        count_ = *count;
+    }
+    auto condition = get_member<std::string>(payload, "condition", error_reason_, false);
+    if (condition) condition_ = *condition;
+    auto trace = get_member<bool>(payload, "trace", error_reason_, false);
+    if (trace) trace_ = *trace;
+}
 
-    auto command_str = get_member<std::string>(document, "command", error_reason_);
+void DebuggerInformationRequest::parse(const rapidjson::Value &payload) {
+    auto command_str = get_member<std::string>(payload, "command", error_reason_);
     if (!command_str) {
         status_code_ = status_code::error;
         return;
@@ -777,14 +1096,9 @@ void DebuggerInformationRequest::parse_payload(const std::string &payload) {
     }
 }
 
-void PathMappingRequest::parse_payload(const std::string &payload) {
-    using namespace rapidjson;
-    Document document;
-    document.Parse(payload.c_str());
-    if (!check_json(document, status_code_, error_reason_)) return;
-
+void PathMappingRequest::parse(const rapidjson::Value &payload) {
     auto mapping =
-        get_member<std::map<std::string, std::string>>(document, "path-mapping", error_reason_);
+        get_member<std::map<std::string, std::string>>(payload, "path-mapping", error_reason_);
     if (!mapping) {
         status_code_ = status_code::error;
         return;
@@ -793,15 +1107,10 @@ void PathMappingRequest::parse_payload(const std::string &payload) {
     path_mapping_ = *mapping;
 }
 
-void EvaluationRequest::parse_payload(const std::string &payload) {
-    using namespace rapidjson;
-    Document document;
-    document.Parse(payload.c_str());
-    if (!check_json(document, status_code_, error_reason_)) return;
-
-    auto scope = get_member<std::string>(document, "scope", error_reason_);
-    auto expression = get_member<std::string>(document, "expression", error_reason_);
-    auto is_context = get_member<bool>(document, "is_context", error_reason_);
+void EvaluationRequest::parse(const rapidjson::Value &payload) {
+    auto scope = get_member<std::string>(payload, "scope", error_reason_);
+    auto expression = get_member<std::string>(payload, "expression", error_reason_);
+    auto is_context = get_member<bool>(payload, "is_context", error_reason_);
     if (!scope || !expression || !is_context) {
         status_code_ = status_code::error;
         return;
@@ -811,14 +1120,9 @@ void EvaluationRequest::parse_payload(const std::string &payload) {
     is_context_ = *is_context;
 }
 
-void OptionChangeRequest::parse_payload(const std::string &payload) {
-    using namespace rapidjson;
-    Document document;
-    document.Parse(payload.c_str());
-    if (!check_json(document, status_code_, error_reason_)) return;
-
+void OptionChangeRequest::parse(const rapidjson::Value &payload) {
     // need to loop through the map by hand
-    for (auto const &option : document.GetObject()) {
+    for (auto const &option : payload.GetObject()) {
         std::string name = option.name.GetString();
         auto const &json_value = option.value;
         if (json_value.IsBool()) {
@@ -835,13 +1139,8 @@ void OptionChangeRequest::parse_payload(const std::string &payload) {
     }
 }
 
-void MonitorRequest::parse_payload(const std::string &payload) {
-    using namespace rapidjson;
-    Document document;
-    document.Parse(payload.c_str());
-    if (!check_json(document, status_code_, error_reason_)) return;
-
-    auto action_type = get_member<std::string>(document, "action_type", error_reason_);
+void MonitorRequest::parse(const rapidjson::Value &payload) {
+    auto action_type = get_member<std::string>(payload, "action_type", error_reason_);
     if (!action_type) {
         status_code_ = status_code::error;
         return;
@@ -857,7 +1156,7 @@ void MonitorRequest::parse_payload(const std::string &payload) {
     }
 
     if (action_type_ == ActionType::add) {
-        auto monitor_type = get_member<std::string>(document, "monitor_type", error_reason_);
+        auto monitor_type = get_member<std::string>(payload, "monitor_type", error_reason_);
         if (!monitor_type) {
             status_code_ = status_code::error;
             return;
@@ -872,18 +1171,59 @@ void MonitorRequest::parse_payload(const std::string &payload) {
             return;
         }
 
-        auto name_ = get_member<std::string>(document, "var_name", error_reason_);
-        if (!name_) {
+        expression_ = get_member<std::string>(payload, "expression", error_reason_, false);
+        auto name_ = get_member<std::string>(payload, "var_name", error_reason_, !expression_);
+        if (name_) {
+            var_name_ = *name_;
+        } else if (!expression_) {
             status_code_ = status_code::error;
             return;
         }
-        var_name_ = *name_;
 
-        instance_id_ = get_member<uint64_t>(document, "instance_id", error_reason_, false);
-        breakpoint_id_ = get_member<uint64_t>(document, "breakpoint_id", error_reason_, false);
+        instance_id_ = get_member<uint64_t>(payload, "instance_id", error_reason_, false);
+        breakpoint_id_ = get_member<uint64_t>(payload, "breakpoint_id", error_reason_, false);
+
+        auto sample_every = get_member<uint64_t>(payload, "sample_every", error_reason_, false);
+        auto sample_interval =
+            get_member<uint64_t>(payload, "sample_interval", error_reason_, false);
+        auto aggregate = get_member<std::string>(payload, "aggregate", error_reason_, false);
+        if (sample_every || sample_interval || aggregate) {
+            if (monitor_type_ != MonitorType::clock_edge) {
+                error_reason_ = "Sampling is only supported for clock_edge monitors";
+                status_code_ = status_code::error;
+                return;
+            }
+            if (sample_every && sample_interval) {
+                error_reason_ = "Only one of sample_every and sample_interval can be set";
+                status_code_ = status_code::error;
+                return;
+            }
+            sample_every_ = sample_every ? *sample_every : 0;
+            sample_interval_ = sample_interval ? *sample_interval : 0;
+        }
+        if (aggregate) {
+            if (*aggregate == "min") {
+                aggregate_ = AggregateType::min;
+            } else if (*aggregate == "max") {
+                aggregate_ = AggregateType::max;
+            } else if (*aggregate == "last") {
+                aggregate_ = AggregateType::last;
+            } else if (*aggregate == "toggle") {
+                aggregate_ = AggregateType::toggle;
+            } else {
+                error_reason_ = "Unknown aggregate type " + *aggregate;
+                status_code_ = status_code::error;
+                return;
+            }
+            if (!sample_every_ && !sample_interval_) {
+                error_reason_ = "Aggregation requires sample_every or sample_interval";
+                status_code_ = status_code::error;
+                return;
+            }
+        }
     } else {
         // only track_id is required
-        auto track_id = get_member<uint64_t>(document, "track_id", error_reason_);
+        auto track_id = get_member<uint64_t>(payload, "track_id", error_reason_);
         if (!track_id) {
             status_code_ = status_code::error;
             return;
@@ -892,14 +1232,9 @@ void MonitorRequest::parse_payload(const std::string &payload) {
     }
 }
 
-void SetValueRequest::parse_payload(const std::string &payload) {
-    using namespace rapidjson;
-    Document document;
-    document.Parse(payload.c_str());
-    if (!check_json(document, status_code_, error_reason_)) return;
-
-    auto variable_name = get_member<std::string>(document, "var_name", error_reason_);
-    auto v = get_member<int64_t>(document, "value", error_reason_);
+void SetValueRequest::parse(const rapidjson::Value &payload) {
+    auto variable_name = get_member<std::string>(payload, "var_name", error_reason_);
+    auto v = get_member<int64_t>(payload, "value", error_reason_);
 
     if (!variable_name || !v) {
         status_code_ = status_code::error;
@@ -909,8 +1244,87 @@ void SetValueRequest::parse_payload(const std::string &payload) {
     value_ = *v;
 
     // optional values
-    instance_id_ = get_member<uint64_t>(document, "instance_id", error_reason_, false);
-    breakpoint_id_ = get_member<uint64_t>(document, "breakpoint_id", error_reason_, false);
+    instance_id_ = get_member<uint64_t>(payload, "instance_id", error_reason_, false);
+    breakpoint_id_ = get_member<uint64_t>(payload, "breakpoint_id", error_reason_, false);
+}
+
+void WatchpointRequest::parse(const rapidjson::Value &payload) {
+    auto wp_act = get_member<std::string>(payload, "action", error_reason_);
+    if (!wp_act) {
+        status_code_ = status_code::error;
+        return;
+    }
+    if (*wp_act == "add") {
+        wp_action_ = action::add;
+    } else if (*wp_act == "remove") {
+        wp_action_ = action::remove;
+    } else {
+        error_reason_ = "Unknown action type " + *wp_act;
+        status_code_ = status_code::error;
+        return;
+    }
+
+    if (wp_action_ == action::add) {
+        auto variable_name = get_member<std::string>(payload, "var_name", error_reason_);
+        if (!variable_name) {
+            status_code_ = status_code::error;
+            return;
+        }
+        var_name_ = *variable_name;
+        condition_ = get_member<std::string>(payload, "condition", error_reason_, false);
+        instance_id_ = get_member<uint64_t>(payload, "instance_id", error_reason_, false);
+        breakpoint_id_ = get_member<uint64_t>(payload, "breakpoint_id", error_reason_, false);
+    } else {
+        auto id = get_member<uint64_t>(payload, "id", error_reason_);
+        if (!id) {
+            status_code_ = status_code::error;
+            return;
+        }
+        id_ = *id;
+    }
+}
+
+void VariablesRequest::parse(const rapidjson::Value &payload) {
+    auto breakpoint_id = get_member<uint64_t>(payload, "breakpoint_id", error_reason_);
+    auto kind = get_member<std::string>(payload, "kind", error_reason_);
+    if (!breakpoint_id || !kind) {
+        status_code_ = status_code::error;
+        return;
+    }
+    breakpoint_id_ = *breakpoint_id;
+    if (*kind == "local") {
+        kind_ = VariableKind::local;
+    } else if (*kind == "generator") {
+        kind_ = VariableKind::generator;
+    } else {
+        error_reason_ = "Unknown variable kind " + *kind;
+        status_code_ = status_code::error;
+        return;
+    }
+
+    auto prefix = get_member<std::string>(payload, "prefix", error_reason_, false);
+    if (prefix) prefix_ = *prefix;
+    auto offset = get_member<uint64_t>(payload, "offset", error_reason_, false);
+    if (offset) offset_ = *offset;
+    auto limit = get_member<uint64_t>(payload, "limit", error_reason_, false);
+    if (limit) limit_ = *limit;
+}
+
+void BatchRequest::parse(const rapidjson::Value &payload) {
+    if (!check_member(payload, "requests", error_reason_) || !payload["requests"].IsArray()) {
+        if (error_reason_.empty()) error_reason_ = "Invalid type for requests";
+        status_code_ = status_code::error;
+        return;
+    }
+    auto const &requests = payload["requests"].GetArray();
+    requests_.reserve(requests.Size());
+    for (auto const &request : requests) {
+        if (request.IsObject()) [[likely]] {
+            requests_.emplace_back(parse_request_object(request, false));
+        } else {
+            requests_.emplace_back(std::make_unique<ErrorRequest>("Invalid request"));
+        }
+    }
 }
 
 }  // namespace hgdb
\ No newline at end of file
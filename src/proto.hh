@@ -7,6 +7,7 @@
 #include <type_traits>
 #include <utility>
 
+#include "rapidjson/fwd.h"
 #include "schema.hh"
 
 namespace hgdb {
@@ -24,18 +25,39 @@ enum class RequestType {
     evaluation,
     option_change,
     monitor,
-    set_value
+    set_value,
+    watchpoint,
+    batch,
+    variables
 };
 
 [[nodiscard]] std::string to_string(RequestType type) noexcept;
 
+// wire format of the messages. JSON is the default, MessagePack can be requested by the client in
+// the connection request. both carry the same schema
+enum class MessageFormat { json, msgpack };
+// conversion between the two formats, mostly used by tests and tools
+[[nodiscard]] std::string json_to_msgpack(const std::string &json);
+[[nodiscard]] std::optional<std::string> msgpack_to_json(const std::string &data,
+                                                         bool pretty_print = false);
+
 class Request;
+// streams responses into the output buffer. only visible to proto.cc
+class ResponseWriter;
 
 class Response {
 public:
     Response() = default;
     explicit Response(status_code status) : status_(status) {}
-    [[nodiscard]] virtual std::string str(bool pretty_print) const = 0;
+    virtual ~Response() = default;
+    // JSON
+    [[nodiscard]] std::string str(bool pretty_print) const {
+        return serialize(MessageFormat::json, pretty_print);
+    }
+    // pretty print is ignored for binary formats
+    [[nodiscard]] std::string serialize(MessageFormat format, bool pretty_print) const;
+    // appends to the buffer, which can be reused by the caller
+    void serialize(std::string &buffer, MessageFormat format, bool pretty_print) const;
     [[nodiscard]] virtual std::string type() const = 0;
     [[nodiscard]] const std::string &token() const { return token_; }
     void set_token(std::string token) { token_ = std::move(token); }
@@ -43,13 +65,15 @@ public:
 protected:
     status_code status_ = status_code::success;
     std::string token_;
+
+    // responses are written without building a DOM first
+    virtual void write_payload(ResponseWriter &writer) const = 0;
 };
 
 class GenericResponse : public Response {
 public:
     GenericResponse(status_code status, const Request &req, std::string reason = "");
     GenericResponse(status_code status, RequestType type, std::string reason = "");
-    [[nodiscard]] std::string str(bool pretty_print) const override;
     [[nodiscard]] std::string type() const override { return "generic"; }
 
     template <typename T>
@@ -68,6 +92,7 @@ public:
     }
 
 private:
+    void write_payload(ResponseWriter &writer) const override;
     std::string request_type_;
     std::string reason_;
 
@@ -82,10 +107,10 @@ private:
 class BreakPointLocationResponse : public Response {
 public:
     explicit BreakPointLocationResponse(std::vector<BreakPoint *> bps) : bps_(std::move(bps)) {}
-    [[nodiscard]] std::string str(bool pretty_print) const override;
     [[nodiscard]] std::string type() const override { return to_string(RequestType::bp_location); }
 
 private:
+    void write_payload(ResponseWriter &writer) const override;
     std::vector<BreakPoint *> bps_;
 };
 
@@ -93,7 +118,6 @@ class BreakPointResponse : public Response {
 public:
     BreakPointResponse(uint64_t time, std::string filename, uint64_t line_num,
                        uint64_t column_num = 0);
-    [[nodiscard]] std::string str(bool pretty_print) const override;
     [[nodiscard]] std::string type() const override { return to_string(RequestType::breakpoint); }
 
     struct Scope {
@@ -103,6 +127,9 @@ public:
         std::string instance_name;
         std::map<std::string, std::string> local_values;
         std::map<std::string, std::string> generator_values;
+        // only set when variables are fetched lazily. the maps above hold a summary
+        std::optional<uint64_t> local_count;
+        std::optional<uint64_t> generator_count;
 
         Scope(uint64_t instance_id, std::string instance_name, uint64_t breakpoint_id);
 
@@ -112,13 +139,22 @@ public:
 
     inline void add_scope(const Scope &scope) { scopes_.emplace_back(scope); }
 
+    // stops skipped by server-side stepping. locations can be looked up by breakpoint id
+    struct TraceEntry {
+        uint64_t time;
+        uint64_t breakpoint_id;
+    };
+    void set_trace(std::vector<TraceEntry> trace) { trace_ = std::move(trace); }
+
 private:
+    void write_payload(ResponseWriter &writer) const override;
     uint64_t time_;
     std::string filename_;
     uint64_t line_num_;
     uint64_t column_num_;
 
     std::vector<Scope> scopes_;
+    std::optional<std::vector<TraceEntry>> trace_;
 };
 
 class Request {
@@ -130,6 +166,8 @@ public:
     [[nodiscard]] inline const std::string &get_token() const { return token_; }
 
     [[nodiscard]] static std::unique_ptr<Request> parse_request(const std::string &str);
+    // parsed in-situ with per-thread memory pools
+    void parse_payload(const std::string &payload);
 
     virtual ~Request() = default;
 
@@ -138,13 +176,19 @@ protected:
     std::string error_reason_;
     std::string token_;
 
-    virtual void parse_payload(const std::string &payload) = 0;
+    bool check_payload(const rapidjson::Value &payload);
+    // payload is always an object
+    virtual void parse(const rapidjson::Value &payload) = 0;
+
+    // shared by top-level and batched requests
+    [[nodiscard]] static std::unique_ptr<Request> parse_request_object(
+        const rapidjson::Value &document, bool allow_batch);
 };
 
 class ErrorRequest : public Request {
 public:
     explicit ErrorRequest(std::string reason);
-    void parse_payload(const std::string &) override {}
+    void parse(const rapidjson::Value &) override {}
     [[nodiscard]] RequestType type() const override { return RequestType::error; }
 };
 
@@ -152,41 +196,50 @@ class BreakPointRequest : public Request {
 public:
     enum class action { add, remove };
     BreakPointRequest() = default;
-    void parse_payload(const std::string &payload) override;
+    void parse(const rapidjson::Value &payload) override;
     [[nodiscard]] const auto &breakpoint() const { return bp_; }
     [[nodiscard]] auto bp_action() const { return bp_action_; }
     [[nodiscard]] RequestType type() const override { return RequestType::breakpoint; }
+    // hit policy, see DebugBreakPoint
+    [[nodiscard]] auto ignore_count() const { return ignore_count_; }
+    [[nodiscard]] auto hit_every() const { return hit_every_; }
 
 protected:
     BreakPoint bp_;
     action bp_action_ = action::add;
+    uint64_t ignore_count_ = 0;
+    uint64_t hit_every_ = 1;
+
+    void parse_hit_policy(const rapidjson::Value &payload);
 };
 
 class BreakPointIDRequest : public BreakPointRequest {
 public:
     BreakPointIDRequest() = default;
-    void parse_payload(const std::string &payload) override;
+    void parse(const rapidjson::Value &payload) override;
     [[nodiscard]] RequestType type() const override { return RequestType::breakpoint_id; }
 };
 
 class ConnectionRequest : public Request {
 public:
     ConnectionRequest() = default;
-    void parse_payload(const std::string &payload) override;
+    void parse(const rapidjson::Value &payload) override;
     [[nodiscard]] RequestType type() const override { return RequestType::connection; }
 
     [[nodiscard]] const auto &db_filename() const { return db_filename_; }
     [[nodiscard]] const auto &path_mapping() const { return path_mapping_; };
+    [[nodiscard]] MessageFormat format() const { return format_; }
 
 private:
     std::string db_filename_;
     std::map<std::string, std::string> path_mapping_;
+    MessageFormat format_ = MessageFormat::json;
 };
 
 class BreakPointLocationRequest : public Request {
 public:
     BreakPointLocationRequest() = default;
-    void parse_payload(const std::string &payload) override;
+    void parse(const rapidjson::Value &payload) override;
     [[nodiscard]] RequestType type() const override { return RequestType::bp_location; }
 
     [[nodiscard]] const auto &filename() const { return filename_; }
@@ -201,23 +254,42 @@ private:
 
 class CommandRequest : public Request {
 public:
-    enum class CommandType { continue_, step_over, step_back, stop, reverse_continue };
+    enum class CommandType {
+        continue_,
+        step_over,
+        step_back,
+        stop,
+        reverse_continue,
+        run_to_time
+    };
 
     CommandRequest() = default;
-    void parse_payload(const std::string &payload) override;
+    void parse(const rapidjson::Value &payload) override;
     [[nodiscard]] RequestType type() const override { return RequestType::command; }
 
     [[nodiscard]] auto command_type() const { return command_type_; }
+    // server-side stepping. the command keeps going until it has stopped count times where the
+    // condition holds, and only the final stop is reported
+    [[nodiscard]] auto count() const { return count_; }
+    [[nodiscard]] const auto &condition() const { return condition_; }
+    // whether to report the skipped stops with the final one
+    [[nodiscard]] auto trace() const { return trace_; }
+    // simulation time to pause at for run_to_time
+    [[nodiscard]] auto time() const { return time_; }
 
 private:
     CommandType command_type_ = CommandType::continue_;
+    uint64_t count_ = 1;
+    std::string condition_;
+    bool trace_ = false;
+    uint64_t time_ = 0;
 };
 
 class DebuggerInformationRequest : public Request {
 public:
     enum class CommandType { breakpoints, status, options, design };
     DebuggerInformationRequest() = default;
-    void parse_payload(const std::string &payload) override;
+    void parse(const rapidjson::Value &payload) override;
     [[nodiscard]] RequestType type() const override { return RequestType::debugger_info; }
 
     [[nodiscard]] auto const &command_type() const { return command_type_; }
@@ -229,7 +301,7 @@ private:
 class PathMappingRequest : public Request {
 public:
     PathMappingRequest() = default;
-    void parse_payload(const std::string &payload) override;
+    void parse(const rapidjson::Value &payload) override;
     [[nodiscard]] RequestType type() const override { return RequestType::path_mapping; }
 
     [[nodiscard]] const std::map<std::string, std::string> &path_mapping() const {
@@ -243,7 +315,7 @@ private:
 class EvaluationRequest : public Request {
 public:
     EvaluationRequest() = default;
-    void parse_payload(const std::string &payload) override;
+    void parse(const rapidjson::Value &payload) override;
     [[nodiscard]] RequestType type() const override { return RequestType::evaluation; }
 
     [[nodiscard]] const std::string &scope() const { return scope_; }
@@ -259,7 +331,7 @@ private:
 class OptionChangeRequest : public Request {
 public:
     OptionChangeRequest() = default;
-    void parse_payload(const std::string &payload) override;
+    void parse(const rapidjson::Value &payload) override;
     [[nodiscard]] RequestType type() const override { return RequestType::option_change; }
 
     [[nodiscard]] const std::map<std::string, bool> &bool_values() const { return bool_values_; }
@@ -278,30 +350,41 @@ class MonitorRequest : public Request {
 public:
     enum class ActionType { add, remove };
     enum class MonitorType { breakpoint, clock_edge };
+    enum class AggregateType { none, min, max, last, toggle };
     MonitorRequest() = default;
-    void parse_payload(const std::string &payload) override;
+    void parse(const rapidjson::Value &payload) override;
     [[nodiscard]] RequestType type() const override { return RequestType::monitor; }
 
     [[nodiscard]] ActionType action_type() const { return action_type_; }
     [[nodiscard]] MonitorType monitor_type() const { return monitor_type_; }
     [[nodiscard]] const std::string &var_name() const { return var_name_; }
+    // if set, the watch is the value of the expression instead of a single signal
+    [[nodiscard]] const std::optional<std::string> &expression() const { return expression_; }
     [[nodiscard]] const std::optional<uint64_t> &breakpoint_id() const { return breakpoint_id_; };
     [[nodiscard]] const std::optional<uint64_t> &instance_id() const { return instance_id_; }
     [[nodiscard]] uint64_t track_id() const { return track_id_; }
+    // clock edge sampling. 0 means every edge
+    [[nodiscard]] uint64_t sample_every() const { return sample_every_; }
+    [[nodiscard]] uint64_t sample_interval() const { return sample_interval_; }
+    [[nodiscard]] AggregateType aggregate() const { return aggregate_; }
 
 private:
     ActionType action_type_ = ActionType::add;
     MonitorType monitor_type_ = MonitorType::breakpoint;
     std::string var_name_;
+    std::optional<std::string> expression_;
     std::optional<uint64_t> breakpoint_id_;
     std::optional<uint64_t> instance_id_;
     uint64_t track_id_ = 0;
+    uint64_t sample_every_ = 0;
+    uint64_t sample_interval_ = 0;
+    AggregateType aggregate_ = AggregateType::none;
 };
 
 class SetValueRequest : public Request {
 public:
     SetValueRequest() = default;
-    void parse_payload(const std::string &payload) override;
+    void parse(const rapidjson::Value &payload) override;
     [[nodiscard]] RequestType type() const override { return RequestType::set_value; }
 
     [[nodiscard]] int64_t value() const { return value_; }
@@ -316,6 +399,67 @@ private:
     std::optional<uint64_t> breakpoint_id_;
 };
 
+class WatchpointRequest : public Request {
+public:
+    enum class action { add, remove };
+    WatchpointRequest() = default;
+    void parse(const rapidjson::Value &payload) override;
+    [[nodiscard]] RequestType type() const override { return RequestType::watchpoint; }
+
+    [[nodiscard]] auto wp_action() const { return wp_action_; }
+    [[nodiscard]] uint64_t id() const { return id_; }
+    [[nodiscard]] const std::string &var_name() const { return var_name_; }
+    [[nodiscard]] const std::optional<std::string> &condition() const { return condition_; }
+    [[nodiscard]] const std::optional<uint64_t> &instance_id() const { return instance_id_; }
+    [[nodiscard]] const std::optional<uint64_t> &breakpoint_id() const { return breakpoint_id_; }
+
+private:
+    action wp_action_ = action::add;
+    uint64_t id_ = 0;
+    std::string var_name_;
+    std::optional<std::string> condition_;
+    std::optional<uint64_t> instance_id_;
+    std::optional<uint64_t> breakpoint_id_;
+};
+
+class VariablesRequest : public Request {
+public:
+    enum class VariableKind { local, generator };
+    VariablesRequest() = default;
+    void parse(const rapidjson::Value &payload) override;
+    [[nodiscard]] RequestType type() const override { return RequestType::variables; }
+
+    [[nodiscard]] uint64_t breakpoint_id() const { return breakpoint_id_; }
+    [[nodiscard]] VariableKind kind() const { return kind_; }
+    [[nodiscard]] const std::string &prefix() const { return prefix_; }
+    [[nodiscard]] uint64_t offset() const { return offset_; }
+    [[nodiscard]] uint64_t limit() const { return limit_; }
+
+    static constexpr uint64_t default_limit = 100;
+
+private:
+    uint64_t breakpoint_id_ = 0;
+    VariableKind kind_ = VariableKind::local;
+    std::string prefix_;
+    uint64_t offset_ = 0;
+    uint64_t limit_ = default_limit;
+};
+
+// sub-requests are handled in order and answered with a single batch response
+class BatchRequest : public Request {
+public:
+    BatchRequest() = default;
+    void parse(const rapidjson::Value &payload) override;
+    [[nodiscard]] RequestType type() const override { return RequestType::batch; }
+
+    [[nodiscard]] const std::vector<std::unique_ptr<Request>> &requests() const {
+        return requests_;
+    }
+
+private:
+    std::vector<std::unique_ptr<Request>> requests_;
+};
+
 class DebuggerInformationResponse : public Response {
 public:
     explicit DebuggerInformationResponse(std::string status);
@@ -323,12 +467,12 @@ public:
     explicit DebuggerInformationResponse(std::map<std::string, std::string> options);
     explicit DebuggerInformationResponse(std::unordered_map<std::string, std::string> design);
 
-    [[nodiscard]] std::string str(bool pretty_print) const override;
     [[nodiscard]] std::string type() const override {
         return to_string(RequestType::debugger_info);
     }
 
 private:
+    void write_payload(ResponseWriter &writer) const override;
     DebuggerInformationRequest::CommandType command_type_;
     std::string status_str_;
     std::vector<BreakPoint *> bps_;
@@ -340,25 +484,71 @@ private:
 class EvaluationResponse : public Response {
 public:
     EvaluationResponse(std::string scope, std::string result);
-    [[nodiscard]] std::string str(bool pretty_print) const override;
     [[nodiscard]] std::string type() const override { return to_string(RequestType::evaluation); }
 
 private:
+    void write_payload(ResponseWriter &writer) const override;
     std::string scope_;
     std::string result_;
 };
 
 class MonitorResponse : public Response {
 public:
-    MonitorResponse(uint64_t track_id, std::string value);
-    [[nodiscard]] std::string str(bool pretty_print) const override;
+    // all values changed at the same time are sent in one response
+    MonitorResponse(uint64_t time, std::vector<std::pair<uint64_t, std::string>> values);
     [[nodiscard]] std::string type() const override { return to_string(RequestType::monitor); }
 
 private:
-    uint64_t track_id_;
+    void write_payload(ResponseWriter &writer) const override;
+    uint64_t time_;
+    std::vector<std::pair<uint64_t, std::string>> values_;
+};
+
+class WatchpointResponse : public Response {
+public:
+    WatchpointResponse(uint64_t time, uint64_t id, std::string var_name, std::string value);
+    [[nodiscard]] std::string type() const override {
+        return to_string(RequestType::watchpoint);
+    }
+
+private:
+    void write_payload(ResponseWriter &writer) const override;
+    uint64_t time_;
+    uint64_t id_;
+    std::string var_name_;
     std::string value_;
 };
 
+class VariablesResponse : public Response {
+public:
+    VariablesResponse(uint64_t breakpoint_id, VariablesRequest::VariableKind kind,
+                      uint64_t total, uint64_t offset, std::map<std::string, std::string> values);
+    [[nodiscard]] std::string type() const override {
+        return to_string(RequestType::variables);
+    }
+
+private:
+    void write_payload(ResponseWriter &writer) const override;
+    uint64_t breakpoint_id_;
+    VariablesRequest::VariableKind kind_;
+    uint64_t total_;
+    uint64_t offset_;
+    std::map<std::string, std::string> values_;
+};
+
+class BatchResponse : public Response {
+public:
+    // responses of the sub-requests, already serialized in the given format
+    BatchResponse(std::vector<std::string> responses, MessageFormat format);
+    [[nodiscard]] std::string type() const override { return to_string(RequestType::batch); }
+
+private:
+    void write_payload(ResponseWriter &writer) const override;
+
+    std::vector<std::string> responses_;
+    MessageFormat format_;
+};
+
 }  // namespace hgdb
 
 #endif  // HGDB_PROTO_HH
@@ -215,11 +215,131 @@ vpiHandle RTLSimulatorClient::get_handle(const std::vector<std::string> &tokens)
 }
 
 bool RTLSimulatorClient::is_valid_signal(const std::string &name) {
+    auto full_name = get_full_name(name);
+    {
+        std::lock_guard guard(signal_validity_lock_);
+        if (signal_validity_.find(full_name) != signal_validity_.end()) {
+            return signal_validity_.at(full_name);
+        }
+    }
     auto *handle = get_handle(name);
-    if (!handle) return false;
-    auto type = get_vpi_type(handle);
-    return type == vpiReg || type == vpiNet || type == vpiRegArray || type == vpiRegBit ||
-           type == vpiNetArray || type == vpiNetBit || type == vpiPartSelect;
+    bool valid = false;
+    if (handle) {
+        auto type = get_vpi_type(handle);
+        valid = type == vpiReg || type == vpiNet || type == vpiRegArray || type == vpiRegBit ||
+                type == vpiNetArray || type == vpiNetBit || type == vpiPartSelect;
+    }
+    std::lock_guard guard(signal_validity_lock_);
+    signal_validity_.emplace(full_name, valid);
+    return valid;
+}
+
+// trie built from the signal names referenced by the symbol table. only modules that lead
+// to an indexed signal are visited
+struct HierarchyTrieNode {
+    std::unordered_map<std::string, std::unique_ptr<HierarchyTrieNode>> children;
+    bool is_signal = false;
+
+    HierarchyTrieNode *add_child(const std::string &name) {
+        auto &node = children[name];
+        if (!node) node = std::make_unique<HierarchyTrieNode>();
+        return node.get();
+    }
+};
+
+struct HierarchyIndexTask {
+    vpiHandle handle;
+    const HierarchyTrieNode *node;
+    std::string prefix;
+};
+
+using IndexedSignals = std::vector<std::pair<std::string, vpiHandle>>;
+
+// scan a single module once. signals referenced by the trie are stored in the result and
+// child modules that contain referenced signals are pushed to the task list
+void index_module(AVPIProvider *vpi, const std::vector<PLI_INT32> &net_types,
+                  const HierarchyIndexTask &task, IndexedSignals &signals,
+                  std::vector<HierarchyIndexTask> &tasks) {
+    for (auto net_type : net_types) {
+        auto *net_iter = vpi->vpi_iterate(net_type, task.handle);
+        if (!net_iter) continue;
+        vpiHandle net_handle;
+        while ((net_handle = vpi->vpi_scan(net_iter)) != nullptr) {
+            auto *name = vpi->vpi_get_str(vpiName, net_handle);
+            if (!name) [[unlikely]] {
+                continue;
+            }
+            auto pos = task.node->children.find(name);
+            if (pos != task.node->children.end() && pos->second->is_signal) {
+                signals.emplace_back(task.prefix + name, net_handle);
+            }
+        }
+    }
+
+    auto *module_iter = vpi->vpi_iterate(vpiModule, task.handle);
+    if (!module_iter) return;
+    vpiHandle module_handle;
+    while ((module_handle = vpi->vpi_scan(module_iter)) != nullptr) {
+        auto *name = vpi->vpi_get_str(vpiName, module_handle);
+        if (!name) [[unlikely]] {
+            continue;
+        }
+        auto pos = task.node->children.find(name);
+        if (pos != task.node->children.end() && !pos->second->children.empty()) {
+            tasks.emplace_back(HierarchyIndexTask{.handle = module_handle,
+                                                  .node = pos->second.get(),
+                                                  .prefix = task.prefix + name + "."});
+        }
+    }
+}
+
+void index_modules(AVPIProvider *vpi, const std::vector<PLI_INT32> &net_types,
+                   std::vector<HierarchyIndexTask> tasks, IndexedSignals &signals) {
+    while (!tasks.empty()) {
+        auto task = std::move(tasks.back());
+        tasks.pop_back();
+        index_module(vpi, net_types, task, signals, tasks);
+    }
+}
+
+uint64_t RTLSimulatorClient::index_signals(const std::vector<std::string> &names) {
+    HierarchyTrieNode root;
+    for (auto const &name : names) {
+        auto full_name = get_full_name(name);
+        // array elements and slices are left to the lazy lookup
+        if (full_name.find_first_of("[]:") != std::string::npos) continue;
+        auto tokens = util::get_tokens(full_name, ".");
+        if (tokens.size() < 2) continue;
+        auto *node = &root;
+        for (auto const &token : tokens) {
+            node = node->add_child(token);
+        }
+        node->is_signal = true;
+    }
+    if (root.children.empty()) return 0;
+
+    std::vector<PLI_INT32> net_types;
+    if (is_verilator_) {
+        net_types = {static_cast<PLI_INT32>(vpi_net_target_)};
+    } else {
+        net_types = {vpiNet, vpiReg};
+    }
+
+    // top modules first
+    std::vector<HierarchyIndexTask> tasks;
+    IndexedSignals signals;
+    index_module(vpi_.get(), {}, HierarchyIndexTask{.handle = nullptr, .node = &root, .prefix = ""},
+                 signals, tasks);
+    index_modules(vpi_.get(), net_types, std::move(tasks), signals);
+
+    for (auto const &[name, handle] : signals) {
+        vpi_->vpi_handle_resolved(handle, name);
+    }
+    std::lock_guard guard(handle_map_lock_);
+    for (auto const &[name, handle] : signals) {
+        handle_map_.emplace(name, handle);
+    }
+    return signals.size();
 }
 
 vpiHandle RTLSimulatorClient::access_arrays(StringIterator begin, StringIterator end,
@@ -238,9 +358,9 @@ vpiHandle RTLSimulatorClient::access_arrays(StringIterator begin, StringIterator
     return var_handle;
 }
 
-int64_t get_slice(int64_t value, const std::tuple<vpiHandle, uint32_t, uint32_t> &info) {
+int64_t get_slice(int64_t value, const HandleInfo &info) {
     // notice that hi and lo are inclusive
-    auto [parent, hi, lo] = info;
+    auto hi = info.hi, lo = info.lo;
     auto v = static_cast<uint64_t>(value);
     auto hi_mask = ~(std::numeric_limits<uint64_t>::max() << (hi + 1));
     v = v & hi_mask;
@@ -252,17 +372,16 @@ std::optional<int64_t> RTLSimulatorClient::get_value(vpiHandle handle) {
     if (!handle) [[unlikely]] {
         return std::nullopt;
     }
-    auto type = get_vpi_type(handle);
-    if (type == vpiModule) [[unlikely]] {
+    const auto *info = get_handle_info(handle);
+    if (info->type == vpiModule) [[unlikely]] {
         return std::nullopt;
     }
-    vpiHandle request_handle = handle;
 
     // if we have mock vpi handle, use it
     // optimize for unlikely
-    bool is_slice_handle = mock_slice_handles_.find(handle) != mock_slice_handles_.end();
+    bool is_slice_handle = info->is_slice();
     if (is_slice_handle) [[unlikely]]
-        handle = std::get<0>(mock_slice_handles_.at(handle));
+        handle = info->parent;
 
     s_vpi_value v;
     v.format = vpiIntVal;
@@ -270,7 +389,7 @@ std::optional<int64_t> RTLSimulatorClient::get_value(vpiHandle handle) {
     int64_t result = v.value.integer;
 
     if (is_slice_handle) [[unlikely]] {
-        result = get_slice(result, mock_slice_handles_.at(request_handle));
+        result = get_slice(result, *info);
     }
 
     return result;
@@ -286,9 +405,8 @@ std::optional<std::string> RTLSimulatorClient::get_str_value(const std::string &
     return get_str_value(handle);
 }
 
-std::string get_slice(const std::string &value,
-                      const std::tuple<vpiHandle, uint32_t, uint32_t> &info) {
-    auto [parent, hi, lo] = info;
+std::string get_slice(const std::string &value, const HandleInfo &info) {
+    auto hi = info.hi, lo = info.lo;
     // notice that it's in reverse order!
     // hi and lo are inclusive as in RTL
     if (lo > value.size() - 1) {
@@ -317,26 +435,23 @@ std::optional<std::string> RTLSimulatorClient::get_str_value(vpiHandle handle) {
     if (!handle) [[unlikely]] {
         return std::nullopt;
     }
-    auto type = get_vpi_type(handle);
-    if (type == vpiModule) [[unlikely]] {
+    const auto *info = get_handle_info(handle);
+    if (info->type == vpiModule) [[unlikely]] {
         return std::nullopt;
     }
 
-    vpiHandle request_handle = handle;
-
-    bool is_slice = mock_slice_handles_.find(handle) != mock_slice_handles_.end();
-    handle = is_slice ? std::get<0>(mock_slice_handles_.at(handle)) : handle;
+    bool is_slice = info->is_slice();
+    handle = is_slice ? info->parent : handle;
 
     s_vpi_value v;
     v.format = is_slice ? vpiBinStrVal : vpiHexStrVal;
     vpi_->vpi_get_value(handle, &v);
     std::string result = v.value.str;
     if (is_slice) [[unlikely]] {
-        result = get_slice(result, mock_slice_handles_.at(request_handle));
+        result = get_slice(result, *info);
     }
     // we only add 0x to any signal that has more than 1bit
-    auto width = get_vpi_size(request_handle);
-    if (width > 1) result = fmt::format("0x{0}", result);
+    if (info->width > 1) result = fmt::format("0x{0}", result);
     return result;
 }
 
@@ -608,6 +723,12 @@ bool RTLSimulatorClient::monitor_signals(const std::vector<std::string> &signals
     return true;
 }
 
+void RTLSimulatorClient::unmonitor_signals(const std::vector<std::string> &signals) {
+    for (auto const &name : signals) {
+        remove_call_back("Monitor " + get_full_name(name));
+    }
+}
+
 std::unordered_set<std::string> RTLSimulatorClient::callback_names() {
     std::lock_guard guard(cb_handles_lock_);
     std::unordered_set<std::string> result;
@@ -636,26 +757,16 @@ void RTLSimulatorClient::set_vpi_allocator(const std::function<vpiHandle()> &fun
     vpi_allocator_ = func;
 }
 
-PLI_INT32 RTLSimulatorClient::get_vpi_type(vpiHandle handle) {
-    std::lock_guard guard(cached_vpi_types_lock_);
-    if (cached_vpi_types_.find(handle) != cached_vpi_types_.end()) [[likely]] {
-        return cached_vpi_types_.at(handle);
-    } else {
-        auto t = vpi_->vpi_get(vpiType, handle);
-        cached_vpi_types_.emplace(handle, t);
-        return t;
-    }
-}
-
-uint32_t RTLSimulatorClient::get_vpi_size(vpiHandle handle) {
-    std::lock_guard guard(cached_vpi_size_lock_);
-    if (cached_vpi_size_.find(handle) != cached_vpi_size_.end()) [[likely]] {
-        return cached_vpi_size_.at(handle);
-    } else {
-        auto t = vpi_->vpi_get(vpiSize, handle);
-        cached_vpi_size_.emplace(handle, t);
-        return t;
+const HandleInfo *RTLSimulatorClient::get_handle_info(vpiHandle handle) {
+    const auto *info = handle_table_.find(handle);
+    if (info) [[likely]] {
+        return info;
     }
+    // query everything we need at once so that the following reads are lock-free
+    HandleInfo new_info;
+    new_info.type = vpi_->vpi_get(vpiType, handle);
+    new_info.width = vpi_->vpi_get(vpiSize, handle);
+    return handle_table_.insert(handle, new_info);
 }
 
 RTLSimulatorClient::~RTLSimulatorClient() {
@@ -676,6 +787,38 @@ std::unordered_map<std::string, std::string> RTLSimulatorClient::get_top_mapping
     return result;
 }
 
+void RTLSimulatorClient::set_top_mapping(
+    const std::unordered_map<std::string, std::string> &mapping) {
+    hierarchy_name_prefix_map_.clear();
+    for (auto const &[src_name, tb_name] : mapping) {
+        hierarchy_name_prefix_map_.emplace(src_name, fmt::format("{0}.", tb_name));
+    }
+}
+
+std::vector<std::string> RTLSimulatorClient::get_top_module_names() {
+    std::vector<std::string> result;
+    auto *handle_iter = vpi_->vpi_iterate(vpiModule, nullptr);
+    if (!handle_iter) return result;
+    vpiHandle handle;
+    while ((handle = vpi_->vpi_scan(handle_iter)) != nullptr) {
+        auto *name = vpi_->vpi_get_str(vpiFullName, handle);
+        if (name) result.emplace_back(name);
+    }
+    return result;
+}
+
+std::unordered_map<std::string, bool> RTLSimulatorClient::get_signal_validity() {
+    std::lock_guard guard(signal_validity_lock_);
+    return signal_validity_;
+}
+
+void RTLSimulatorClient::set_signal_validity(const std::unordered_map<std::string, bool> &signals) {
+    std::lock_guard guard(signal_validity_lock_);
+    for (auto const &[name, valid] : signals) {
+        signal_validity_.emplace(name, valid);
+    }
+}
+
 std::optional<std::pair<uint32_t, uint32_t>> extract_slice(const std::string &token) {
     auto nums = util::get_tokens(token, ":");
     if (nums.size() != 2) return {};
@@ -695,7 +838,9 @@ vpiHandle RTLSimulatorClient::add_mock_slice_vpi(vpiHandle parent, const std::st
     if (!slice_num) return nullptr;
     auto [hi, lo] = *slice_num;
     auto *new_handle = vpi_allocator_ ? (*vpi_allocator_)() : ++mock_slice_handle_counter_;
-    mock_slice_handles_.emplace(new_handle, std::make_tuple(parent, hi, lo));
+    HandleInfo info{
+        .type = vpiPartSelect, .width = hi - lo + 1, .parent = parent, .hi = hi, .lo = lo};
+    handle_table_.insert(new_handle, info);
     return new_handle;
 }
 
@@ -1,6 +1,7 @@
 #ifndef HGDB_RTL_HH
 #define HGDB_RTL_HH
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -44,6 +45,9 @@ public:
     };
     virtual bool vpi_rewind(rewind_data *reverse_data) { return false; }
     virtual bool vpi_simulate_backward() { return false; }
+    // called with the full name of handles resolved by walking the hierarchy instead of
+    // vpi_handle_by_name
+    virtual void vpi_handle_resolved(vpiHandle handle, const std::string &name) {}
 };
 
 class VPIProvider : public AVPIProvider {
@@ -67,6 +71,116 @@ private:
     std::mutex vpi_lock_;
 };
 
+// metadata of a resolved vpiHandle. populated once when the handle is first seen
+struct HandleInfo {
+    PLI_INT32 type = vpiUndefined;
+    uint32_t width = 0;
+    // only set for mock slice handles
+    vpiHandle parent = nullptr;
+    uint32_t hi = 0;
+    uint32_t lo = 0;
+
+    [[nodiscard]] bool is_slice() const { return parent != nullptr; }
+};
+
+// open-addressing hash table keyed by vpiHandle. entries are immutable once inserted, so
+// lookups are lock-free. inserts are serialized and grow the table by rehashing into a new one;
+// old tables are kept alive so that concurrent readers never see freed memory
+template <typename T>
+class HandleTable {
+public:
+    HandleTable() {
+        tables_.emplace_back(std::make_unique<Table>(initial_capacity));
+        table_.store(tables_.back().get(), std::memory_order_release);
+    }
+
+    [[nodiscard]] const T *find(vpiHandle handle) const {
+        const auto *table = table_.load(std::memory_order_acquire);
+        auto index = hash(handle) & table->mask;
+        while (true) {
+            auto const &entry = table->entries[index];
+            auto *entry_handle = entry.handle.load(std::memory_order_acquire);
+            if (entry_handle == handle) [[likely]] {
+                return &entry.value;
+            }
+            if (!entry_handle) return nullptr;
+            index = (index + 1) & table->mask;
+        }
+    }
+
+    // returns the existing entry if the handle has been inserted already
+    const T *insert(vpiHandle handle, const T &value) {
+        if (!handle) [[unlikely]] {
+            return nullptr;
+        }
+        std::lock_guard guard(lock_);
+        // someone else may have inserted it already
+        if (const auto *existing = find(handle)) {
+            return existing;
+        }
+        auto *table = table_.load(std::memory_order_relaxed);
+        auto size = size_.load(std::memory_order_relaxed);
+        // keep the load factor under 0.5
+        if ((size + 1) * 2 > table->mask + 1) [[unlikely]] {
+            auto new_table = std::make_unique<Table>((table->mask + 1) * 2);
+            for (uint64_t i = 0; i <= table->mask; i++) {
+                auto const &entry = table->entries[i];
+                auto *entry_handle = entry.handle.load(std::memory_order_relaxed);
+                if (entry_handle) emplace_entry(new_table.get(), entry_handle, entry.value);
+            }
+            // readers may still hold the old table, so it stays alive
+            table = new_table.get();
+            tables_.emplace_back(std::move(new_table));
+            table_.store(table, std::memory_order_release);
+        }
+        auto *entry = emplace_entry(table, handle, value);
+        size_.store(size + 1, std::memory_order_relaxed);
+        return &entry->value;
+    }
+
+    [[nodiscard]] uint64_t size() const { return size_.load(std::memory_order_relaxed); }
+
+    static constexpr uint64_t initial_capacity = 1024;
+
+private:
+    struct Entry {
+        std::atomic<vpiHandle> handle;
+        T value;
+    };
+    struct Table {
+        explicit Table(uint64_t capacity)
+            : entries(std::make_unique<Entry[]>(capacity)), mask(capacity - 1) {}
+        std::unique_ptr<Entry[]> entries;
+        uint64_t mask;
+    };
+
+    std::atomic<Table *> table_;
+    std::vector<std::unique_ptr<Table>> tables_;
+    std::atomic<uint64_t> size_ = 0;
+    std::mutex lock_;
+
+    static uint64_t hash(vpiHandle handle) {
+        // pointers are aligned and mock handles are sequential, so mix the bits
+        auto value = reinterpret_cast<uint64_t>(handle);
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccd;
+        value ^= value >> 33;
+        return value;
+    }
+
+    static Entry *emplace_entry(Table *table, vpiHandle handle, const T &value) {
+        auto index = hash(handle) & table->mask;
+        while (table->entries[index].handle.load(std::memory_order_relaxed)) {
+            index = (index + 1) & table->mask;
+        }
+        auto &entry = table->entries[index];
+        // the value has to be visible before the handle is published to readers
+        entry.value = value;
+        entry.handle.store(handle, std::memory_order_release);
+        return &entry;
+    }
+};
+
 class RTLSimulatorClient {
 public:
     explicit RTLSimulatorClient(std::unique_ptr<AVPIProvider> vpi);
@@ -82,6 +196,9 @@ public:
     vpiHandle get_handle(const std::string &name);
     vpiHandle get_handle(const std::vector<std::string> &tokens);
     bool is_valid_signal(const std::string &name);
+    // resolve handles for all the given signals with a single walk of the design hierarchy
+    // returns the number of signals resolved. unresolved signals use the lazy lookup
+    uint64_t index_signals(const std::vector<std::string> &names);
     std::optional<int64_t> get_value(const std::string &name);
     std::optional<int64_t> get_value(vpiHandle handle);
     std::optional<std::string> get_str_value(const std::string &name);
@@ -116,6 +233,7 @@ public:
     // add monitors on signals
     [[nodiscard]] bool monitor_signals(const std::vector<std::string> &signals,
                                        int(cb_func)(p_cb_data), void *user_data);
+    void unmonitor_signals(const std::vector<std::string> &signals);
 
     // callback related
     [[nodiscard]] std::unordered_set<std::string> callback_names();
@@ -136,6 +254,12 @@ public:
 
     // inform user about our mapping
     [[nodiscard]] std::unordered_map<std::string, std::string> get_top_mapping() const;
+    // restore a previously computed mapping, e.g. from the name cache
+    void set_top_mapping(const std::unordered_map<std::string, std::string> &mapping);
+    [[nodiscard]] std::vector<std::string> get_top_module_names();
+    // validity of every signal queried through is_valid_signal, indexed by full name
+    [[nodiscard]] std::unordered_map<std::string, bool> get_signal_validity();
+    void set_signal_validity(const std::unordered_map<std::string, bool> &signals);
 
 private:
     std::unordered_map<std::string, vpiHandle> handle_map_;
@@ -149,10 +273,10 @@ private:
     // callbacks
     std::unordered_map<std::string, vpiHandle> cb_handles_;
     std::mutex cb_handles_lock_;
-    std::unordered_map<vpiHandle, PLI_INT32> cached_vpi_types_;
-    std::mutex cached_vpi_types_lock_;
-    std::unordered_map<vpiHandle, uint32_t> cached_vpi_size_;
-    std::mutex cached_vpi_size_lock_;
+    // type, width, and slice information for every handle we have seen
+    HandleTable<HandleInfo> handle_table_;
+    std::unordered_map<std::string, bool> signal_validity_;
+    std::mutex signal_validity_lock_;
 
     // cached module signals
     // this is to avoid to loop through instances repeatedly
@@ -160,8 +284,7 @@ private:
 
     // notice that to my best knowledge, there is no command VPI routine that shared by all
     // simulator vendors that deal with slices. As a result, we need to fake vpiHandles to deal
-    // with slices
-    std::unordered_map<vpiHandle, std::tuple<vpiHandle, uint32_t, uint32_t>> mock_slice_handles_;
+    // with slices. slice information is stored in the handle table
     vpiHandle mock_slice_handle_counter_ = nullptr;
     std::optional<std::function<vpiHandle()>> vpi_allocator_;
 
@@ -188,8 +311,8 @@ private:
     vpiHandle access_arrays(StringIterator begin, StringIterator end, vpiHandle var_handle);
 
     // cached helper methods
-    PLI_INT32 get_vpi_type(vpiHandle handle);
-    uint32_t get_vpi_size(vpiHandle handle);
+    const HandleInfo *get_handle_info(vpiHandle handle);
+    PLI_INT32 get_vpi_type(vpiHandle handle) { return get_handle_info(handle)->type; }
 
     // other helper functions
     void remove_call_back(vpiHandle cb_handle);
@@ -1,5 +1,7 @@
 #include "scheduler.hh"
 
+#include <algorithm>
+
 #include "fmt/format.h"
 #include "log.hh"
 #include "util.hh"
@@ -18,12 +20,13 @@ Scheduler::Scheduler(RTLSimulatorClient *rtl, DebugDatabaseClient *db,
 
     // compute clock signals
     // compute the clock signals
-    auto clk_names = util::get_clock_signals(rtl_, db_);
-    clock_handles_.reserve(clk_names.size());
-    for (auto const &clk_name : clk_names) {
+    clock_names_ = util::get_clock_signals(rtl_, db_);
+    clock_handles_.reserve(clock_names_.size());
+    for (auto const &clk_name : clock_names_) {
         auto *handle = rtl_->get_handle(clk_name);
         if (handle) clock_handles_.emplace_back(handle);
     }
+    compute_annotated_clock_domains();
 }
 
 std::vector<DebugBreakPoint *> Scheduler::next_breakpoints() {
@@ -108,6 +111,12 @@ std::vector<DebugBreakPoint *> Scheduler::next_normal_breakpoints() {
         }
     }
 
+    // skip breakpoints from other clock domains
+    while (index < breakpoints_.size() && !in_current_clock_domain(breakpoints_[index].get())) {
+        index++;
+    }
+    if (index == breakpoints_.size()) return {};
+
     std::vector<DebugBreakPoint *> result{breakpoints_[index].get()};
 
     // by default we generates as many breakpoints as possible to evaluate
@@ -238,9 +247,10 @@ DebugBreakPoint *Scheduler::create_next_breakpoint(const std::optional<BreakPoin
     return &next_temp_breakpoint_;
 }
 
-void Scheduler::start_breakpoint_evaluation() {
+void Scheduler::start_breakpoint_evaluation(std::optional<uint32_t> clock_domain) {
     evaluated_ids_.clear();
     current_breakpoint_id_ = std::nullopt;
+    current_clock_domain_ = clock_domain;
 }
 
 void Scheduler::set_evaluation_mode(EvaluationMode mode) {
@@ -262,7 +272,8 @@ std::vector<std::string> compute_trigger_symbol(const BreakPoint &bp) {
     return tokens;
 }
 
-void Scheduler::add_breakpoint(const BreakPoint &bp_info, const BreakPoint &db_bp) {
+void Scheduler::add_breakpoint(const BreakPoint &bp_info, const BreakPoint &db_bp,
+                               uint64_t ignore_count, uint64_t hit_every) {
     // add them to the eval vector
     std::string cond = "1";
     if (!db_bp.condition.empty()) cond = db_bp.condition;
@@ -280,6 +291,9 @@ void Scheduler::add_breakpoint(const BreakPoint &bp_info, const BreakPoint &db_b
         bp->line_num = db_bp.line_num;
         bp->column_num = db_bp.column_num;
         bp->trigger_symbols = compute_trigger_symbol(db_bp);
+        bp->clock_domain = get_clock_domain(*db_bp.instance_id);
+        bp->ignore_count = ignore_count;
+        bp->hit_every = hit_every;
         breakpoints_.emplace_back(std::move(bp));
         inserted_breakpoints_.emplace(db_bp.id);
         util::validate_expr(rtl_, db_, breakpoints_.back()->expr.get(), db_bp.id,
@@ -301,6 +315,9 @@ void Scheduler::add_breakpoint(const BreakPoint &bp_info, const BreakPoint &db_b
                 if (!b->expr->correct()) [[unlikely]] {
                     log_error("Unable to validate breakpoint expression: " + cond);
                 }
+                b->ignore_count = ignore_count;
+                b->hit_every = hit_every;
+                b->hit_count = 0;
                 return;
             }
         }
@@ -348,11 +365,93 @@ std::vector<BreakPoint> Scheduler::get_current_breakpoints() {
     return bps;
 }
 
+std::optional<uint64_t> Scheduler::earliest_breakpoint_time() {
+    std::lock_guard guard(breakpoint_lock_);
+    if (breakpoints_.empty()) return std::nullopt;
+    std::optional<int64_t> result;
+    for (auto const &bp : breakpoints_) {
+        auto time = bp->expr->lower_bound(util::time_var_name);
+        if (!time) return std::nullopt;
+        result = result ? std::min(*result, *time) : *time;
+    }
+    if (*result <= 0) return std::nullopt;
+    return static_cast<uint64_t>(*result);
+}
+
 bool Scheduler::breakpoint_only() const {
     return evaluation_mode_ == EvaluationMode::BreakPointOnly ||
            evaluation_mode_ == EvaluationMode::ReverseBreakpointOnly;
 }
 
+void Scheduler::compute_annotated_clock_domains() {
+    if (clock_names_.size() <= 1) return;
+    auto values = db_->get_annotation_values(util::clock_domain_annotation);
+    for (auto const &value : values) {
+        auto tokens = util::get_tokens(value, " ");
+        if (tokens.size() != 2) {
+            log_error("Invalid clock domain annotation: " + value);
+            continue;
+        }
+        auto instance_name = rtl_->get_full_name(tokens[0]);
+        auto clock_name = rtl_->get_full_name(tokens[1]);
+        auto pos = std::find(clock_names_.begin(), clock_names_.end(), clock_name);
+        if (pos == clock_names_.end()) {
+            log_error("Unknown clock in clock domain annotation: " + value);
+            continue;
+        }
+        auto domain = static_cast<uint32_t>(std::distance(clock_names_.begin(), pos));
+        annotated_clock_domains_.emplace_back(instance_name, domain);
+    }
+}
+
+// true if name is the prefix instance itself or one of its children
+bool in_hierarchy(const std::string &name, const std::string &prefix) {
+    return name.starts_with(prefix) && (name.size() == prefix.size() || name[prefix.size()] == '.');
+}
+
+std::optional<uint32_t> Scheduler::get_clock_domain(uint32_t instance_id) {
+    // single clock design doesn't need partitioning
+    if (clock_names_.size() <= 1) return std::nullopt;
+    if (instance_clock_domains_.find(instance_id) != instance_clock_domains_.end()) {
+        return instance_clock_domains_.at(instance_id);
+    }
+    std::optional<uint32_t> result;
+    auto instance_name = db_->get_instance_name(instance_id);
+    if (instance_name) {
+        auto full_name = rtl_->get_full_name(*instance_name);
+        // annotation has higher priority. use the most specific one
+        uint64_t longest_match = 0;
+        for (auto const &[prefix, domain] : annotated_clock_domains_) {
+            if (in_hierarchy(full_name, prefix) && prefix.size() > longest_match) {
+                longest_match = prefix.size();
+                result = domain;
+            }
+        }
+        if (!result) {
+            // otherwise the clock declared in the closest parent instance. if several clocks
+            // are declared in the same instance, we can't tell which one drives it
+            bool ambiguous = false;
+            for (auto i = 0u; i < clock_names_.size(); i++) {
+                auto const &clock_name = clock_names_[i];
+                auto pos = clock_name.find_last_of('.');
+                if (pos == std::string::npos) continue;
+                auto parent_name = clock_name.substr(0, pos);
+                if (!in_hierarchy(full_name, parent_name)) continue;
+                if (parent_name.size() > longest_match) {
+                    longest_match = parent_name.size();
+                    result = i;
+                    ambiguous = false;
+                } else if (parent_name.size() == longest_match) {
+                    ambiguous = true;
+                }
+            }
+            if (ambiguous) result = std::nullopt;
+        }
+    }
+    instance_clock_domains_.emplace(instance_id, result);
+    return result;
+}
+
 void Scheduler::log_error(const std::string &msg) { log::log(log::log_level::error, msg); }
 
 void Scheduler::log_info(const std::string &msg) const {
@@ -382,7 +481,8 @@ void Scheduler::scan_breakpoints(uint64_t ref_index, bool forward,
         }
         // same enable expression but different instance id
         if (next_bp->instance_id != ref_bp->instance_id &&
-            next_bp->enable_expr->expression() == target_expr) {
+            next_bp->enable_expr->expression() == target_expr &&
+            in_current_clock_domain(next_bp.get())) {
             result.emplace_back(next_bp.get());
         }
         return true;
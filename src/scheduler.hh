@@ -1,6 +1,7 @@
 #ifndef HGDB_SCHEDULER_HH
 #define HGDB_SCHEDULER_HH
 
+#include <atomic>
 #include <mutex>
 
 #include "db.hh"
@@ -22,6 +23,15 @@ struct DebugBreakPoint {
     // second table stores the seen value
     std::vector<std::string> trigger_symbols;
     std::unordered_map<std::string, int64_t> trigger_values;
+    // index of the clock whose posedge evaluates this breakpoint.
+    // if not set, the breakpoint is evaluated at every clock edge
+    std::optional<uint32_t> clock_domain;
+    // hit policy. hits are counted when the condition holds. the simulator only pauses after
+    // ignore_count hits, and then on every hit_every-th hit. the policy can be changed while
+    // the breakpoint is being evaluated
+    std::atomic<uint64_t> ignore_count = 0;
+    std::atomic<uint64_t> hit_every = 1;
+    std::atomic<uint64_t> hit_count = 0;
 };
 
 class Scheduler {
@@ -34,21 +44,35 @@ public:
     std::vector<DebugBreakPoint *> next_normal_breakpoints();
     DebugBreakPoint *next_step_back_breakpoint();
     std::vector<DebugBreakPoint *> next_reverse_breakpoints();
-    void start_breakpoint_evaluation();
+    // if clock domain is set, only breakpoints in that domain are scheduled
+    void start_breakpoint_evaluation(std::optional<uint32_t> clock_domain = std::nullopt);
 
     // change scheduling semantics
     void set_evaluation_mode(EvaluationMode mode);
     void clear();
 
     // handle breakpoints
-    void add_breakpoint(const BreakPoint &bp_info, const BreakPoint &db_bp);
+    // hit counts restart whenever the breakpoint is updated
+    void add_breakpoint(const BreakPoint &bp_info, const BreakPoint &db_bp,
+                        uint64_t ignore_count = 0, uint64_t hit_every = 1);
     void reorder_breakpoints();
     void remove_breakpoint(const BreakPoint &bp);
+    // holds the breakpoint lock across several updates. the lock is re-entrant
+    [[nodiscard]] std::unique_lock<std::recursive_mutex> lock_breakpoints() {
+        return std::unique_lock(breakpoint_lock_);
+    }
     // getter. not exposing all the information
     std::vector<BreakPoint> get_current_breakpoints();
+    // earliest time any breakpoint can trigger, if every breakpoint condition is guarded by
+    // the simulation time
+    std::optional<uint64_t> earliest_breakpoint_time();
 
     // breakpoint mode
     bool breakpoint_only() const;
+    [[nodiscard]] EvaluationMode evaluation_mode() const { return evaluation_mode_; }
+
+    // each clock is a clock domain, indexed by its position
+    [[nodiscard]] const std::vector<std::string> &clock_signals() const { return clock_names_; }
 
 private:
     std::unordered_set<uint32_t> evaluated_ids_;
@@ -61,7 +85,7 @@ private:
     // look up table for ordering of breakpoints
     std::unordered_map<uint32_t, uint64_t> bp_ordering_table_;
     // need to ensure there is no concurrent modification
-    std::mutex breakpoint_lock_;
+    std::recursive_mutex breakpoint_lock_;
     // holder for step over breakpoint, not used for normal purpose
     DebugBreakPoint next_temp_breakpoint_;
 
@@ -75,6 +99,19 @@ private:
 
     // cache clock handles as well
     std::vector<vpiHandle> clock_handles_;
+    std::vector<std::string> clock_names_;
+
+    // clock domain partitioning
+    // instance name prefix -> clock domain, from symbol table annotations
+    std::vector<std::pair<std::string, uint32_t>> annotated_clock_domains_;
+    std::unordered_map<uint32_t, std::optional<uint32_t>> instance_clock_domains_;
+    std::optional<uint32_t> current_clock_domain_;
+    void compute_annotated_clock_domains();
+    std::optional<uint32_t> get_clock_domain(uint32_t instance_id);
+    [[nodiscard]] bool in_current_clock_domain(const DebugBreakPoint *bp) const {
+        return !current_clock_domain_ || !bp->clock_domain ||
+               *bp->clock_domain == *current_clock_domain_;
+    }
 
     DebugBreakPoint *create_next_breakpoint(const std::optional<BreakPoint> &bp_info);
 
@@ -89,6 +126,8 @@ private:
 namespace util {
 constexpr auto time_var_name = "$time";
 constexpr auto instance_var_name = "$instance";
+// annotation value is "instance_name clock_name"
+constexpr auto clock_domain_annotation = "clock_domain";
 
 void validate_expr(RTLSimulatorClient *rtl, DebugDatabaseClient *db, DebugExpression *expr,
                    std::optional<uint32_t> breakpoint_id, std::optional<uint32_t> instance_id);
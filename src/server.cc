@@ -1,5 +1,7 @@
 #include "server.hh"
 
+#include <thread>
+
 namespace hgdb {
 
 using raw_message = WSServer::message_ptr;
@@ -23,6 +25,12 @@ DebugServer::DebugServer(bool enable_logging) {
         auto id = get_new_channel_id();
         connections_.emplace(id, conn);
         connection_id_map_.emplace(conn.get(), id);
+        // only set if the client offered the extension
+        auto extensions = conn->get_response_header("Sec-WebSocket-Extensions");
+        if (extensions.find("permessage-deflate") != std::string::npos) {
+            deflate_connections_.emplace(id);
+        }
+        update_connection_count();
     };
     // on disconnection
     auto on_disconnect = [this](websocketpp::connection_hdl hdl) {
@@ -33,9 +41,12 @@ DebugServer::DebugServer(bool enable_logging) {
             if (conn == c) {
                 connections_.erase(id);
                 connection_id_map_.erase(conn.get());
+                binary_connections_.erase(id);
+                deflate_connections_.erase(id);
                 break;
             }
         }
+        update_connection_count();
         if (connections_.empty() && on_all_client_disconnect_) {
             (*on_all_client_disconnect_)();
         }
@@ -47,12 +58,22 @@ DebugServer::DebugServer(bool enable_logging) {
 
     // initialize Asio
     server_.init_asio();
+    ordered_strand_ = std::make_unique<Strand>(server_.get_io_service());
+    send_strand_ = std::make_unique<Strand>(server_.get_io_service());
 }
 
 void DebugServer::run(uint16_t port) {
     server_.listen(port);
     server_.start_accept();
+    // websocketpp wraps each connection in its own strand, so the handlers of a single
+    // connection never run concurrently
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads_ - 1);
+    for (auto i = 1u; i < num_threads_; i++) {
+        threads.emplace_back([this]() { server_.run(); });
+    }
     server_.run();
+    for (auto &t : threads) t.join();
 }
 
 void DebugServer::stop() {
@@ -65,43 +86,181 @@ void DebugServer::stop() {
         }
         connections_.clear();
         connection_id_map_.clear();
+        binary_connections_.clear();
+        deflate_connections_.clear();
+        update_connection_count();
     }
     server_.stop();
 }
 
-void DebugServer::send(const std::string &payload) {
-    for (const auto &[id, conn] : connections_) {
-        conn->send(payload);
+void DebugServer::send(std::string payload, MessageKind kind, bool binary) {
+    enqueue(OutboundMessage{.payload = std::move(payload), .kind = kind, .binary = binary});
+}
+
+void DebugServer::send(std::string payload, const std::string &topic, MessageKind kind,
+                       bool binary) {
+    enqueue(OutboundMessage{
+        .payload = std::move(payload), .kind = kind, .binary = binary, .topic = topic});
+}
+
+void DebugServer::send(std::string payload, uint64_t conn_id, bool binary) {
+    enqueue(OutboundMessage{.payload = std::move(payload), .binary = binary, .conn_id = conn_id});
+}
+
+void DebugServer::enqueue(OutboundMessage message) {
+    send_queue_.push(std::move(message));
+    // only schedule one drain at a time
+    if (!drain_scheduled_.exchange(true)) {
+        websocketpp::lib::asio::post(*send_strand_, [this]() { drain_send_queue(); });
     }
 }
 
-void DebugServer::send(const std::string &payload, const std::string &topic) {
-    if (topics_.find(topic) != topics_.end()) [[likely]] {
-        auto const &ids = topics_.at(topic);
+auto &message_manager() {
+    using manager_type = WSServer::message_type::con_msg_man_type;
+    static auto manager = std::make_shared<manager_type>();
+    return manager;
+}
+
+// builds a ready-to-write frame. server frames are never masked, so the same frame can be
+// written to every connection and websocketpp won't copy the payload for each of them
+WSServer::message_ptr prepare_frame(std::string payload, bool binary) {
+    using namespace websocketpp;
+    auto opcode = binary ? frame::opcode::binary : frame::opcode::text;
+    auto message = message_manager()->get_message(opcode, 0);
+    auto size = payload.size();
+    message->get_raw_payload() = std::move(payload);
+    auto header = frame::basic_header(opcode, size, true, false);
+    message->set_header(frame::prepare_header(header, frame::extended_header(size)));
+    message->set_prepared(true);
+    return message;
+}
+
+// the deflate context belongs to each connection, so compressed frames are built by the
+// connection when it writes the message. the message itself is never modified and can still be
+// shared by all compressed connections
+WSServer::message_ptr prepare_deflate_frame(const std::string &payload, bool binary) {
+    using namespace websocketpp;
+    auto opcode = binary ? frame::opcode::binary : frame::opcode::text;
+    auto message = message_manager()->get_message(opcode, payload.size());
+    message->set_payload(payload);
+    message->set_compressed(true);
+    return message;
+}
+
+void DebugServer::drain_send_queue() {
+    // reset before draining so that messages pushed from now on schedule another drain
+    drain_scheduled_.store(false);
+    std::lock_guard guard(connections_lock_);
+    while (auto message = send_queue_.pop()) {
+        deliver(std::move(*message));
+    }
+
+    // flush coalesced monitor messages once the connection catches up
+    for (auto it = pending_monitor_messages_.begin(); it != pending_monitor_messages_.end();) {
+        auto conn = connections_.find(it->first);
+        if (conn == connections_.end()) {
+            it = pending_monitor_messages_.erase(it);
+        } else if (conn->second->get_buffered_amount() <= high_water_mark_) {
+            conn->second->send(it->second);
+            it = pending_monitor_messages_.erase(it);
+        } else {
+            it++;
+        }
+    }
+    if (!pending_monitor_messages_.empty() && !flush_timer_set_) {
+        constexpr auto retry_ms = 10;
+        flush_timer_set_ = true;
+        server_.set_timer(retry_ms, [this](const websocketpp::lib::error_code &ec) {
+            websocketpp::lib::asio::post(*send_strand_, [this, ec]() {
+                flush_timer_set_ = false;
+                if (!ec && !drain_scheduled_.exchange(true)) drain_send_queue();
+            });
+        });
+    }
+}
+
+void DebugServer::deliver(OutboundMessage message) {
+    auto size = message.payload.size();
+    // serialize once. every receiver shares the same frame
+    auto frame = prepare_frame(std::move(message.payload), message.binary);
+    // small messages are never compressed to keep their latency
+    WSServer::message_ptr deflate_frame;
+    auto threshold = compression_threshold_.load();
+    if (threshold >= 0 && size >= static_cast<uint64_t>(threshold) &&
+        !deflate_connections_.empty()) [[unlikely]] {
+        deflate_frame = prepare_deflate_frame(frame->get_payload(), message.binary);
+    }
+    auto frame_for = [this, &frame, &deflate_frame](uint64_t id) -> const WSServer::message_ptr & {
+        return deflate_frame && deflate_connections_.contains(id) ? deflate_frame : frame;
+    };
+    // broadcast messages are encoded once per format
+    auto match = [this, &message](uint64_t id) {
+        return binary_connections_.contains(id) == message.binary;
+    };
+    if (message.conn_id) {
+        auto conn = connections_.find(*message.conn_id);
+        if (conn != connections_.end()) [[likely]] {
+            deliver(conn->first, conn->second, frame_for(conn->first), message.kind);
+        }
+    } else if (message.topic) {
+        auto ids = topics_.find(*message.topic);
+        if (ids == topics_.end()) [[unlikely]] {
+            return;
+        }
         // to ensure high performance during runtime, we don't do clean up
         // even through the channel is closed, which we assume happens infrequently
-        for (auto const id : ids) {
-            if (connections_.find(id) != connections_.end()) [[likely]] {
-                connections_.at(id)->send(payload);
+        for (auto const id : ids->second) {
+            auto conn = connections_.find(id);
+            if (conn != connections_.end() && match(id)) [[likely]] {
+                deliver(conn->first, conn->second, frame_for(id), message.kind);
             }
         }
+    } else {
+        for (auto const &[id, conn] : connections_) {
+            if (match(id)) deliver(id, conn, frame_for(id), message.kind);
+        }
     }
 }
 
-void DebugServer::send(const std::string &payload, uint64_t conn_id) {
-    if (connections_.find(conn_id) != connections_.end()) [[likely]] {
-        connections_.at(conn_id)->send(payload);
+void DebugServer::deliver(uint64_t conn_id, const Connection &conn,
+                          const WSServer::message_ptr &frame, MessageKind kind) {
+    if (kind == MessageKind::monitor) {
+        auto congested = conn->get_buffered_amount() > high_water_mark_;
+        if (congested) {
+            // either way the client misses some value changes
+            monitor_message_dropped_ = true;
+            if (overflow_policy_ == OverflowPolicy::coalesce) {
+                // only keep the latest one
+                pending_monitor_messages_[conn_id] = frame;
+            }
+            return;
+        }
+        // keep the order of monitor messages
+        auto pending = pending_monitor_messages_.find(conn_id);
+        if (pending != pending_monitor_messages_.end()) [[unlikely]] {
+            conn->send(pending->second);
+            pending_monitor_messages_.erase(pending);
+        }
     }
+    conn->send(frame);
 }
 
 void DebugServer::set_on_message(
     const std::function<void(const std::string &, uint64_t)> &callback) {
     auto on_message = [this, callback](const websocketpp::connection_hdl &hdl,
                                        const raw_message &msg) {
-        auto str = msg->get_payload();
         auto conn = server_.get_con_from_hdl(hdl);
-        auto id = connection_id_map_.at(conn.get());
-        callback(str, id);
+        uint64_t id;
+        {
+            std::lock_guard guard(connections_lock_);
+            auto it = connection_id_map_.find(conn.get());
+            // the server is shutting down
+            if (it == connection_id_map_.end()) [[unlikely]] {
+                return;
+            }
+            id = it->second;
+        }
+        callback(msg->get_payload(), id);
     };
     server_.set_message_handler(on_message);
 }
@@ -111,15 +270,42 @@ void DebugServer::set_on_call_client_disconnect(const std::function<void()> &fun
 }
 
 void DebugServer::add_to_topic(const std::string &topic, uint64_t conn_id) {
+    std::lock_guard guard(connections_lock_);
     topics_[topic].emplace(conn_id);
 }
 
 void DebugServer::remove_from_topic(const std::string &topic, uint64_t conn_id) {
+    std::lock_guard guard(connections_lock_);
     if (topics_[topic].find(conn_id) != topics_[topic].end()) {
         topics_[topic].erase(conn_id);
     }
 }
 
+void DebugServer::post_ordered(std::function<void()> task) {
+    websocketpp::lib::asio::post(*ordered_strand_, std::move(task));
+}
+
+void DebugServer::set_binary(uint64_t conn_id, bool binary) {
+    std::lock_guard guard(connections_lock_);
+    if (binary) {
+        binary_connections_.emplace(conn_id);
+    } else {
+        binary_connections_.erase(conn_id);
+    }
+    update_connection_count();
+}
+
+bool DebugServer::is_binary(uint64_t conn_id) {
+    std::lock_guard guard(connections_lock_);
+    return binary_connections_.contains(conn_id);
+}
+
+void DebugServer::update_connection_count() {
+    // assume we are under lock guard's protection
+    num_binary_connections_ = binary_connections_.size();
+    num_connections_ = connections_.size();
+}
+
 uint64_t DebugServer::get_new_channel_id() {
     // assume we are under lock guard's protection
     return channel_count_++;
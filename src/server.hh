@@ -1,43 +1,174 @@
 #ifndef HGDB_SERVER_HH
 #define HGDB_SERVER_HH
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <mutex>
 #include <optional>
 #include <unordered_map>
 #include <unordered_set>
 
+#include "thread.hh"
 #include "websocketpp/config/asio_no_tls.hpp"
+#include "websocketpp/extensions/permessage_deflate/enabled.hpp"
 #include "websocketpp/server.hpp"
 
 namespace hgdb {
 
-using WSServer = websocketpp::server<websocketpp::config::asio>;
+// default asio config with permessage-deflate turned on. the extension is only used if the
+// client asks for it during the handshake
+struct DeflateConfig : public websocketpp::config::asio {
+    using type = DeflateConfig;
+    using base = websocketpp::config::asio;
+
+    using concurrency_type = base::concurrency_type;
+    using request_type = base::request_type;
+    using response_type = base::response_type;
+    using message_type = base::message_type;
+    using con_msg_manager_type = base::con_msg_manager_type;
+    using endpoint_msg_manager_type = base::endpoint_msg_manager_type;
+    using alog_type = base::alog_type;
+    using elog_type = base::elog_type;
+    using rng_type = base::rng_type;
+
+    struct transport_config : public base::transport_config {
+        using concurrency_type = type::concurrency_type;
+        using alog_type = type::alog_type;
+        using elog_type = type::elog_type;
+        using request_type = type::request_type;
+        using response_type = type::response_type;
+        using socket_type = websocketpp::transport::asio::basic_socket::endpoint;
+    };
+    using transport_type = websocketpp::transport::asio::endpoint<transport_config>;
+
+    struct permessage_deflate_config {};
+    using permessage_deflate_type =
+        websocketpp::extensions::permessage_deflate::enabled<permessage_deflate_config>;
+};
+
+using WSServer = websocketpp::server<DeflateConfig>;
 using Connection = WSServer::connection_ptr;
 
+// transport used by the debugger to talk to its clients
+class ADebugServer {
+public:
+    // monitor traffic can be dropped or coalesced when a client can't keep up
+    enum class MessageKind { normal, monitor };
+    enum class OverflowPolicy { drop, coalesce };
+
+    // port is ignored by transports that don't listen on a socket
+    virtual void run(uint16_t port) = 0;
+    virtual void stop() = 0;
+    // payloads are taken by value so serialized responses can be moved all the way into the
+    // outgoing frame. binary payloads are only broadcast to connections that use a binary
+    // protocol and text payloads only to the rest
+    virtual void send(std::string payload, MessageKind kind = MessageKind::normal,
+                      bool binary = false) = 0;
+    virtual void send(std::string payload, const std::string &topic,
+                      MessageKind kind = MessageKind::normal, bool binary = false) = 0;
+    virtual void send(std::string payload, uint64_t conn_id, bool binary = false) = 0;
+    // the callback may be invoked from several threads at once
+    virtual void set_on_message(
+        const std::function<void(const std::string &, uint64_t conn_id)> &callback) = 0;
+    virtual void set_on_call_client_disconnect(const std::function<void(void)> &func) = 0;
+    virtual void add_to_topic(const std::string &topic, uint64_t conn_id) = 0;
+    virtual void remove_from_topic(const std::string &topic, uint64_t conn_id) = 0;
+    // ordered executor. tasks run one at a time in the order they are posted
+    virtual void post_ordered(std::function<void()> task) = 0;
+
+    // wire format negotiated by each connection
+    virtual void set_binary(uint64_t conn_id, bool binary) = 0;
+    virtual bool is_binary(uint64_t conn_id) = 0;
+    // used to avoid serializing messages nobody will receive
+    bool has_text_connections() const { return num_connections_ > num_binary_connections_; }
+    bool has_binary_connections() const { return num_binary_connections_ > 0; }
+
+    // backpressure settings. high water mark is the number of bytes buffered in a connection
+    void set_high_water_mark(uint64_t bytes) { high_water_mark_ = bytes; }
+    void set_overflow_policy(OverflowPolicy policy) { overflow_policy_ = policy; }
+    // messages at least this large are compressed for connections that negotiated compression.
+    // negative value turns compression off. ignored by transports without compression
+    void set_compression_threshold(int64_t bytes) { compression_threshold_ = bytes; }
+    // true if any monitor message was dropped or replaced since the last call. monitor values
+    // need to be re-sent in full since they are sent as deltas
+    bool monitor_message_dropped() { return monitor_message_dropped_.exchange(false); }
+
+    static constexpr uint64_t default_high_water_mark = 1 << 20;
+    static constexpr int64_t default_compression_threshold = 16 << 10;
+
+    virtual ~ADebugServer() = default;
+
+protected:
+    std::atomic<uint64_t> high_water_mark_ = default_high_water_mark;
+    std::atomic<int64_t> compression_threshold_ = default_compression_threshold;
+    std::atomic<OverflowPolicy> overflow_policy_ = OverflowPolicy::drop;
+    std::atomic<bool> monitor_message_dropped_ = false;
+    std::atomic<uint64_t> num_connections_ = 0;
+    std::atomic<uint64_t> num_binary_connections_ = 0;
+};
+
 // wrapper for thee websocket
-class DebugServer {
+// all sends are queued and delivered by the asio threads, so callers never block on the network.
+// incoming messages are handled by a small pool of asio threads
+class DebugServer : public ADebugServer {
 public:
     explicit DebugServer();
     explicit DebugServer(bool enable_logging);
-    void run(uint16_t port);
-    void stop();
-    void send(const std::string &payload);
-    void send(const std::string &payload, const std::string &topic);
-    void send(const std::string &payload, uint64_t conn_id);
-    void set_on_message(const std::function<void(const std::string &, uint64_t conn_id)> &callback);
-    void set_on_call_client_disconnect(const std::function<void(void)> &func);
-    void add_to_topic(const std::string &topic, uint64_t conn_id);
-    void remove_from_topic(const std::string &topic, uint64_t conn_id);
+    // has to be set before run
+    void set_num_threads(uint32_t num_threads) { num_threads_ = std::max(num_threads, 1u); }
+    void run(uint16_t port) override;
+    void stop() override;
+    void send(std::string payload, MessageKind kind = MessageKind::normal,
+              bool binary = false) override;
+    void send(std::string payload, const std::string &topic,
+              MessageKind kind = MessageKind::normal, bool binary = false) override;
+    void send(std::string payload, uint64_t conn_id, bool binary = false) override;
+    void set_on_message(
+        const std::function<void(const std::string &, uint64_t conn_id)> &callback) override;
+    void set_on_call_client_disconnect(const std::function<void(void)> &func) override;
+    void add_to_topic(const std::string &topic, uint64_t conn_id) override;
+    void remove_from_topic(const std::string &topic, uint64_t conn_id) override;
+    void post_ordered(std::function<void()> task) override;
+
+    void set_binary(uint64_t conn_id, bool binary) override;
+    bool is_binary(uint64_t conn_id) override;
+
+    static constexpr uint32_t default_num_threads = 4;
 
 private:
-    using ConnectionPtr = websocketpp::connection<websocketpp::config::asio> *;
+    using ConnectionPtr = websocketpp::connection<DeflateConfig> *;
+    using Strand = websocketpp::lib::asio::io_service::strand;
     WSServer server_;
+    uint32_t num_threads_ = default_num_threads;
+    // runs the ordered tasks
+    std::unique_ptr<Strand> ordered_strand_;
+    // serializes the send queue drains
+    std::unique_ptr<Strand> send_strand_;
 
-    // active connections
+    struct OutboundMessage {
+        std::string payload;
+        MessageKind kind = MessageKind::normal;
+        bool binary = false;
+        // if neither is set, the message is sent to every connection
+        std::optional<uint64_t> conn_id;
+        std::optional<std::string> topic;
+    };
+    MPSCQueue<OutboundMessage> send_queue_;
+    std::atomic<bool> drain_scheduled_ = false;
+    // only accessed from the send strand
+    std::unordered_map<uint64_t, WSServer::message_ptr> pending_monitor_messages_;
+    bool flush_timer_set_ = false;
+
+    // active connections and topics
     std::mutex connections_lock_;
     std::unordered_map<uint64_t, Connection> connections_;
     // reverted map for connection id
     std::unordered_map<ConnectionPtr, uint64_t> connection_id_map_;
+    // connections that use a binary protocol
+    std::unordered_set<uint64_t> binary_connections_;
+    // connections that negotiated permessage-deflate
+    std::unordered_set<uint64_t> deflate_connections_;
 
     // used for topics
     uint64_t channel_count_ = 0;
@@ -45,6 +176,13 @@ private:
 
     uint64_t get_new_channel_id();
 
+    void enqueue(OutboundMessage message);
+    void drain_send_queue();
+    void deliver(OutboundMessage message);
+    void deliver(uint64_t conn_id, const Connection &conn, const WSServer::message_ptr &frame,
+                 MessageKind kind);
+    void update_connection_count();
+
     // call back on a connection closed
     std::optional<std::function<void(void)>> on_all_client_disconnect_;
 };
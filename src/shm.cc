@@ -0,0 +1,588 @@
+#include "shm.hh"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <thread>
+
+#include "fmt/format.h"
+#include "log.hh"
+
+namespace hgdb::shm {
+
+constexpr uint64_t segment_magic = 0x4847'4442'5348'4d31;  // HGDBSHM1
+constexpr uint64_t cache_line_size = 64;
+// spin a little before going to sleep. a round trip is usually shorter than a futex wake up
+constexpr uint32_t spin_count = 4096;
+// sleepers wake up periodically to check whether the other side is still alive
+constexpr auto wait_slice = std::chrono::milliseconds(50);
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
+
+// the counters only grow. the number of bytes in the ring is head - tail
+struct RingHeader {
+    alignas(cache_line_size) std::atomic<uint64_t> head;
+    // bumped after every write. readers sleep on it
+    std::atomic<uint32_t> write_seq;
+    std::atomic<uint32_t> num_readers_waiting;
+    alignas(cache_line_size) std::atomic<uint64_t> tail;
+    // bumped after every read. writers sleep on it
+    std::atomic<uint32_t> read_seq;
+    std::atomic<uint32_t> num_writers_waiting;
+};
+
+struct SegmentHeader {
+    uint64_t magic;
+    uint64_t capacity;
+    std::atomic<int32_t> server_pid;
+    // only one client can be attached at a time. clients claim the segment by setting their pid
+    // and give it up by clearing it
+    std::atomic<int32_t> client_pid;
+    // set by the server once it accepts the client. responses to that client start at
+    // response_start, anything before it was meant for the previous client
+    std::atomic<int32_t> connected_pid;
+    std::atomic<uint64_t> response_start;
+    RingHeader requests;
+    RingHeader responses;
+};
+
+enum class FrameType : uint32_t { text, binary, open, close };
+
+struct FrameHeader {
+    uint32_t size;
+    FrameType type;
+};
+
+void futex_wait(std::atomic<uint32_t> &word, uint32_t expected) {
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(wait_slice);
+    auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(wait_slice - seconds);
+    timespec timeout{.tv_sec = seconds.count(), .tv_nsec = nanoseconds.count()};
+    // not FUTEX_PRIVATE since the word is shared across processes
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT, expected, &timeout,
+            nullptr, 0);
+}
+
+void futex_wake(std::atomic<uint32_t> &word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr,
+            0);
+}
+
+bool process_alive(int32_t pid) { return pid > 0 && (kill(pid, 0) == 0 || errno != ESRCH); }
+
+using AbortCondition = std::function<bool()>;
+
+// process local view of one ring
+class Ring {
+public:
+    Ring(RingHeader *header, char *data, uint64_t capacity)
+        : header_(header), data_(data), capacity_(capacity) {}
+
+    // blocks until all the bytes are written. false if aborted
+    bool write(const char *data, uint64_t size, const AbortCondition &abort) {
+        auto head = header_->head.load(std::memory_order_relaxed);
+        while (size > 0) {
+            auto space = capacity_ - (head - header_->tail.load(std::memory_order_acquire));
+            if (space == 0) {
+                auto has_space = [this, head]() { return head - header_->tail < capacity_; };
+                if (!wait(header_->read_seq, header_->num_writers_waiting, has_space, abort)) {
+                    return false;
+                }
+                continue;
+            }
+            auto n = std::min(space, size);
+            auto pos = head % capacity_;
+            auto first = std::min(n, capacity_ - pos);
+            std::memcpy(data_ + pos, data, first);
+            std::memcpy(data_, data + first, n - first);
+            head += n;
+            data += n;
+            size -= n;
+            header_->head.store(head, std::memory_order_release);
+            notify(header_->write_seq, header_->num_readers_waiting);
+        }
+        return true;
+    }
+
+    // blocks until all the bytes are read. false if aborted
+    bool read(char *data, uint64_t size, const AbortCondition &abort) {
+        auto tail = header_->tail.load(std::memory_order_relaxed);
+        while (size > 0) {
+            auto available = header_->head.load(std::memory_order_acquire) - tail;
+            if (available == 0) {
+                auto has_data = [this, tail]() { return header_->head != tail; };
+                if (!wait(header_->write_seq, header_->num_readers_waiting, has_data, abort)) {
+                    return false;
+                }
+                continue;
+            }
+            auto n = std::min(available, size);
+            auto pos = tail % capacity_;
+            auto first = std::min(n, capacity_ - pos);
+            std::memcpy(data, data_ + pos, first);
+            std::memcpy(data + first, data_, n - first);
+            tail += n;
+            data += n;
+            size -= n;
+            header_->tail.store(tail, std::memory_order_release);
+            notify(header_->read_seq, header_->num_writers_waiting);
+        }
+        return true;
+    }
+
+    bool write_frame(FrameType type, const std::string &payload, const AbortCondition &abort) {
+        auto header = FrameHeader{.size = static_cast<uint32_t>(payload.size()), .type = type};
+        return write(reinterpret_cast<const char *>(&header), sizeof(header), abort) &&
+               write(payload.data(), payload.size(), abort);
+    }
+
+    // once the frame header is read, the rest of the frame has to be read as well to keep the
+    // stream in sync. abort_payload is used from that point on
+    std::optional<std::pair<FrameType, std::string>> read_frame(
+        const AbortCondition &abort, const AbortCondition &abort_payload) {
+        FrameHeader header{};
+        if (!read(reinterpret_cast<char *>(&header), sizeof(header), abort)) return std::nullopt;
+        std::string payload(header.size, '\0');
+        if (!read(payload.data(), payload.size(), abort_payload)) return std::nullopt;
+        return std::make_pair(header.type, std::move(payload));
+    }
+
+    [[nodiscard]] uint64_t head() const { return header_->head; }
+    [[nodiscard]] uint64_t buffered() const { return header_->head - header_->tail; }
+
+    // only called by the reader when it is not reading. everything before pos is dropped,
+    // including partial frames
+    void skip_to(uint64_t pos) {
+        header_->tail.store(pos);
+        notify(header_->read_seq, header_->num_writers_waiting);
+    }
+    void discard() { skip_to(header_->head); }
+
+    // wake up a blocked reader so that it can check the abort condition
+    void interrupt_reader() { notify(header_->write_seq, header_->num_readers_waiting); }
+
+private:
+    RingHeader *header_;
+    char *data_;
+    uint64_t capacity_;
+
+    template <typename Ready>
+    static bool wait(std::atomic<uint32_t> &seq, std::atomic<uint32_t> &num_waiting, Ready &&ready,
+                     const AbortCondition &abort) {
+        for (auto i = 0u; i < spin_count; i++) {
+            if (ready()) [[likely]] {
+                return true;
+            }
+        }
+        while (true) {
+            // the waiting counter lets the other side skip the wake up syscall. the value of seq
+            // is read before checking again so a notification in between is never missed
+            num_waiting++;
+            auto value = seq.load();
+            auto is_ready = ready();
+            if (!is_ready) futex_wait(seq, value);
+            num_waiting--;
+            if (is_ready || ready()) return true;
+            if (abort()) return false;
+        }
+    }
+
+    static void notify(std::atomic<uint32_t> &seq, std::atomic<uint32_t> &num_waiting) {
+        seq++;
+        if (num_waiting > 0) [[unlikely]] {
+            futex_wake(seq);
+        }
+    }
+};
+
+class Segment {
+public:
+    static std::unique_ptr<Segment> create(const std::string &name, uint64_t capacity) {
+        auto shm_name = get_shm_name(name);
+        // a segment left by a crashed simulation can be replaced, one owned by a running
+        // simulation can't
+        if (auto existing = open(name)) {
+            auto pid = existing->header()->server_pid.load();
+            if (process_alive(pid)) {
+                log::log(log::log_level::error,
+                         fmt::format("Shared memory {0} is already used by process {1}", name,
+                                     pid));
+                errno = EEXIST;
+                return nullptr;
+            }
+        }
+        shm_unlink(shm_name.c_str());
+        auto fd = shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) return nullptr;
+        auto size = sizeof(SegmentHeader) + 2 * capacity;
+        void *addr = MAP_FAILED;
+        if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+            addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            shm_unlink(shm_name.c_str());
+            return nullptr;
+        }
+        auto *header = new (addr) SegmentHeader{.magic = segment_magic, .capacity = capacity};
+        header->server_pid = getpid();
+        return std::unique_ptr<Segment>(new Segment(shm_name, addr, size, true));
+    }
+
+    static std::unique_ptr<Segment> open(const std::string &name) {
+        auto shm_name = get_shm_name(name);
+        auto fd = shm_open(shm_name.c_str(), O_RDWR, 0600);
+        if (fd < 0) return nullptr;
+        struct stat st {};
+        void *addr = MAP_FAILED;
+        auto size = 0ul;
+        // the server may still be sizing the segment
+        if (fstat(fd, &st) == 0 && static_cast<uint64_t>(st.st_size) > sizeof(SegmentHeader)) {
+            size = static_cast<uint64_t>(st.st_size);
+            addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (addr == MAP_FAILED) return nullptr;
+        auto const *header = reinterpret_cast<SegmentHeader *>(addr);
+        if (header->magic != segment_magic ||
+            sizeof(SegmentHeader) + 2 * header->capacity != size) {
+            munmap(addr, size);
+            return nullptr;
+        }
+        return std::unique_ptr<Segment>(new Segment(shm_name, addr, size, false));
+    }
+
+    [[nodiscard]] SegmentHeader *header() const { return header_; }
+    Ring &requests() { return requests_; }
+    Ring &responses() { return responses_; }
+
+    [[nodiscard]] bool server_alive() const { return process_alive(header_->server_pid); }
+    [[nodiscard]] bool client_alive() const { return process_alive(header_->client_pid); }
+
+    ~Segment() {
+        if (owner_) {
+            header_->server_pid = 0;
+            shm_unlink(name_.c_str());
+        }
+        munmap(header_, size_);
+    }
+
+private:
+    std::string name_;
+    SegmentHeader *header_;
+    uint64_t size_;
+    bool owner_;
+    Ring requests_;
+    Ring responses_;
+
+    Segment(std::string name, void *addr, uint64_t size, bool owner)
+        : name_(std::move(name)),
+          header_(reinterpret_cast<SegmentHeader *>(addr)),
+          size_(size),
+          owner_(owner),
+          requests_(&header_->requests, reinterpret_cast<char *>(header_ + 1), header_->capacity),
+          responses_(&header_->responses,
+                     reinterpret_cast<char *>(header_ + 1) + header_->capacity,
+                     header_->capacity) {}
+
+    static std::string get_shm_name(const std::string &name) {
+        return name.starts_with('/') ? name : "/" + name;
+    }
+};
+
+}  // namespace hgdb::shm
+
+namespace hgdb {
+
+ShmDebugServer::ShmDebugServer(std::string name, uint64_t capacity) {
+    segment_ = shm::Segment::create(name, capacity);
+    if (!segment_) {
+        log::log(log::log_level::error,
+                 fmt::format("Unable to create shared memory {0}: {1}", name, strerror(errno)));
+    }
+}
+
+void ShmDebugServer::run(uint16_t) {
+    if (!segment_) return;
+    auto *header = segment_->header();
+    auto &requests = segment_->requests();
+    auto client_died = [this, header]() {
+        return header->client_pid != 0 && !segment_->client_alive();
+    };
+    auto abort = [this, &client_died]() { return stopped_ || client_died(); };
+    // responses go through their own thread so that neither the simulator nor this thread
+    // blocks on a client that stops reading
+    auto writer = std::thread([this]() { write_loop(); });
+    while (!stopped_) {
+        auto frame = requests.read_frame(abort, abort);
+        if (!frame) {
+            if (!stopped_) on_disconnect(true);
+            continue;
+        }
+        auto &[type, payload] = *frame;
+        switch (type) {
+            case shm::FrameType::open:
+                on_connect();
+                break;
+            case shm::FrameType::close:
+                on_disconnect(false);
+                break;
+            default:
+                // connections only change on this thread
+                if (conn_id_ && on_message_) on_message_(payload, *conn_id_);
+                break;
+        }
+    }
+    writer.join();
+}
+
+void ShmDebugServer::stop() {
+    {
+        std::lock_guard guard(send_lock_);
+        stopped_ = true;
+    }
+    send_cond_.notify_all();
+    if (segment_) segment_->requests().interrupt_reader();
+}
+
+void ShmDebugServer::send(std::string payload, MessageKind kind, bool binary) {
+    std::lock_guard guard(send_lock_);
+    if (!conn_id_ || binary_ != binary) return;
+    enqueue(std::move(payload), kind, binary);
+}
+
+void ShmDebugServer::send(std::string payload, const std::string &topic, MessageKind kind,
+                          bool binary) {
+    std::lock_guard guard(send_lock_);
+    if (!conn_id_ || binary_ != binary) return;
+    auto ids = topics_.find(topic);
+    if (ids == topics_.end() || !ids->second.contains(*conn_id_)) return;
+    enqueue(std::move(payload), kind, binary);
+}
+
+void ShmDebugServer::send(std::string payload, uint64_t conn_id, bool binary) {
+    std::lock_guard guard(send_lock_);
+    if (conn_id_ != conn_id) return;
+    enqueue(std::move(payload), MessageKind::normal, binary);
+}
+
+void ShmDebugServer::enqueue(std::string payload, MessageKind kind, bool binary) {
+    auto buffered = queued_bytes_ + segment_->responses().buffered();
+    if (kind == MessageKind::monitor && buffered > high_water_mark_) {
+        // either way the client misses some value changes
+        monitor_message_dropped_ = true;
+        if (overflow_policy_ == OverflowPolicy::coalesce) {
+            pending_monitor_message_ = QueuedFrame{.payload = std::move(payload), .binary = binary};
+        }
+        return;
+    }
+    // keep the order of monitor messages. the coalesced one goes out with the next message
+    // once the client catches up
+    if (pending_monitor_message_ && buffered <= high_water_mark_) [[unlikely]] {
+        queued_bytes_ += pending_monitor_message_->payload.size();
+        send_queue_.emplace_back(std::move(*pending_monitor_message_));
+        pending_monitor_message_.reset();
+    }
+    queued_bytes_ += payload.size();
+    send_queue_.emplace_back(QueuedFrame{.payload = std::move(payload), .binary = binary});
+    send_cond_.notify_one();
+}
+
+void ShmDebugServer::write_loop() {
+    auto *header = segment_->header();
+    auto &responses = segment_->responses();
+    // give up once the client is gone or another one takes over
+    auto abort = [this, header]() {
+        return stopped_ || header->client_pid != header->connected_pid ||
+               !segment_->client_alive();
+    };
+    while (true) {
+        {
+            std::unique_lock guard(send_lock_);
+            send_cond_.wait(guard, [this]() { return stopped_ || !send_queue_.empty(); });
+            if (stopped_) return;
+        }
+        // held while the frame is written so that a new client never sees half of it
+        std::lock_guard write_guard(write_lock_);
+        QueuedFrame frame;
+        {
+            std::lock_guard guard(send_lock_);
+            // a new client may have cleared the queue in the meantime
+            if (send_queue_.empty()) continue;
+            frame = std::move(send_queue_.front());
+            send_queue_.pop_front();
+            queued_bytes_ -= frame.payload.size();
+        }
+        auto type = frame.binary ? shm::FrameType::binary : shm::FrameType::text;
+        responses.write_frame(type, frame.payload, abort);
+    }
+}
+
+void ShmDebugServer::set_on_message(
+    const std::function<void(const std::string &, uint64_t)> &callback) {
+    on_message_ = callback;
+}
+
+void ShmDebugServer::set_on_call_client_disconnect(const std::function<void()> &func) {
+    on_all_client_disconnect_ = func;
+}
+
+void ShmDebugServer::add_to_topic(const std::string &topic, uint64_t conn_id) {
+    std::lock_guard guard(send_lock_);
+    topics_[topic].emplace(conn_id);
+}
+
+void ShmDebugServer::remove_from_topic(const std::string &topic, uint64_t conn_id) {
+    std::lock_guard guard(send_lock_);
+    auto ids = topics_.find(topic);
+    if (ids != topics_.end()) ids->second.erase(conn_id);
+}
+
+void ShmDebugServer::set_binary(uint64_t conn_id, bool binary) {
+    std::lock_guard guard(send_lock_);
+    if (conn_id_ == conn_id) {
+        binary_ = binary;
+        update_connection_count();
+    }
+}
+
+bool ShmDebugServer::is_binary(uint64_t conn_id) {
+    std::lock_guard guard(send_lock_);
+    return conn_id_ == conn_id && binary_;
+}
+
+void ShmDebugServer::on_connect() {
+    auto *header = segment_->header();
+    // the writer gives up on the previous client's frame since client_pid has changed
+    std::lock_guard write_guard(write_lock_);
+    std::lock_guard guard(send_lock_);
+    conn_id_ = get_new_channel_id();
+    binary_ = false;
+    clear_send_queue();
+    update_connection_count();
+    // no writer is active, so the client can skip whatever is left in the ring
+    header->response_start = segment_->responses().head();
+    header->connected_pid = header->client_pid.load();
+}
+
+void ShmDebugServer::on_disconnect(bool client_died) {
+    auto *header = segment_->header();
+    bool connected;
+    {
+        std::lock_guard guard(send_lock_);
+        connected = conn_id_.has_value();
+        conn_id_.reset();
+        binary_ = false;
+        clear_send_queue();
+        update_connection_count();
+        header->connected_pid = 0;
+        if (client_died) {
+            // a dead client may have left a partial frame behind. clients that close properly
+            // release the segment themselves
+            segment_->requests().discard();
+            auto pid = header->client_pid.load();
+            header->client_pid.compare_exchange_strong(pid, 0);
+        }
+    }
+    if (connected && on_all_client_disconnect_) {
+        (*on_all_client_disconnect_)();
+    }
+}
+
+void ShmDebugServer::update_connection_count() {
+    // assume we are under lock guard's protection
+    num_connections_ = conn_id_ ? 1 : 0;
+    num_binary_connections_ = conn_id_ && binary_ ? 1 : 0;
+}
+
+void ShmDebugServer::clear_send_queue() {
+    // assume we are under lock guard's protection
+    send_queue_.clear();
+    queued_bytes_ = 0;
+    pending_monitor_message_.reset();
+}
+
+uint64_t ShmDebugServer::get_new_channel_id() {
+    // assume we are under lock guard's protection
+    return channel_count_++;
+}
+
+ShmDebugServer::~ShmDebugServer() = default;
+
+ShmClient::ShmClient() = default;
+
+bool ShmClient::connect(const std::string &name, std::chrono::milliseconds timeout) {
+    using namespace std::chrono_literals;
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    auto pid = getpid();
+    // wait for the segment and claim it
+    while (true) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            segment_.reset();
+            return false;
+        }
+        if (!segment_) segment_ = shm::Segment::open(name);
+        int32_t expected = 0;
+        if (segment_ && segment_->header()->client_pid.compare_exchange_strong(expected, pid)) {
+            break;
+        }
+        std::this_thread::sleep_for(10ms);
+    }
+
+    auto *header = segment_->header();
+    auto server_gone = [this]() { return !segment_->server_alive(); };
+    if (segment_->requests().write_frame(shm::FrameType::open, "", server_gone)) {
+        // wait for the server to accept the connection
+        while (std::chrono::steady_clock::now() < deadline && !server_gone()) {
+            if (header->connected_pid == pid) {
+                segment_->responses().skip_to(header->response_start);
+                return true;
+            }
+            std::this_thread::sleep_for(100us);
+        }
+    }
+    header->client_pid = 0;
+    segment_.reset();
+    return false;
+}
+
+bool ShmClient::send(const std::string &payload, bool binary) {
+    if (!segment_) return false;
+    auto type = binary ? shm::FrameType::binary : shm::FrameType::text;
+    return segment_->requests().write_frame(type, payload,
+                                            [this]() { return !segment_->server_alive(); });
+}
+
+std::optional<std::string> ShmClient::recv(std::optional<std::chrono::milliseconds> timeout) {
+    if (!segment_) return std::nullopt;
+    auto server_gone = [this]() { return !segment_->server_alive(); };
+    auto deadline = std::chrono::steady_clock::now() +
+                    timeout.value_or(std::chrono::milliseconds::zero());
+    auto abort = [&timeout, deadline, &server_gone]() {
+        return (timeout && std::chrono::steady_clock::now() >= deadline) || server_gone();
+    };
+    auto frame = segment_->responses().read_frame(abort, server_gone);
+    if (!frame) return std::nullopt;
+    return std::move(frame->second);
+}
+
+void ShmClient::close() {
+    if (!segment_) return;
+    segment_->requests().write_frame(shm::FrameType::close, "",
+                                     [this]() { return !segment_->server_alive(); });
+    // release the segment so the next client can attach
+    segment_->header()->client_pid = 0;
+    segment_.reset();
+}
+
+ShmClient::~ShmClient() { close(); }
+
+}  // namespace hgdb
@@ -0,0 +1,108 @@
+#ifndef HGDB_SHM_HH
+#define HGDB_SHM_HH
+
+// same-host transport over a POSIX shared memory segment. the segment holds two single
+// producer single consumer byte rings, one for requests and one for responses, and both sides
+// sleep on futexes inside the segment when a ring is empty or full. only available on Linux
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+
+#include "server.hh"
+
+namespace hgdb {
+
+namespace shm {
+class Segment;
+}
+
+// one client at a time. messages keep the same structure as the websocket ones
+class ShmDebugServer : public ADebugServer {
+public:
+    explicit ShmDebugServer(std::string name, uint64_t capacity = default_capacity);
+    // false if the segment could not be created
+    [[nodiscard]] bool is_open() const { return segment_ != nullptr; }
+
+    void run(uint16_t port) override;
+    void stop() override;
+    void send(std::string payload, MessageKind kind = MessageKind::normal,
+              bool binary = false) override;
+    void send(std::string payload, const std::string &topic,
+              MessageKind kind = MessageKind::normal, bool binary = false) override;
+    void send(std::string payload, uint64_t conn_id, bool binary = false) override;
+    void set_on_message(
+        const std::function<void(const std::string &, uint64_t conn_id)> &callback) override;
+    void set_on_call_client_disconnect(const std::function<void(void)> &func) override;
+    void add_to_topic(const std::string &topic, uint64_t conn_id) override;
+    void remove_from_topic(const std::string &topic, uint64_t conn_id) override;
+    // messages are already handled one at a time by the reader thread
+    void post_ordered(std::function<void()> task) override { task(); }
+
+    void set_binary(uint64_t conn_id, bool binary) override;
+    bool is_binary(uint64_t conn_id) override;
+
+    // size of each ring in bytes. messages larger than the ring are streamed through it
+    static constexpr uint64_t default_capacity = 4 << 20;
+
+    ~ShmDebugServer() override;
+
+private:
+    std::unique_ptr<shm::Segment> segment_;
+    std::atomic<bool> stopped_ = false;
+
+    std::function<void(const std::string &, uint64_t)> on_message_;
+    std::optional<std::function<void(void)>> on_all_client_disconnect_;
+
+    struct QueuedFrame {
+        std::string payload;
+        bool binary = false;
+    };
+
+    // held by the writer thread for each frame. taken before send_lock_
+    std::mutex write_lock_;
+    // guards everything below. responses are queued here and written to the ring by the writer
+    // thread, so senders never wait for the client
+    std::mutex send_lock_;
+    std::condition_variable send_cond_;
+    std::deque<QueuedFrame> send_queue_;
+    uint64_t queued_bytes_ = 0;
+    std::optional<uint64_t> conn_id_;
+    bool binary_ = false;
+    uint64_t channel_count_ = 0;
+    std::unordered_map<std::string, std::unordered_set<uint64_t>> topics_;
+    // latest monitor message held back by the coalesce policy
+    std::optional<QueuedFrame> pending_monitor_message_;
+
+    void on_connect();
+    void on_disconnect(bool client_died);
+    uint64_t get_new_channel_id();
+    void update_connection_count();
+    // assume we are under send_lock_'s protection
+    void clear_send_queue();
+    void enqueue(std::string payload, MessageKind kind, bool binary);
+    void write_loop();
+};
+
+// client side of the shared memory transport
+class ShmClient {
+public:
+    ShmClient();
+    // the server might not have created the segment yet, so keep trying until timeout
+    bool connect(const std::string &name,
+                 std::chrono::milliseconds timeout = std::chrono::milliseconds(10000));
+    bool send(const std::string &payload, bool binary = false);
+    // nullopt on timeout or if the server is gone
+    std::optional<std::string> recv(
+        std::optional<std::chrono::milliseconds> timeout = std::nullopt);
+    void close();
+
+    ~ShmClient();
+
+private:
+    std::unique_ptr<shm::Segment> segment_;
+};
+
+}  // namespace hgdb
+
+#endif  // HGDB_SHM_HH
@@ -4,7 +4,9 @@ namespace hgdb {
 
 void RuntimeLock::wait() {
     std::unique_lock<std::mutex> lock_(m_);
+    waiting_.store(true);
     cv_.wait(lock_, [this] { return ready_.load(); });
+    waiting_.store(false);
     ready_.store(false);
 }
 
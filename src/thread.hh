@@ -4,6 +4,7 @@
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
+#include <optional>
 
 namespace hgdb {
 
@@ -12,13 +13,61 @@ public:
     RuntimeLock() = default;
     void wait();
     void ready();
+    // whether a thread is blocked in wait() and hasn't been released yet
+    [[nodiscard]] bool paused() const { return waiting_.load() && !ready_.load(); }
 
 private:
     std::mutex m_;
     std::atomic<bool> ready_ = false;
+    std::atomic<bool> waiting_ = false;
     std::condition_variable cv_;
 };
 
+// lock-free multi-producer single-consumer queue. push can be called from any thread,
+// pop can only be called from one thread at a time
+template <typename T>
+class MPSCQueue {
+public:
+    MPSCQueue() : head_(new Node()), tail_(head_.load()) {}
+    ~MPSCQueue() {
+        while (pop()) {
+        }
+        delete tail_;
+    }
+
+    void push(T value) {
+        auto *node = new Node(std::move(value));
+        auto *prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    std::optional<T> pop() {
+        auto *tail = tail_;
+        auto *next = tail->next.load(std::memory_order_acquire);
+        if (!next) return std::nullopt;
+        // next becomes the new dummy node
+        tail_ = next;
+        auto value = std::move(next->value);
+        next->value = std::nullopt;
+        delete tail;
+        return value;
+    }
+
+    MPSCQueue(const MPSCQueue &) = delete;
+    MPSCQueue &operator=(const MPSCQueue &) = delete;
+
+private:
+    struct Node {
+        Node() = default;
+        explicit Node(T v) : value(std::move(v)) {}
+        std::atomic<Node *> next = nullptr;
+        std::optional<T> value;
+    };
+
+    std::atomic<Node *> head_;
+    Node *tail_;
+};
+
 }  // namespace hgdb
 
 #endif  // HGDB_THREAD_HH
@@ -0,0 +1,188 @@
+#ifndef HGDB_VERILATOR_HH
+#define HGDB_VERILATOR_HH
+
+// header-only VPI provider for Verilator test benches. it has to be compiled together with the
+// Verilated model since libhgdb does not link against Verilator.
+// the design needs to be compiled with --vpi and --public-flat-rw
+
+#include <cstdarg>
+
+#include "rtl.hh"
+#include "verilated.h"
+#include "verilated_sym_props.h"
+
+namespace hgdb {
+
+// resolves signals to the model's raw storage and reads integer, hex and binary string values
+// directly from memory. everything else, including signals wider than 64 bits and unpacked
+// arrays, goes through Verilator's VPI implementation
+class VerilatorVPIProvider : public AVPIProvider {
+public:
+    VerilatorVPIProvider() : VerilatorVPIProvider(std::make_unique<VPIProvider>()) {}
+    explicit VerilatorVPIProvider(std::unique_ptr<AVPIProvider> vpi) : vpi_(std::move(vpi)) {}
+
+    void vpi_get_value(vpiHandle expr, p_vpi_value value_p) override {
+        const auto *var = direct_vars_.find(expr);
+        if (var) [[likely]] {
+            switch (value_p->format) {
+                case vpiIntVal:
+                    value_p->value.integer = static_cast<PLI_INT32>(var->read());
+                    return;
+                case vpiHexStrVal:
+                    value_p->value.str = format_str(var->read(), (var->width + 3) / 4, 4);
+                    return;
+                case vpiBinStrVal:
+                    value_p->value.str = format_str(var->read(), var->width, 1);
+                    return;
+                default:
+                    break;
+            }
+        }
+        vpi_->vpi_get_value(expr, value_p);
+    }
+
+    PLI_INT32 vpi_get(PLI_INT32 property, vpiHandle object) override {
+        return vpi_->vpi_get(property, object);
+    }
+
+    vpiHandle vpi_iterate(PLI_INT32 type, vpiHandle refHandle) override {
+        return vpi_->vpi_iterate(type, refHandle);
+    }
+
+    vpiHandle vpi_scan(vpiHandle iterator) override { return vpi_->vpi_scan(iterator); }
+
+    char *vpi_get_str(PLI_INT32 property, vpiHandle object) override {
+        return vpi_->vpi_get_str(property, object);
+    }
+
+    vpiHandle vpi_handle_by_name(char *name, vpiHandle scope) override {
+        auto *handle = vpi_->vpi_handle_by_name(name, scope);
+        // Verilator only supports lookup from the root, which is what hgdb uses
+        if (handle && !scope) {
+            add_direct_var(handle, name);
+        }
+        return handle;
+    }
+
+    vpiHandle vpi_handle_by_index(vpiHandle object, PLI_INT32 index) override {
+        return vpi_->vpi_handle_by_index(object, index);
+    }
+
+    void vpi_handle_resolved(vpiHandle handle, const std::string &name) override {
+        add_direct_var(handle, name);
+    }
+
+    PLI_INT32 vpi_get_vlog_info(p_vpi_vlog_info vlog_info_p) override {
+        return vpi_->vpi_get_vlog_info(vlog_info_p);
+    }
+
+    void vpi_get_time(vpiHandle object, p_vpi_time time_p) override {
+        vpi_->vpi_get_time(object, time_p);
+    }
+
+    vpiHandle vpi_register_cb(p_cb_data cb_data_p) override {
+        return vpi_->vpi_register_cb(cb_data_p);
+    }
+
+    PLI_INT32 vpi_remove_cb(vpiHandle cb_obj) override { return vpi_->vpi_remove_cb(cb_obj); }
+
+    PLI_INT32 vpi_release_handle(vpiHandle object) override {
+        return vpi_->vpi_release_handle(object);
+    }
+
+    PLI_INT32 vpi_control(PLI_INT32 operation, ...) override {
+        // only simple controls are used by hgdb
+        std::va_list args;
+        va_start(args, operation);
+        auto value = va_arg(args, PLI_INT32);
+        va_end(args);
+        return vpi_->vpi_control(operation, value);
+    }
+
+    vpiHandle vpi_put_value(vpiHandle object, p_vpi_value value_p, p_vpi_time time_p,
+                            PLI_INT32 flags) override {
+        return vpi_->vpi_put_value(object, value_p, time_p, flags);
+    }
+
+    // number of signals that are read directly from memory
+    [[nodiscard]] uint64_t num_direct_vars() const { return direct_vars_.size(); }
+
+private:
+    struct DirectVar {
+        const void *data = nullptr;
+        VerilatedVarType type = VLVT_UNKNOWN;
+        uint32_t width = 0;
+
+        [[nodiscard]] uint64_t read() const {
+            switch (type) {
+                case VLVT_UINT8:
+                    return *reinterpret_cast<const CData *>(data);
+                case VLVT_UINT16:
+                    return *reinterpret_cast<const SData *>(data);
+                case VLVT_UINT32:
+                    return *reinterpret_cast<const IData *>(data);
+                case VLVT_UINT64:
+                    return *reinterpret_cast<const QData *>(data);
+                default:
+                    return 0;
+            }
+        }
+    };
+
+    std::unique_ptr<AVPIProvider> vpi_;
+    HandleTable<DirectVar> direct_vars_;
+    // most significant digit first, zero padded to the signal width like Verilator's VPI.
+    // same as Verilator's VPI, string values are only valid until the next call on the same
+    // thread
+    static char *format_str(uint64_t value, uint32_t num_digits, uint32_t bits_per_digit) {
+        static constexpr auto digits = "0123456789abcdef";
+        static thread_local std::string buffer;
+        buffer.resize(num_digits);
+        auto mask = (1u << bits_per_digit) - 1;
+        for (auto i = 0u; i < num_digits; i++) {
+            auto shift = (num_digits - i - 1) * bits_per_digit;
+            buffer[i] = digits[(value >> shift) & mask];
+        }
+        return buffer.data();
+    }
+
+    static const VerilatedScope *find_scope(const std::string &name) {
+#if defined(VERILATOR_VERSION_INTEGER) && VERILATOR_VERSION_INTEGER >= 4200000
+        return Verilated::threadContextp()->scopeFind(name.c_str());
+#else
+        return Verilated::scopeFind(name.c_str());
+#endif
+    }
+
+    void add_direct_var(vpiHandle handle, const std::string &name) {
+        if (direct_vars_.find(handle)) return;
+        // same split as Verilator's vpi_handle_by_name: scope name + variable name
+        auto pos = name.find_last_of('.');
+        if (pos == std::string::npos) return;
+        const auto *scope = find_scope(name.substr(0, pos));
+        if (!scope) return;
+        auto *var = scope->varFind(name.substr(pos + 1).c_str());
+        // unpacked arrays are accessed by index through VPI
+        if (!var || var->udims() > 0) return;
+        auto type = var->vltype();
+        if (type != VLVT_UINT8 && type != VLVT_UINT16 && type != VLVT_UINT32 &&
+            type != VLVT_UINT64) {
+            return;
+        }
+        auto width = static_cast<uint32_t>(var->packed().elements());
+        direct_vars_.insert(handle,
+                            DirectVar{.data = var->datap(), .type = type, .width = width});
+    }
+};
+
+class Debugger;
+Debugger *initialize_hgdb_runtime_vpi(std::unique_ptr<AVPIProvider> vpi, bool start_server);
+
+// drop-in replacement for initialize_hgdb_runtime_cxx()
+inline Debugger *initialize_hgdb_runtime_verilator() {
+    return initialize_hgdb_runtime_vpi(std::make_unique<VerilatorVPIProvider>(), true);
+}
+
+}  // namespace hgdb
+
+#endif  // HGDB_VERILATOR_HH
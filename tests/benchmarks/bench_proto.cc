@@ -0,0 +1,75 @@
+// compares message size and encoding/decoding throughput between JSON and MessagePack.
+// usage: bench_proto [num_variables] [num_iterations]
+
+#include <chrono>
+#include <iostream>
+
+#include "fmt/format.h"
+#include "proto.hh"
+
+// a breakpoint hit with a lot of local variables is the largest message hgdb sends
+hgdb::BreakPointResponse make_response(uint64_t num_vars) {
+    auto resp = hgdb::BreakPointResponse(42, "/tmp/design/src/module.py", 100, 0);
+    auto scope = hgdb::BreakPointResponse::Scope(1, "top.dut.inst", 2);
+    for (auto i = 0u; i < num_vars; i++) {
+        scope.add_local_value(fmt::format("var_{0}", i), std::to_string(i * 1000));
+        scope.add_generator_value(fmt::format("self.reg_{0}", i), std::to_string(i));
+    }
+    resp.add_scope(scope);
+    return resp;
+}
+
+template <typename F>
+double measure(uint64_t num_iterations, F &&func) {
+    auto start = std::chrono::steady_clock::now();
+    for (auto i = 0u; i < num_iterations; i++) {
+        func();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+int main(int argc, char *argv[]) {
+    uint64_t num_vars = argc > 1 ? std::stoull(argv[1]) : 1000;
+    uint64_t num_iterations = argc > 2 ? std::stoull(argv[2]) : 1000;
+
+    auto resp = make_response(num_vars);
+    auto json = resp.str(false);
+    auto msgpack = resp.serialize(hgdb::MessageFormat::msgpack, false);
+    std::cout << "JSON size:    " << json.size() << " bytes" << std::endl;
+    std::cout << "msgpack size: " << msgpack.size() << " bytes" << std::endl;
+
+    uint64_t total = 0;
+    auto json_time = measure(num_iterations, [&]() { total += resp.str(false).size(); });
+    auto msgpack_time = measure(num_iterations, [&]() {
+        total += resp.serialize(hgdb::MessageFormat::msgpack, false).size();
+    });
+    auto to_mb = [](uint64_t size, double time) { return static_cast<double>(size) / time / 1e6; };
+    std::cout << fmt::format("encode JSON:    {0:.2f} MB/s",
+                             to_mb(json.size() * num_iterations, json_time))
+              << std::endl;
+    std::cout << fmt::format("encode msgpack: {0:.2f} MB/s",
+                             to_mb(msgpack.size() * num_iterations, msgpack_time))
+              << std::endl;
+
+    // requests are small, so measure the per-request overhead instead
+    auto request = R"({"request":true,"type":"breakpoint","token":"42",)"
+                   R"("payload":{"filename":"/tmp/design/src/module.py","line_num":100,)"
+                   R"("action":"add","condition":"a == 1"}})";
+    std::string json_request = request;
+    auto msgpack_request = hgdb::json_to_msgpack(json_request);
+    json_time = measure(num_iterations, [&]() {
+        total += static_cast<uint64_t>(hgdb::Request::parse_request(json_request)->status());
+    });
+    msgpack_time = measure(num_iterations, [&]() {
+        total += static_cast<uint64_t>(hgdb::Request::parse_request(msgpack_request)->status());
+    });
+    std::cout << fmt::format("decode JSON:    {0:.2f} us/request",
+                             json_time * 1e6 / static_cast<double>(num_iterations))
+              << std::endl;
+    std::cout << fmt::format("decode msgpack: {0:.2f} us/request",
+                             msgpack_time * 1e6 / static_cast<double>(num_iterations))
+              << std::endl;
+    // prevent the compiler from optimizing the loops away
+    return total == 0 ? 1 : 0;
+}
@@ -0,0 +1,141 @@
+// compares request/response round trip latency between the websocket and the shared memory
+// transport using an echo server.
+// usage: bench_transport [num_iterations] [message_size] [port]
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <thread>
+
+#include "fmt/format.h"
+#include "server.hh"
+#include "shm.hh"
+#include "websocketpp/client.hpp"
+#include "websocketpp/config/asio_no_tls_client.hpp"
+
+using WSClient = websocketpp::client<websocketpp::config::asio_client>;
+using Clock = std::chrono::steady_clock;
+
+void echo(hgdb::ADebugServer &server) {
+    server.set_on_message(
+        [&server](const std::string &msg, uint64_t conn_id) { server.send(msg, conn_id); });
+}
+
+void report(const std::string &name, std::vector<double> latencies) {
+    if (latencies.empty()) {
+        std::cout << name << ": failed" << std::endl;
+        return;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    double total = 0;
+    for (auto l : latencies) total += l;
+    auto percentile = [&latencies](double p) {
+        auto index = static_cast<uint64_t>(p * static_cast<double>(latencies.size() - 1));
+        return latencies[index];
+    };
+    std::cout << fmt::format("{0}: mean {1:.2f} us, p50 {2:.2f} us, p99 {3:.2f} us", name,
+                             total / static_cast<double>(latencies.size()), percentile(0.5),
+                             percentile(0.99))
+              << std::endl;
+}
+
+std::vector<double> bench_websocket(uint64_t num_iterations, const std::string &message,
+                                    uint16_t port) {
+    using namespace std::chrono_literals;
+    hgdb::DebugServer server;
+    echo(server);
+    std::thread server_thread([&server, port]() { server.run(port); });
+    // give the server some time to listen
+    std::this_thread::sleep_for(200ms);
+
+    WSClient client;
+    client.clear_access_channels(websocketpp::log::alevel::all);
+    client.clear_error_channels(websocketpp::log::elevel::all);
+    client.init_asio();
+    std::mutex m;
+    std::condition_variable cv;
+    bool opened = false, failed = false, received = false;
+    client.set_open_handler([&](const websocketpp::connection_hdl &) {
+        std::lock_guard guard(m);
+        opened = true;
+        cv.notify_one();
+    });
+    client.set_fail_handler([&](const websocketpp::connection_hdl &) {
+        std::lock_guard guard(m);
+        failed = true;
+        cv.notify_one();
+    });
+    client.set_message_handler(
+        [&](const websocketpp::connection_hdl &, const WSClient::message_ptr &) {
+            std::lock_guard guard(m);
+            received = true;
+            cv.notify_one();
+        });
+    websocketpp::lib::error_code ec;
+    auto conn = client.get_connection(fmt::format("ws://localhost:{0}", port), ec);
+    std::vector<double> latencies;
+    if (!ec) {
+        client.connect(conn);
+        std::thread client_thread([&client]() { client.run(); });
+        {
+            std::unique_lock lock(m);
+            cv.wait(lock, [&]() { return opened || failed; });
+        }
+        if (opened) {
+            latencies.reserve(num_iterations);
+            for (auto i = 0u; i < num_iterations; i++) {
+                auto start = Clock::now();
+                conn->send(message, websocketpp::frame::opcode::text);
+                std::unique_lock lock(m);
+                cv.wait(lock, [&received]() { return received; });
+                received = false;
+                latencies.emplace_back(
+                    std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+            }
+            conn->close(websocketpp::close::status::normal, "");
+        }
+        client_thread.join();
+    }
+    server.stop();
+    server_thread.join();
+    return latencies;
+}
+
+std::vector<double> bench_shm(uint64_t num_iterations, const std::string &message) {
+    auto name = fmt::format("hgdb-bench-{0}", getpid());
+    hgdb::ShmDebugServer server(name);
+    if (!server.is_open()) return {};
+    echo(server);
+    std::thread server_thread([&server]() { server.run(0); });
+
+    std::vector<double> latencies;
+    hgdb::ShmClient client;
+    if (client.connect(name)) {
+        latencies.reserve(num_iterations);
+        for (auto i = 0u; i < num_iterations; i++) {
+            auto start = Clock::now();
+            client.send(message);
+            if (!client.recv()) break;
+            latencies.emplace_back(
+                std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        }
+        client.close();
+    }
+    server.stop();
+    server_thread.join();
+    return latencies;
+}
+
+int main(int argc, char *argv[]) {
+    uint64_t num_iterations = argc > 1 ? std::stoull(argv[1]) : 10000;
+    uint64_t message_size = argc > 2 ? std::stoull(argv[2]) : 128;
+    uint16_t port = argc > 3 ? static_cast<uint16_t>(std::stoul(argv[3])) : 8889;
+
+    auto message = std::string(message_size, 'a');
+    report("websocket", bench_websocket(num_iterations, message, port));
+    report("shm      ", bench_shm(num_iterations, message));
+    return EXIT_SUCCESS;
+}
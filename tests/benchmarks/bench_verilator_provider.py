@@ -0,0 +1,50 @@
+"""
+Compare signal reads through Verilator's VPI against direct memory access via
+VerilatorVPIProvider. Needs Verilator and a build folder with libhgdb.so.
+Run it from the repository root:
+
+    python tests/benchmarks/bench_verilator_provider.py [num_signals] [num_cycles]
+"""
+import os
+import sys
+import tempfile
+
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from generators.util import VerilatorTester, get_root
+
+
+def generate_design(filename, num_signals):
+    widths = [1, 8, 16, 32, 64]
+    with open(filename, "w+") as f:
+        f.write("module bench(input logic clk, input logic rst);\n")
+        for i in range(num_signals):
+            f.write("logic [{0}:0] s{1};\n".format(widths[i % len(widths)] - 1, i))
+        f.write("always_ff @(posedge clk) begin\n")
+        f.write("    if (rst) begin\n")
+        for i in range(num_signals):
+            f.write("        s{0} <= 0;\n".format(i))
+        f.write("    end else begin\n")
+        for i in range(num_signals):
+            f.write("        s{0} <= s{0} + {1};\n".format(i, i + 1))
+        f.write("    end\nend\nendmodule\n")
+
+
+def main():
+    num_signals = int(sys.argv[1]) if len(sys.argv) > 1 else 256
+    num_cycles = int(sys.argv[2]) if len(sys.argv) > 2 else 10000
+    if not VerilatorTester.available():
+        print("Verilator not available")
+        return
+    root = get_root()
+    bench_dir = os.path.dirname(os.path.abspath(__file__))
+    with tempfile.TemporaryDirectory() as temp:
+        design_filename = os.path.join(temp, "bench.sv")
+        generate_design(design_filename, num_signals)
+        files = [design_filename, os.path.join(bench_dir, "bench_verilator_provider_tb.cc"),
+                 os.path.join(root, "src", "verilator.hh"), os.path.join(root, "src", "rtl.hh")]
+        with VerilatorTester(*files, cwd=temp) as tester:
+            tester.run(blocking=True, NUM_SIGNALS=num_signals, NUM_CYCLES=num_cycles)
+
+
+if __name__ == "__main__":
+    main()
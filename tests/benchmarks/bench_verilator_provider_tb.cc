@@ -0,0 +1,116 @@
+#include <chrono>
+#include <iostream>
+
+#include "Vbench.h"
+#include "verilated.h"
+#include "verilated_vpi.h"  // Required to get definitions
+#include "verilator.hh"
+
+vluint64_t main_time = 0;  // Current simulation time
+
+double sc_time_stamp() {  // Called by $time in Verilog
+    return main_time;
+}
+
+uint64_t get_plus_arg(const std::string &name, uint64_t default_value) {
+    std::string arg = Verilated::commandArgsPlusMatch(name.c_str());
+    if (arg.empty()) return default_value;
+    // skip the leading + and the trailing =
+    return std::stoull(arg.substr(name.size() + 2));
+}
+
+void advance_clock(Vbench &dut) {
+    dut.clk = 0;
+    dut.eval();
+    dut.clk = 1;
+    dut.eval();
+    main_time++;
+}
+
+// simulation cost is subtracted from the measurement
+template <typename F>
+int64_t measure(Vbench &dut, const std::string &label, uint64_t num_reads_per_cycle,
+                uint64_t num_cycles, F read) {
+    auto start = std::chrono::steady_clock::now();
+    for (auto i = 0u; i < num_cycles; i++) {
+        advance_clock(dut);
+    }
+    auto sim_time = std::chrono::steady_clock::now() - start;
+
+    int64_t checksum = 0;
+    start = std::chrono::steady_clock::now();
+    for (auto i = 0u; i < num_cycles; i++) {
+        advance_clock(dut);
+        checksum += read();
+    }
+    auto total_time = std::chrono::steady_clock::now() - start;
+
+    auto read_time =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(total_time - sim_time).count();
+    auto num_reads = static_cast<double>(num_reads_per_cycle * num_cycles);
+    std::cout << label << ": " << static_cast<double>(read_time) / num_reads << " ns/read"
+              << " (checksum " << checksum << ")" << std::endl;
+    return checksum;
+}
+
+// returns the checksums of integer and hex string reads
+std::pair<int64_t, int64_t> run_benchmark(Vbench &dut, std::unique_ptr<hgdb::AVPIProvider> vpi,
+                                          const std::string &label, uint64_t num_signals,
+                                          uint64_t num_cycles) {
+    hgdb::RTLSimulatorClient client({"bench"}, std::move(vpi));
+    std::vector<vpiHandle> handles;
+    handles.reserve(num_signals);
+    for (auto i = 0u; i < num_signals; i++) {
+        handles.emplace_back(client.get_handle("bench.s" + std::to_string(i)));
+    }
+
+    auto int_checksum = measure(dut, label, num_signals, num_cycles, [&]() {
+        int64_t sum = 0;
+        for (auto *handle : handles) {
+            sum += *client.get_value(handle);
+        }
+        return sum;
+    });
+    // hex strings are used for breakpoint and monitor values
+    auto str_checksum = measure(dut, label + " (hex)", num_signals, num_cycles, [&]() {
+        int64_t sum = 0;
+        for (auto *handle : handles) {
+            auto value = *client.get_str_value(handle);
+            for (auto c : value) sum += c;
+        }
+        return sum;
+    });
+    return {int_checksum, str_checksum};
+}
+
+int main(int argc, char **argv) {
+    Verilated::commandArgs(argc, argv);
+    Vbench dut;
+    auto num_signals = get_plus_arg("NUM_SIGNALS", 256);
+    auto num_cycles = get_plus_arg("NUM_CYCLES", 10000);
+
+    // both runs start from the same state so that the checksums are comparable
+    dut.clk = 0;
+    dut.rst = 1;
+    advance_clock(dut);
+    dut.rst = 0;
+    auto vpi_checksum = run_benchmark(dut, std::make_unique<hgdb::VPIProvider>(), "vpi",
+                                      num_signals, num_cycles);
+
+    dut.rst = 1;
+    advance_clock(dut);
+    dut.rst = 0;
+    auto direct = std::make_unique<hgdb::VerilatorVPIProvider>();
+    auto *direct_ptr = direct.get();
+    auto direct_checksum =
+        run_benchmark(dut, std::move(direct), "direct", num_signals, num_cycles);
+    std::cout << "direct signals: " << direct_ptr->num_direct_vars() << "/" << num_signals
+              << std::endl;
+
+    dut.final();
+    if (vpi_checksum != direct_checksum) {
+        std::cerr << "ERROR: checksum mismatch" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -101,5 +101,91 @@ def test_store_scope():
         conn.close()
 
 
+def test_symbol_table_writer():
+    with tempfile.TemporaryDirectory() as temp:
+        db_name = os.path.join(temp, "debug.db")
+        num_bps = 100
+        # small batch size to exercise multiple flushes
+        with hgdb.DebugSymbolTableWriter(db_name, 16) as db:
+            db.store_instances([0, 1], ["top", "top.inst"])
+            db.store_breakpoints(list(range(num_bps)), [i % 2 for i in range(num_bps)], ["/tmp/test.py"] * num_bps,
+                                 [i + 1 for i in range(num_bps)])
+            ids = [db.intern_variable("a" if i % 2 else "b") for i in range(num_bps)]
+            db.store_context_variables(["a"] * num_bps, list(range(num_bps)), ids)
+            db.store_scope(0, [0, 1, 2, 3])
+
+        conn, c = get_conn_cursor(db_name)
+        c.execute("SELECT COUNT(*) FROM breakpoint WHERE filename=?", ("/tmp/test.py",))
+        assert c.fetchone()[0] == num_bps
+        c.execute("SELECT COUNT(*) FROM variable")
+        assert c.fetchone()[0] == 2
+        c.execute("SELECT COUNT(*) FROM context_variable")
+        assert c.fetchone()[0] == num_bps
+        c.execute("SELECT breakpoints FROM scope WHERE scope=?", (0,))
+        assert c.fetchone()[0] == "0 1 2 3"
+        # indices are built at the end
+        c.execute("SELECT COUNT(*) FROM sqlite_master WHERE type='index' AND name='breakpoint_filename_line_num'")
+        assert c.fetchone()[0] == 1
+        conn.close()
+
+
+def test_symbol_table_writer_numpy():
+    np = pytest.importorskip("numpy")
+    with tempfile.TemporaryDirectory() as temp:
+        db_name = os.path.join(temp, "debug.db")
+        num_vars = 1000
+        with hgdb.DebugSymbolTableWriter(db_name) as db:
+            db.store_instance(0, "top")
+            db.store_variables(np.arange(num_vars), np.array(["a{0}".format(i) for i in range(num_vars)]))
+            db.store_generator_variables(["a"] * num_vars, np.zeros(num_vars, dtype=np.int64),
+                                         np.arange(num_vars, dtype=np.uint32))
+            # columns have to match
+            with pytest.raises(ValueError):
+                db.store_variables(np.arange(2), ["a"])
+
+        conn, c = get_conn_cursor(db_name)
+        c.execute("SELECT COUNT(*) FROM generator_variable WHERE instance_id=?", (0,))
+        assert c.fetchone()[0] == num_vars
+        c.execute("SELECT value FROM variable WHERE id=?", (42,))
+        assert c.fetchone()[0] == "a42"
+        conn.close()
+
+
+def test_bulk_query():
+    with tempfile.TemporaryDirectory() as temp:
+        db_name = os.path.join(temp, "debug.db")
+        db = hgdb.DebugSymbolTable(db_name)
+        db.store_instance(0, "top")
+        db.store_instance(1, "top.inst")
+        for i in range(4):
+            db.store_breakpoint(i, i % 2, "/tmp/test{0}.py".format(i % 2), i + 1)
+            db.store_variable(i, "a{0}".format(i))
+            db.store_context_variable("a", i, i)
+            db.store_generator_variable("b", i % 2, i)
+
+        assert db.get_filenames() == {"/tmp/test0.py", "/tmp/test1.py"}
+
+        bps = db.get_breakpoints()
+        assert bps["id"].tolist() == [0, 2, 1, 3]
+        assert bps["filename"] == ["/tmp/test0.py", "/tmp/test0.py", "/tmp/test1.py", "/tmp/test1.py"]
+        bps = db.get_breakpoints("/tmp/test1.py")
+        assert list(bps["line_num"]) == [2, 4]
+        assert len(bps["instance_id"]) == 2 and bps["instance_id"][-1] == 1
+        # buffer protocol
+        assert memoryview(bps["id"]).tolist() == [1, 3]
+
+        insts = db.get_instances()
+        assert insts["name"] == ["top", "top.inst"]
+
+        context_vars = db.get_context_variables(2)
+        assert context_vars["value"] == ["a2"]
+        assert len(db.get_context_variables()["name"]) == 4
+
+        gen_vars = db.get_generator_variables(1)
+        assert sorted(gen_vars["value"]) == ["a1", "a3"]
+        assert gen_vars["instance_id"].tolist() == [1, 1]
+        assert gen_vars["is_rtl"] == [True, True]
+
+
 if __name__ == "__main__":
     test_store_scope()
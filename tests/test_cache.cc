@@ -0,0 +1,89 @@
+#include <filesystem>
+#include <fstream>
+
+#include "../src/cache.hh"
+#include "../src/rtl.hh"
+#include "gtest/gtest.h"
+#include "test_util.hh"
+
+namespace fs = std::filesystem;
+
+std::unique_ptr<hgdb::RTLSimulatorClient> create_client(bool compute_mapping) {
+    auto vpi = std::make_unique<MockVPIProvider>();
+    auto *top = vpi->add_module("top", "top");
+    vpi->set_top(top);
+    auto *dut = vpi->add_module("parent_mod", "top.dut");
+    vpi->add_signal(dut, "top.dut.a");
+    auto *raw_vpi = vpi.get();
+    std::unique_ptr<hgdb::RTLSimulatorClient> client;
+    if (compute_mapping) {
+        client = std::make_unique<hgdb::RTLSimulatorClient>(std::vector<std::string>{"parent_mod"},
+                                                            std::move(vpi));
+    } else {
+        client = std::make_unique<hgdb::RTLSimulatorClient>(std::move(vpi));
+    }
+    client->set_vpi_allocator([raw_vpi]() { return raw_vpi->get_new_handle(); });
+    return client;
+}
+
+class NameCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        auto dir = fs::temp_directory_path();
+        symbol_table_filename = dir / "hgdb_test_cache.db";
+        cache_filename = dir / "hgdb_test_cache.txt";
+        write_symbol_table("symbol table");
+    }
+
+    void TearDown() override {
+        fs::remove(symbol_table_filename);
+        fs::remove(cache_filename);
+    }
+
+    void write_symbol_table(const std::string &content) const {
+        std::ofstream stream(symbol_table_filename, std::ios::trunc);
+        stream << content;
+    }
+
+    std::string symbol_table_filename;
+    std::string cache_filename;
+};
+
+TEST_F(NameCacheTest, save_load) {  // NOLINT
+    auto client = create_client(true);
+    EXPECT_TRUE(client->is_valid_signal("parent_mod.a"));
+    EXPECT_FALSE(client->is_valid_signal("parent_mod.x"));
+
+    hgdb::NameCache cache(cache_filename);
+    // no symbol table, nothing to key on
+    EXPECT_FALSE(cache.save(client.get()));
+    cache.set_symbol_table(symbol_table_filename);
+    EXPECT_TRUE(cache.save(client.get()));
+
+    auto new_client = create_client(false);
+    hgdb::NameCache new_cache(cache_filename);
+    new_cache.set_symbol_table(symbol_table_filename);
+    EXPECT_TRUE(new_cache.load(new_client.get()));
+    EXPECT_EQ(new_client->get_top_mapping(), client->get_top_mapping());
+    EXPECT_EQ(new_client->get_full_name("parent_mod.a"), "top.dut.a");
+    auto signals = new_client->get_signal_validity();
+    EXPECT_EQ(signals.size(), 2);
+    EXPECT_TRUE(signals.at("top.dut.a"));
+    EXPECT_FALSE(signals.at("top.dut.x"));
+    EXPECT_FALSE(new_client->is_valid_signal("parent_mod.x"));
+}
+
+TEST_F(NameCacheTest, invalidate) {  // NOLINT
+    auto client = create_client(true);
+    hgdb::NameCache cache(cache_filename);
+    cache.set_symbol_table(symbol_table_filename);
+    EXPECT_TRUE(cache.save(client.get()));
+
+    // symbol table changed
+    write_symbol_table("new symbol table");
+    auto new_client = create_client(false);
+    hgdb::NameCache new_cache(cache_filename);
+    new_cache.set_symbol_table(symbol_table_filename);
+    EXPECT_FALSE(new_cache.load(new_client.get()));
+    EXPECT_TRUE(new_client->get_top_mapping().empty());
+}
@@ -128,6 +128,42 @@ TEST_F(DBTest, test_get_generator_variable) {  // NOLINT
     }
 }
 
+TEST_F(DBTest, test_get_variable_paged) {  // NOLINT
+    constexpr uint32_t instance_id = 42;
+    constexpr uint32_t breakpoint_id = 1729;
+    constexpr uint32_t num_variables = 20;
+    hgdb::store_instance(*db, instance_id, "top.mod");
+    hgdb::store_breakpoint(*db, breakpoint_id, instance_id, __FILE__, __LINE__);
+    for (uint32_t i = 0; i < num_variables; i++) {
+        // even ids are named a.., odd ids b..
+        auto name = (i % 2 ? "b" : "a") + fmt::format("{0:02d}", i);
+        hgdb::store_variable(*db, i, std::to_string(i), false);
+        hgdb::store_context_variable(*db, name, breakpoint_id, i);
+        hgdb::store_generator_variable(*db, name, instance_id, i);
+    }
+
+    // transfer the db ownership
+    hgdb::DebugDatabaseClient client(std::move(db));
+
+    EXPECT_EQ(client.get_context_variable_count(breakpoint_id), num_variables);
+    EXPECT_EQ(client.get_context_variable_count(breakpoint_id, "b"), num_variables / 2);
+    EXPECT_EQ(client.get_generator_variable_count(instance_id, "a1"), 5);
+    EXPECT_EQ(client.get_generator_variable_count(instance_id, "c"), 0);
+
+    auto values = client.get_context_variables(breakpoint_id, "b", 2, 4);
+    EXPECT_EQ(values.size(), 4);
+    for (uint32_t i = 0; i < values.size(); i++) {
+        auto const &[context_v, v] = values[i];
+        auto id = (i + 2) * 2 + 1;
+        EXPECT_EQ(context_v.name, fmt::format("b{0:02d}", id));
+        EXPECT_EQ(v.value, std::to_string(id));
+    }
+    // last page
+    auto gen_values = client.get_generator_variable(instance_id, "", num_variables - 3, 10);
+    EXPECT_EQ(gen_values.size(), 3);
+    EXPECT_EQ(gen_values.back().first.name, fmt::format("b{0:02d}", num_variables - 1));
+}
+
 TEST_F(DBTest, test_get_annotation_values) {  // NOLINT
     constexpr auto name = "name";
     constexpr std::array values{"1", "2", "3"};
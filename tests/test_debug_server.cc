@@ -33,6 +33,8 @@
  *
  * // this is just for testing trigger
  * logic d, e;
+ * // only used by watchpoints. not in the symbol table
+ * logic [31:0] count;
  * // always_comb
  * //     d = e
  * assign d = e; // d = d e = e en: 1 trigger e   -> d = e | ln: 6
@@ -140,6 +142,9 @@ auto setup_db_vpi(MockVPIProvider &vpi) {
 
         // don't set e here but in the loop
     }
+    // count is updated every time step but only changes every other step
+    auto *count = vpi.add_signal(instance_handles[1], "top.dut.count");
+    vpi.set_signal_value(count, 0);
 
     auto db_client = std::make_unique<hgdb::DebugDatabaseClient>(std::move(db));
     return db_client;
@@ -188,6 +193,7 @@ int main(int argc, char *argv[]) {
     // evaluate the inserted breakpoint
     int time = 0;
     constexpr const char *mod1_e = "top.dut.e";
+    constexpr const char *mod1_count = "top.dut.count";
     using namespace std::chrono_literals;
     while (debug.is_running().load()) {
         // eval loop
@@ -200,6 +206,9 @@ int main(int argc, char *argv[]) {
             raw_vpi->set_signal_value(
                 raw_vpi->vpi_handle_by_name(const_cast<char *>(mod1_e), nullptr),
                 time > 1 ? 1 : time);
+            raw_vpi->set_signal_value(
+                raw_vpi->vpi_handle_by_name(const_cast<char *>(mod1_count), nullptr), time / 2,
+                true);
             // sleep a little bit to avoid high CPU load
             std::this_thread::sleep_for(10ms);
         }
@@ -123,6 +123,39 @@ def test_breakpoint_request(start_server, find_free_port):
     kill_server(s)
 
 
+def test_batch_request(start_server, find_free_port):
+    s, uri = setup_server(start_server, find_free_port)
+    num_instances = 2
+
+    async def test_logic():
+        client = hgdb.HGDBClient(uri, None)
+        await client.connect()
+        requests = [{"type": "breakpoint", "token": "bp{0}".format(i), "payload": {
+            "filename": "/tmp/test.py", "line_num": i, "action": "add"}} for i in (1, 2)]
+        # an invalid one does not affect the rest
+        requests.append({"type": "breakpoint", "token": "bp3", "payload": {
+            "filename": "/tmp/test.py", "line_num": 42, "action": "add"}})
+        responses = await client.batch(requests, check_error=False)
+        assert len(responses) == 3
+        assert [r["token"] for r in responses] == ["bp1", "bp2", "bp3"]
+        assert [r["status"] for r in responses] == ["success", "success", "error"]
+        info = (await client.get_info())["payload"]
+        assert len(info["breakpoints"]) == 2 * num_instances
+        # nested batch is rejected
+        responses = await client.batch([{"type": "batch", "payload": {"requests": []}}],
+                                       check_error=False)
+        assert len(responses) == 1 and responses[0]["status"] == "error"
+        # so are requests that resume the simulation or replace the symbol table
+        responses = await client.batch([{"type": "command", "payload": {"command": "continue"}},
+                                        {"type": "connection", "payload": {"db_filename": "a"}}],
+                                       check_error=False)
+        assert [r["status"] for r in responses] == ["error", "error"]
+        assert "not supported in a batch" in responses[0]["payload"]["reason"]
+
+    asyncio.get_event_loop().run_until_complete(test_logic())
+    kill_server(s)
+
+
 def test_breakpoint_hit_continue(start_server, find_free_port):
     s, uri = setup_server(start_server, find_free_port)
 
@@ -150,6 +183,32 @@ def test_breakpoint_hit_continue(start_server, find_free_port):
     kill_server(s)
 
 
+def test_lazy_variables(start_server, find_free_port):
+    s, uri = setup_server(start_server, find_free_port)
+
+    async def test_logic():
+        client = hgdb.HGDBClient(uri, None)
+        await client.connect()
+        await client.change_option(lazy_variables=True, variable_summary_size=2)
+        await client.set_breakpoint("/tmp/test.py", 5)
+        await client.continue_()
+        bp = await client.recv_bp()
+        instance = bp["payload"]["instances"][0]
+        assert instance["local_count"] == 2 and instance["generator_count"] == 4
+        # summary is ordered by name
+        assert list(instance["generator"].keys()) == ["a", "b"]
+        bp_id = instance["breakpoint_id"]
+        res = (await client.get_variables(bp_id, "generator", offset=2))["payload"]
+        assert res["total"] == 4 and list(res["values"].keys()) == ["clk", "rst"]
+        res = (await client.get_variables(bp_id, "generator", prefix="c"))["payload"]
+        assert res["total"] == 1 and list(res["values"].keys()) == ["clk"]
+        res = (await client.get_variables(bp_id, limit=1))["payload"]
+        assert res["total"] == 2 and res["values"] == {"a": instance["local"]["a"]}
+
+    asyncio.get_event_loop().run_until_complete(test_logic())
+    kill_server(s)
+
+
 def test_breakpoint_step_over(start_server, find_free_port):
     s, uri = setup_server(start_server, find_free_port)
 
@@ -182,6 +241,38 @@ def test_breakpoint_step_over(start_server, find_free_port):
     kill_server(s)
 
 
+def test_step_until(start_server, find_free_port):
+    s, uri = setup_server(start_server, find_free_port)
+
+    async def test_logic():
+        async with hgdb.HGDBClient(uri, None) as client:
+            await client.connect()
+            await client.step_over()
+            await client.step_over()
+            bp = await client.recv_bp()
+            assert bp["payload"]["line_num"] == 1
+            # line 1 and 2 of both instances are skipped
+            await client.step_over(count=4, trace=True)
+            bp = await client.recv_bp()
+            assert bp["payload"]["line_num"] == 5
+            assert len(bp["payload"]["trace"]) == 3
+            # the other instance of the same line
+            await client.step_over(condition="$instance == 1")
+            bp = await client.recv_bp()
+            assert bp["payload"]["line_num"] == 5
+            assert bp["payload"]["instances"][0]["instance_id"] == 1
+            assert "trace" not in bp["payload"]
+            # hit count
+            await client.set_breakpoint("/tmp/test.py", 1)
+            await client.continue_(count=2, trace=True)
+            bp = await client.recv_bp()
+            assert bp["payload"]["line_num"] == 1
+            assert len(bp["payload"]["trace"]) == 1
+
+    asyncio.get_event_loop().run_until_complete(test_logic())
+    kill_server(s)
+
+
 def test_trigger(start_server, find_free_port):
     s, uri = setup_server(start_server, find_free_port)
 
@@ -283,13 +374,12 @@ def test_watch(start_server, find_free_port):
         await client.continue_()
         await client.recv_bp()  # breakpoint
         watch1 = await client.recv()
-        assert watch1["payload"]["track_id"] == id1
+        assert watch1["payload"]["values"][0]["track_id"] == id1
         await client.continue_()
         watch2 = await client.recv()
-        assert watch2["payload"]["track_id"] == id2
+        assert watch2["payload"]["values"][0]["track_id"] == id2
         await client.recv()  # breakpoint
-        watch3 = await client.recv()
-        assert watch3["payload"]["track_id"] == id1
+        # a doesn't change, so there is no update for id1
         # remove id2
         await client.remove_monitor(id2)
         await client.continue_()
@@ -300,6 +390,49 @@ def test_watch(start_server, find_free_port):
     kill_server(s)
 
 
+def test_watchpoint(start_server, find_free_port):
+    s, uri = setup_server(start_server, find_free_port)
+
+    async def test_logic():
+        async with hgdb.HGDBClient(uri, None) as client:
+            await client.connect()
+            # count is written every time step with time / 2
+            id1 = await client.add_watchpoint("mod.count")
+            await client.continue_()
+            res = await client.recv()
+            assert res["type"] == "watchpoint"
+            assert res["payload"]["id"] == id1 and res["payload"]["time"] == 2
+            assert res["payload"]["value"] == "1"
+            # the write at time 3 has the same value
+            await client.continue_()
+            res = await client.recv()
+            assert res["payload"]["time"] == 4 and res["payload"]["value"] == "2"
+            await client.remove_watchpoint(id1)
+            id2 = await client.add_watchpoint("mod.count", condition="$time > 7")
+            await client.continue_()
+            res = await client.recv()
+            assert res["payload"]["id"] == id2 and res["payload"]["time"] == 8
+            assert res["payload"]["value"] == "4"
+            await client.remove_watchpoint(id2)
+            # resumes normally afterwards
+            await client.set_breakpoint("/tmp/test.py", 1)
+            await client.continue_()
+            bp = await client.recv_bp()
+            assert bp["payload"]["time"] > 8
+            # the simulator is running
+            await client.remove_breakpoint("/tmp/test.py", 1)
+            await client.continue_()
+            try:
+                await client.add_watchpoint("mod.count")
+                raised = False
+            except Exception as ex:
+                raised = "paused" in str(ex)
+            assert raised
+
+    asyncio.get_event_loop().run_until_complete(test_logic())
+    kill_server(s)
+
+
 def test_detach(start_server, find_free_port):
     s, uri = setup_server(start_server, find_free_port)
 
@@ -379,6 +512,104 @@ def test_special_value(start_server, find_free_port):
     kill_server(s)
 
 
+def test_compression(start_server, find_free_port):
+    s, uri = setup_server(start_server, find_free_port)
+    num_instances = 2
+
+    async def test_logic():
+        async with hgdb.HGDBClient(uri, None) as client:
+            await client.connect()
+            # python websockets offers permessage-deflate by default
+            assert len(client.ws.extensions) > 0
+            # compress everything
+            await client.change_option(compression_threshold=0)
+            resp = await client.request_breakpoint_location("/tmp/test.py")
+            assert len(resp["payload"]) == 5 * num_instances
+            # turn it off again
+            await client.change_option(compression_threshold=-1)
+            resp = await client.request_breakpoint_location("/tmp/test.py")
+            assert len(resp["payload"]) == 5 * num_instances
+
+    asyncio.get_event_loop().run_until_complete(test_logic())
+    kill_server(s)
+
+
+def test_hit_policy(start_server, find_free_port):
+    s, uri = setup_server(start_server, find_free_port)
+
+    async def test_logic():
+        async with hgdb.HGDBClient(uri, None) as client:
+            await client.connect()
+            # line 1 of instance 1 is hit at every time step
+            await client.set_breakpoint("/tmp/test.py", 1, cond="$instance == 1", ignore_count=2,
+                                        hit_every=2)
+            times = []
+            for i in range(2):
+                await client.continue_()
+                bp = await client.recv_bp()
+                times.append(bp["payload"]["time"])
+            assert times == [2, 4]
+            res = await client.set_breakpoint("/tmp/test.py", 1, hit_every=0, check_error=False)
+            assert res["status"] == "error"
+
+    asyncio.get_event_loop().run_until_complete(test_logic())
+    kill_server(s)
+
+
+def test_run_to_time(start_server, find_free_port):
+    s, uri = setup_server(start_server, find_free_port)
+
+    async def test_logic():
+        async with hgdb.HGDBClient(uri, None) as client:
+            await client.connect()
+            await client.step_over()
+            await client.recv_bp()
+            await client.run_to_time(5)
+            bp = await client.recv_bp()
+            assert bp["payload"]["time"] == 5
+            assert bp["payload"]["line_num"] == 0
+            # already past it
+            await client.run_to_time(3)
+            bp = await client.recv_bp()
+            assert bp["payload"]["time"] == 5
+            # nothing is evaluated before the time guard
+            await client.set_breakpoint("/tmp/test.py", 1, cond="$time >= 8")
+            await client.continue_()
+            bp = await client.recv_bp()
+            assert bp["payload"]["time"] == 8
+            assert bp["payload"]["line_num"] == 1
+            # a running simulation can't stop at a time it has already passed
+            await client.remove_breakpoint("/tmp/test.py", 1)
+            await client.continue_()
+            await client.send({"request": True, "type": "command",
+                               "payload": {"command": "run_to_time", "time": 3}})
+            res = await client.recv()
+            assert res["status"] == "error"
+
+    asyncio.get_event_loop().run_until_complete(test_logic())
+    kill_server(s)
+
+
+def test_monitor_cancels_fast_forward(start_server, find_free_port):
+    s, uri = setup_server(start_server, find_free_port)
+
+    async def test_logic():
+        async with hgdb.HGDBClient(uri, None) as client:
+            await client.connect()
+            await client.set_breakpoint("/tmp/test.py", 1, cond="$time >= 50")
+            await client.continue_()
+            # added while fast-forwarding to the time guard
+            await client.add_monitor("a", 1, monitor_type="clock_edge")
+            res = await client.recv()
+            assert res["type"] == "monitor"
+            assert res["payload"]["time"] < 50
+            bp = await client.recv_bp()
+            assert bp["payload"]["time"] == 50
+
+    asyncio.get_event_loop().run_until_complete(test_logic())
+    kill_server(s)
+
+
 if __name__ == "__main__":
     import sys
 
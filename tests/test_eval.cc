@@ -118,4 +118,21 @@ TEST(expr, expr_eval) {  // NOLINT
     EXPECT_EQ(result, 1);
     result = debug_expr9.eval({{"a", 4}});
     EXPECT_EQ(result, 0);
-}
\ No newline at end of file
+}
+
+TEST(expr, lower_bound) {  // NOLINT
+    hgdb::DebugExpression expr1("$time > 5000000 && a");
+    EXPECT_EQ(*expr1.lower_bound("$time"), 5000001);
+    hgdb::DebugExpression expr2("a && (10 <= $time) && $time >= 5");
+    EXPECT_EQ(*expr2.lower_bound("$time"), 10);
+    hgdb::DebugExpression expr3("$time == 42");
+    EXPECT_EQ(*expr3.lower_bound("$time"), 42);
+    // not guarded by the top-level conjunction
+    hgdb::DebugExpression expr4("$time > 10 || a");
+    EXPECT_FALSE(expr4.lower_bound("$time"));
+    hgdb::DebugExpression expr5("$time < 10");
+    EXPECT_FALSE(expr5.lower_bound("$time"));
+    hgdb::DebugExpression expr6("$time > a");
+    EXPECT_FALSE(expr6.lower_bound("$time"));
+    EXPECT_FALSE(expr1.lower_bound("b"));
+}
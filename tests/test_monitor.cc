@@ -23,6 +23,130 @@ TEST(monitor, get_watched_values) {  // NOLINT
     }
 }
 
+TEST(monitor, value_change) {  // NOLINT
+    int64_t value_a = 42, value_b = 43;
+    auto get_value = [&value_a, &value_b](const std::string &name) -> int64_t {
+        if (name == "a") return value_a;
+        if (name == "b") return value_b;
+        return 0;
+    };
+    hgdb::Monitor monitor(get_value);
+    auto id_a = monitor.add_monitor_variable("a", hgdb::Monitor::WatchType::clock_edge);
+    auto id_b = monitor.add_monitor_variable("b", hgdb::Monitor::WatchType::clock_edge);
+    {
+        // first time everything is sent
+        auto values = monitor.get_watched_values(false);
+        EXPECT_EQ(values.size(), 2);
+    }
+    {
+        // nothing changed
+        auto values = monitor.get_watched_values(false);
+        EXPECT_TRUE(values.empty());
+    }
+    {
+        value_b = 0;
+        auto values = monitor.get_watched_values(false);
+        EXPECT_EQ(values.size(), 1);
+        EXPECT_EQ(values[0].first, id_b);
+        EXPECT_EQ(values[0].second, "0");
+    }
+    {
+        // adding the same watch again re-sends the current value
+        auto id = monitor.add_monitor_variable("a", hgdb::Monitor::WatchType::clock_edge);
+        EXPECT_EQ(id, id_a);
+        auto values = monitor.get_watched_values(false);
+        EXPECT_EQ(values.size(), 1);
+        EXPECT_EQ(values[0].first, id_a);
+        EXPECT_EQ(values[0].second, "42");
+    }
+}
+
+TEST(monitor, sample_every) {  // NOLINT
+    int64_t value = 0;
+    auto get_value = [&value](const std::string &) -> int64_t { return value; };
+    hgdb::Monitor monitor(get_value);
+    hgdb::Monitor::SampleOptions options{.every = 4};
+    monitor.add_monitor_variable("a", hgdb::Monitor::WatchType::clock_edge, options);
+    uint64_t num_updates = 0;
+    for (auto i = 0; i < 16; i++) {
+        value = i;
+        auto values = monitor.get_watched_values(false, i);
+        if (!values.empty()) {
+            num_updates++;
+            EXPECT_EQ(values[0].second, std::to_string(i));
+        }
+    }
+    EXPECT_EQ(num_updates, 4);
+}
+
+TEST(monitor, aggregate) {  // NOLINT
+    int64_t value = 0;
+    auto get_value = [&value](const std::string &) -> int64_t { return value; };
+    hgdb::Monitor monitor(get_value);
+    using AggregateType = hgdb::Monitor::AggregateType;
+    auto id_max = monitor.add_monitor_variable(
+        "a", hgdb::Monitor::WatchType::clock_edge,
+        hgdb::Monitor::SampleOptions{.interval = 10, .aggregate = AggregateType::max});
+    auto id_toggle = monitor.add_monitor_variable(
+        "a", hgdb::Monitor::WatchType::clock_edge,
+        hgdb::Monitor::SampleOptions{.interval = 10, .aggregate = AggregateType::toggle});
+    EXPECT_NE(id_max, id_toggle);
+
+    // clock period is 2
+    std::vector<int64_t> samples = {1, 0, 1, 1, 6, 3};
+    std::vector<std::pair<uint64_t, std::string>> values;
+    for (auto i = 0u; i < samples.size(); i++) {
+        value = samples[i];
+        values = monitor.get_watched_values(false, i * 2);
+        // window ends at time 10
+        if (i < samples.size() - 1) {
+            EXPECT_TRUE(values.empty());
+        }
+    }
+    EXPECT_EQ(values.size(), 2);
+    for (auto const &[id, v] : values) {
+        if (id == id_max) {
+            EXPECT_EQ(v, "6");
+        } else {
+            EXPECT_EQ(v, "4");
+        }
+    }
+}
+
+TEST(monitor, expression) {  // NOLINT
+    int64_t value_a = 1, value_b = 2;
+    auto get_value = [&value_a, &value_b](const std::string &name) -> std::optional<int64_t> {
+        if (name == "top.a") return value_a;
+        if (name == "top.b") return value_b;
+        return std::nullopt;
+    };
+    hgdb::Monitor monitor(get_value);
+    auto expr = std::make_unique<hgdb::DebugExpression>("a + b > 4");
+    EXPECT_TRUE(expr->correct());
+    expr->set_resolved_symbol_name("a", "top.a");
+    expr->set_resolved_symbol_name("b", "top.b");
+    auto id = monitor.add_monitor_expression(
+        std::move(expr), hgdb::Monitor::WatchType::clock_edge, hgdb::Monitor::SampleOptions{});
+    {
+        auto values = monitor.get_watched_values(false);
+        EXPECT_EQ(values.size(), 1);
+        EXPECT_EQ(values[0].first, id);
+        EXPECT_EQ(values[0].second, "0");
+    }
+    {
+        // value changed but the expression result didn't
+        value_a = 2;
+        auto values = monitor.get_watched_values(false);
+        EXPECT_TRUE(values.empty());
+    }
+    {
+        value_b = 3;
+        auto values = monitor.get_watched_values(false);
+        EXPECT_EQ(values.size(), 1);
+        EXPECT_EQ(values[0].second, "1");
+    }
+}
+
 TEST(monitor, remove_track) {  // NOLINT
     hgdb::Monitor monitor;
     // once switch to gcc-11, we will use the following syntax
@@ -142,6 +142,45 @@ TEST(proto, request_parse_connection) {  // NOLINT
     EXPECT_EQ(conn->path_mapping().size(), 2);
     EXPECT_EQ(conn->path_mapping().at("a"), "/tmp/a");
     EXPECT_EQ(conn->path_mapping().at("b"), "/tmp/b");
+    EXPECT_EQ(conn->format(), hgdb::MessageFormat::json);
+}
+
+TEST(proto, request_parse_connection_protocol) {  // NOLINT
+    const auto *req = R"(
+{
+    "request": true,
+    "type": "connection",
+    "payload": {
+        "db_filename": "/tmp/abc.db",
+        "protocol": "msgpack"
+    }
+}
+)";
+    auto r = hgdb::Request::parse_request(req);
+    EXPECT_EQ(r->status(), hgdb::status_code::success);
+    auto *conn = dynamic_cast<hgdb::ConnectionRequest *>(r.get());
+    EXPECT_EQ(conn->format(), hgdb::MessageFormat::msgpack);
+
+    // the request itself can be sent as msgpack as well
+    r = hgdb::Request::parse_request(hgdb::json_to_msgpack(req));
+    EXPECT_EQ(r->status(), hgdb::status_code::success);
+    conn = dynamic_cast<hgdb::ConnectionRequest *>(r.get());
+    EXPECT_NE(conn, nullptr);
+    EXPECT_EQ(conn->db_filename(), "/tmp/abc.db");
+    EXPECT_EQ(conn->format(), hgdb::MessageFormat::msgpack);
+
+    const auto *bad_req = R"(
+{
+    "request": true,
+    "type": "connection",
+    "payload": {
+        "db_filename": "/tmp/abc.db",
+        "protocol": "xml"
+    }
+}
+)";
+    r = hgdb::Request::parse_request(bad_req);
+    EXPECT_EQ(r->status(), hgdb::status_code::error);
 }
 
 TEST(proto, request_parse_bp_location) {  // NOLINT
@@ -324,6 +363,59 @@ TEST(proto, request_parse_monitor) {  // NOLINT
     EXPECT_EQ(r->status(), hgdb::status_code::success);
     req = dynamic_cast<hgdb::MonitorRequest *>(r.get());
     EXPECT_EQ(req->var_name(), "hgdb");
+
+    // sampling
+    const auto *req5 = R"({
+    "request": true,
+    "type": "monitor",
+    "payload": {
+        "action_type": "add",
+        "monitor_type": "clock_edge",
+        "var_name": "hgdb",
+        "sample_interval": 100,
+        "aggregate": "toggle"
+    }
+}
+)";
+    r = hgdb::Request::parse_request(req5);
+    EXPECT_EQ(r->status(), hgdb::status_code::success);
+    req = dynamic_cast<hgdb::MonitorRequest *>(r.get());
+    EXPECT_EQ(req->sample_every(), 0);
+    EXPECT_EQ(req->sample_interval(), 100);
+    EXPECT_EQ(req->aggregate(), hgdb::MonitorRequest::AggregateType::toggle);
+
+    // aggregation needs a window
+    const auto *req6 = R"({
+    "request": true,
+    "type": "monitor",
+    "payload": {
+        "action_type": "add",
+        "monitor_type": "clock_edge",
+        "var_name": "hgdb",
+        "aggregate": "max"
+    }
+}
+)";
+    r = hgdb::Request::parse_request(req6);
+    EXPECT_EQ(r->status(), hgdb::status_code::error);
+
+    // expression watch
+    const auto *req7 = R"({
+    "request": true,
+    "type": "monitor",
+    "payload": {
+        "action_type": "add",
+        "monitor_type": "clock_edge",
+        "expression": "fifo_count > 4",
+        "instance_id": 42
+    }
+}
+)";
+    r = hgdb::Request::parse_request(req7);
+    EXPECT_EQ(r->status(), hgdb::status_code::success);
+    req = dynamic_cast<hgdb::MonitorRequest *>(r.get());
+    EXPECT_EQ(*req->expression(), "fifo_count > 4");
+    EXPECT_TRUE(req->var_name().empty());
 }
 
 TEST(proto, set_value_request) { // NOLINT
@@ -349,6 +441,44 @@ TEST(proto, set_value_request) { // NOLINT
     EXPECT_EQ(*req->breakpoint_id(), 44);
 }
 
+TEST(proto, watchpoint_request) {  // NOLINT
+    const auto *req_str = R"({
+    "request": true,
+    "type": "watchpoint",
+    "payload": {
+        "action": "add",
+        "var_name": "a",
+        "condition": "a == 4",
+        "instance_id": 43
+    }
+}
+)";
+    auto r = hgdb::Request::parse_request(req_str);
+    EXPECT_EQ(r->status(), hgdb::status_code::success);
+    auto *req = dynamic_cast<hgdb::WatchpointRequest *>(r.get());
+    EXPECT_NE(req, nullptr);
+    EXPECT_EQ(req->wp_action(), hgdb::WatchpointRequest::action::add);
+    EXPECT_EQ(req->var_name(), "a");
+    EXPECT_EQ(*req->condition(), "a == 4");
+    EXPECT_EQ(*req->instance_id(), 43);
+    EXPECT_FALSE(req->breakpoint_id());
+
+    req_str = R"({
+    "request": true,
+    "type": "watchpoint",
+    "payload": {
+        "action": "remove",
+        "id": 42
+    }
+}
+)";
+    r = hgdb::Request::parse_request(req_str);
+    EXPECT_EQ(r->status(), hgdb::status_code::success);
+    req = dynamic_cast<hgdb::WatchpointRequest *>(r.get());
+    EXPECT_EQ(req->wp_action(), hgdb::WatchpointRequest::action::remove);
+    EXPECT_EQ(req->id(), 42);
+}
+
 TEST(proto, generic_response) {  // NOLINT
     auto res =
         hgdb::GenericResponse(hgdb::status_code::error, hgdb::RequestType::error, "TEST_ERROR");
@@ -524,16 +654,293 @@ TEST(proto, evaluation_response) {  // NOLINT
 }
 
 TEST(proto, monitor_response) {  // NOLINT
-    auto res = hgdb::MonitorResponse(42, "42");
+    auto res = hgdb::MonitorResponse(10, {{42, "42"}, {43, "1"}});
     auto s = res.str(true);
     constexpr auto expected_value = R"({
     "request": false,
     "type": "monitor",
     "status": "success",
     "payload": {
-        "track_id": 42,
-        "value": "42"
+        "time": 10,
+        "values": [
+            {
+                "track_id": 42,
+                "value": "42"
+            },
+            {
+                "track_id": 43,
+                "value": "1"
+            }
+        ]
+    }
+})";
+    EXPECT_EQ(s, expected_value);
+}
+
+TEST(proto, watchpoint_response) {  // NOLINT
+    auto res = hgdb::WatchpointResponse(10, 1, "a", "4");
+    auto s = res.str(true);
+    constexpr auto expected_value = R"({
+    "request": false,
+    "type": "watchpoint",
+    "status": "success",
+    "payload": {
+        "time": 10,
+        "id": 1,
+        "var_name": "a",
+        "value": "4"
     }
 })";
     EXPECT_EQ(s, expected_value);
-}
\ No newline at end of file
+}
+
+TEST(proto, msgpack_encoding) {  // NOLINT
+    // {"a":1,"b":[-1,"c"]}
+    auto s = hgdb::json_to_msgpack(R"({"a":1,"b":[-1,"c"]})");
+    EXPECT_EQ(s, std::string("\x82\xa1" "a" "\x01\xa1" "b" "\x92\xff\xa1" "c"));
+    auto json = hgdb::msgpack_to_json(s);
+    EXPECT_TRUE(json);
+    EXPECT_EQ(*json, R"({"a":1,"b":[-1,"c"]})");
+
+    // large containers and long strings use the wider headers
+    std::string large = "[";
+    for (auto i = 0; i < 100; i++) {
+        large.append(std::to_string(i * 1000)).append(i == 99 ? "]" : ",");
+    }
+    auto str = std::string(300, 'a');
+    large = fmt::format(R"({{"large":{0},"str":"{1}"}})", large, str);
+    json = hgdb::msgpack_to_json(hgdb::json_to_msgpack(large));
+    EXPECT_TRUE(json);
+    EXPECT_EQ(*json, large);
+
+    // truncated or trailing data
+    EXPECT_FALSE(hgdb::msgpack_to_json(s.substr(0, s.size() - 1)));
+    EXPECT_FALSE(hgdb::msgpack_to_json(s + '\x01'));
+    auto r = hgdb::Request::parse_request(s.substr(0, 3));
+    EXPECT_EQ(r->status(), hgdb::status_code::error);
+}
+
+TEST(proto, msgpack_response) {  // NOLINT
+    auto res = hgdb::BreakPointResponse(1, "a", 2, 3);
+    auto scope = hgdb::BreakPointResponse::Scope(42, "mod", 43);
+    scope.add_generator_value("c", "4");
+    scope.add_local_value("d", "5");
+    res.add_scope(scope);
+    auto s = hgdb::msgpack_to_json(res.serialize(hgdb::MessageFormat::msgpack, false));
+    EXPECT_TRUE(s);
+    EXPECT_EQ(*s, res.str(false));
+
+    auto monitor = hgdb::MonitorResponse(1ull << 40, {{42, "42"}, {43, "1"}});
+    s = hgdb::msgpack_to_json(monitor.serialize(hgdb::MessageFormat::msgpack, false), true);
+    EXPECT_TRUE(s);
+    EXPECT_EQ(*s, monitor.str(true));
+}
+
+TEST(proto, serialize_to_buffer) {  // NOLINT
+    auto res = hgdb::EvaluationResponse("a", "1");
+    auto expected = res.str(false);
+    std::string buffer;
+    res.serialize(buffer, hgdb::MessageFormat::json, false);
+    EXPECT_EQ(buffer, expected);
+    // appends to the existing content
+    res.serialize(buffer, hgdb::MessageFormat::json, false);
+    EXPECT_EQ(buffer, expected + expected);
+    buffer.clear();
+    res.serialize(buffer, hgdb::MessageFormat::msgpack, false);
+    EXPECT_EQ(buffer, res.serialize(hgdb::MessageFormat::msgpack, false));
+}
+
+TEST(proto, request_parse_invalid_payload) {  // NOLINT
+    auto r = hgdb::Request::parse_request(
+        R"({"request": true, "type": "breakpoint", "payload": 42})");
+    EXPECT_EQ(r->status(), hgdb::status_code::error);
+    r = hgdb::Request::parse_request(R"([1, 2])");
+    EXPECT_EQ(r->status(), hgdb::status_code::error);
+
+    // the parse buffers are reused across requests
+    for (auto i = 0; i < 4; i++) {
+        r = hgdb::Request::parse_request(
+            R"({"request": true, "type": "command", "payload": {"command": "stop"}})");
+        EXPECT_EQ(r->status(), hgdb::status_code::success);
+        auto *req = dynamic_cast<hgdb::CommandRequest *>(r.get());
+        EXPECT_EQ(req->command_type(), hgdb::CommandRequest::CommandType::stop);
+    }
+}
+
+TEST(proto, request_parse_batch) {  // NOLINT
+    auto req = R"(
+{
+    "request": true,
+    "type": "batch",
+    "token": "batch",
+    "payload": {
+        "requests": [
+            {"request": true, "type": "debugger-info", "token": "1",
+             "payload": {"command": "options"}},
+            {"request": true, "type": "batch", "token": "2", "payload": {"requests": []}},
+            42
+        ]
+    }
+}
+)";
+    auto r = hgdb::Request::parse_request(req);
+    EXPECT_EQ(r->status(), hgdb::status_code::success);
+    EXPECT_EQ(r->get_token(), "batch");
+    auto *batch = dynamic_cast<hgdb::BatchRequest *>(r.get());
+    EXPECT_NE(batch, nullptr);
+    const auto &requests = batch->requests();
+    EXPECT_EQ(requests.size(), 3);
+    auto *info = dynamic_cast<hgdb::DebuggerInformationRequest *>(requests[0].get());
+    EXPECT_NE(info, nullptr);
+    EXPECT_EQ(info->get_token(), "1");
+    EXPECT_EQ(info->command_type(), hgdb::DebuggerInformationRequest::CommandType::options);
+    // no nested batches
+    EXPECT_EQ(requests[1]->status(), hgdb::status_code::error);
+    EXPECT_EQ(requests[1]->get_token(), "2");
+    EXPECT_EQ(requests[2]->status(), hgdb::status_code::error);
+
+    r = hgdb::Request::parse_request(R"({"request": true, "type": "batch", "payload": {}})");
+    EXPECT_EQ(r->status(), hgdb::status_code::error);
+}
+
+TEST(proto, request_parse_batch_rejected) {  // NOLINT
+    auto req = R"(
+{
+    "request": true,
+    "type": "batch",
+    "payload": {
+        "requests": [
+            {"request": true, "type": "command", "token": "1",
+             "payload": {"command": "continue"}},
+            {"request": true, "type": "connection", "token": "2",
+             "payload": {"db_filename": "a.db"}}
+        ]
+    }
+}
+)";
+    auto r = hgdb::Request::parse_request(req);
+    EXPECT_EQ(r->status(), hgdb::status_code::success);
+    const auto &requests = dynamic_cast<hgdb::BatchRequest *>(r.get())->requests();
+    EXPECT_EQ(requests.size(), 2);
+    // stateful requests are only allowed on their own
+    EXPECT_EQ(requests[0]->status(), hgdb::status_code::error);
+    EXPECT_EQ(requests[0]->get_token(), "1");
+    EXPECT_EQ(requests[1]->status(), hgdb::status_code::error);
+    EXPECT_EQ(requests[1]->get_token(), "2");
+}
+
+TEST(proto, batch_response) {  // NOLINT
+    auto eval = hgdb::EvaluationResponse("a", "1");
+    eval.set_token("1");
+    auto error = hgdb::GenericResponse(hgdb::status_code::error, hgdb::RequestType::command,
+                                       "error");
+    std::vector<std::string> responses = {eval.str(false), error.str(false)};
+    auto res = hgdb::BatchResponse(responses, hgdb::MessageFormat::json);
+    res.set_token("batch");
+    auto expected = fmt::format(
+        R"({{"request":false,"type":"batch","token":"batch","status":"success",)"
+        R"("payload":{{"responses":[{0},{1}]}}}})",
+        responses[0], responses[1]);
+    EXPECT_EQ(res.str(false), expected);
+    // sub-responses are transcoded when the formats differ
+    auto s = hgdb::msgpack_to_json(res.serialize(hgdb::MessageFormat::msgpack, false));
+    EXPECT_TRUE(s);
+    EXPECT_EQ(*s, expected);
+    std::vector<std::string> binary = {eval.serialize(hgdb::MessageFormat::msgpack, false),
+                                       error.serialize(hgdb::MessageFormat::msgpack, false)};
+    auto binary_res = hgdb::BatchResponse(binary, hgdb::MessageFormat::msgpack);
+    binary_res.set_token("batch");
+    s = hgdb::msgpack_to_json(binary_res.serialize(hgdb::MessageFormat::msgpack, false));
+    EXPECT_TRUE(s);
+    EXPECT_EQ(*s, expected);
+    EXPECT_EQ(binary_res.str(false), expected);
+}
+
+TEST(proto, request_parse_variables) {  // NOLINT
+    auto r = hgdb::Request::parse_request(R"(
+{"request": true, "type": "variables",
+ "payload": {"breakpoint_id": 42, "kind": "generator", "prefix": "a.b", "offset": 10}})");
+    EXPECT_EQ(r->status(), hgdb::status_code::success);
+    auto *req = dynamic_cast<hgdb::VariablesRequest *>(r.get());
+    EXPECT_EQ(req->breakpoint_id(), 42);
+    EXPECT_EQ(req->kind(), hgdb::VariablesRequest::VariableKind::generator);
+    EXPECT_EQ(req->prefix(), "a.b");
+    EXPECT_EQ(req->offset(), 10);
+    EXPECT_EQ(req->limit(), hgdb::VariablesRequest::default_limit);
+
+    r = hgdb::Request::parse_request(
+        R"({"request": true, "type": "variables", "payload": {"breakpoint_id": 42, "kind": "a"}})");
+    EXPECT_EQ(r->status(), hgdb::status_code::error);
+}
+
+TEST(proto, variables_response) {  // NOLINT
+    auto res = hgdb::VariablesResponse(42, hgdb::VariablesRequest::VariableKind::local, 100, 10,
+                                       {{"a", "1"}, {"b", "2"}});
+    auto s = res.str(false);
+    EXPECT_EQ(s,
+              R"({"request":false,"type":"variables","status":"success","payload":)"
+              R"({"breakpoint_id":42,"kind":"local","total":100,"offset":10,)"
+              R"("values":{"a":"1","b":"2"}}})");
+}
+
+TEST(proto, request_parse_command_run_until) {  // NOLINT
+    auto r = hgdb::Request::parse_request(R"(
+{"request": true, "type": "command",
+ "payload": {"command": "step_over", "count": 2, "condition": "a == 1", "trace": true}})");
+    EXPECT_EQ(r->status(), hgdb::status_code::success);
+    auto *req = dynamic_cast<hgdb::CommandRequest *>(r.get());
+    EXPECT_EQ(req->command_type(), hgdb::CommandRequest::CommandType::step_over);
+    EXPECT_EQ(req->count(), 2);
+    EXPECT_EQ(req->condition(), "a == 1");
+    EXPECT_TRUE(req->trace());
+
+    r = hgdb::Request::parse_request(
+        R"({"request": true, "type": "command", "payload": {"command": "continue", "count": 0}})");
+    EXPECT_EQ(r->status(), hgdb::status_code::error);
+}
+
+TEST(proto, request_parse_command_run_to_time) {  // NOLINT
+    auto r = hgdb::Request::parse_request(R"(
+{"request": true, "type": "command", "payload": {"command": "run_to_time", "time": 42}})");
+    EXPECT_EQ(r->status(), hgdb::status_code::success);
+    auto *req = dynamic_cast<hgdb::CommandRequest *>(r.get());
+    EXPECT_EQ(req->command_type(), hgdb::CommandRequest::CommandType::run_to_time);
+    EXPECT_EQ(req->time(), 42);
+
+    r = hgdb::Request::parse_request(
+        R"({"request": true, "type": "command", "payload": {"command": "run_to_time"}})");
+    EXPECT_EQ(r->status(), hgdb::status_code::error);
+}
+
+TEST(proto, breakpoint_response_trace) {  // NOLINT
+    auto res = hgdb::BreakPointResponse(3, "a", 2);
+    res.set_trace({{.time = 1, .breakpoint_id = 4}, {.time = 2, .breakpoint_id = 5}});
+    auto s = res.str(false);
+    EXPECT_EQ(s,
+              R"({"request":false,"type":"breakpoint","status":"success","payload":)"
+              R"({"time":3,"filename":"a","line_num":2,"column_num":0,"instances":[],)"
+              R"("trace":[{"time":1,"breakpoint_id":4},{"time":2,"breakpoint_id":5}]}})");
+}
+
+TEST(proto, request_parse_breakpoint_hit_policy) {  // NOLINT
+    auto r = hgdb::Request::parse_request(R"(
+{"request": true, "type": "breakpoint",
+ "payload": {"filename": "a", "line_num": 1, "action": "add", "ignore_count": 4999}})");
+    EXPECT_EQ(r->status(), hgdb::status_code::success);
+    auto *req = dynamic_cast<hgdb::BreakPointRequest *>(r.get());
+    EXPECT_EQ(req->ignore_count(), 4999);
+    EXPECT_EQ(req->hit_every(), 1);
+
+    r = hgdb::Request::parse_request(R"(
+{"request": true, "type": "breakpoint-id",
+ "payload": {"id": 1, "action": "add", "hit_every": 3}})");
+    EXPECT_EQ(r->status(), hgdb::status_code::success);
+    req = dynamic_cast<hgdb::BreakPointRequest *>(r.get());
+    EXPECT_EQ(req->ignore_count(), 0);
+    EXPECT_EQ(req->hit_every(), 3);
+
+    r = hgdb::Request::parse_request(R"(
+{"request": true, "type": "breakpoint-id",
+ "payload": {"id": 1, "action": "add", "hit_every": 0}})");
+    EXPECT_EQ(r->status(), hgdb::status_code::error);
+}
@@ -246,6 +246,24 @@ TEST_F(RTLModuleTest, test_valid_signal) {  // NOLINT
     EXPECT_FALSE(client->is_valid_signal("parent_mod.x"));
 }
 
+TEST_F(RTLModuleTest, test_index_signals) {  // NOLINT
+    std::vector<std::string> names = {"parent_mod.a", "parent_mod.inst1.b", "parent_mod.inst2.clk",
+                                      "parent_mod.x", "parent_mod.inst3.a", "parent_mod.array.0"};
+    auto num_signals = client->index_signals(names);
+    EXPECT_EQ(num_signals, 3);
+    for (auto i = 0u; i < 3; i++) {
+        auto full_name = client->get_full_name(names[i]);
+        auto *handle = vpi().vpi_handle_by_name(const_cast<char *>(full_name.c_str()), nullptr);
+        EXPECT_NE(handle, nullptr);
+        EXPECT_EQ(client->get_handle(names[i]), handle);
+        // providers see the indexed handles as well
+        EXPECT_EQ(vpi().resolved_handles().at(handle), full_name);
+    }
+    // unresolved signals still go through the normal lookup
+    EXPECT_NE(client->get_handle("parent_mod.array.0"), nullptr);
+    EXPECT_FALSE(client->is_valid_signal("parent_mod.x"));
+}
+
 TEST_F(RTLModuleTest, test_hex_str) {  // NOLINT
     auto val = client->get_str_value("parent_mod.inst1.a");
     EXPECT_TRUE(val);
@@ -292,4 +310,31 @@ TEST_F(RTLModuleTest, test_get_design) {  // NOLINT
     auto mapping = client->get_top_mapping();
     EXPECT_EQ(mapping.size(), 1);
     EXPECT_EQ(mapping["parent_mod"], "top.dut");
-}
\ No newline at end of file
+}
+
+TEST(HandleTable, insert_find) {  // NOLINT
+    hgdb::HandleTable<hgdb::HandleInfo> table;
+    // force the table to grow a couple of times
+    constexpr uint64_t num_handles = hgdb::HandleTable<hgdb::HandleInfo>::initial_capacity * 4;
+    std::vector<const hgdb::HandleInfo *> infos;
+    for (uint64_t i = 1; i <= num_handles; i++) {
+        auto *handle = reinterpret_cast<vpiHandle>(i);
+        hgdb::HandleInfo info{.type = vpiNet, .width = static_cast<uint32_t>(i)};
+        infos.emplace_back(table.insert(handle, info));
+    }
+    EXPECT_EQ(table.size(), num_handles);
+    for (uint64_t i = 1; i <= num_handles; i++) {
+        auto *handle = reinterpret_cast<vpiHandle>(i);
+        const auto *info = table.find(handle);
+        EXPECT_NE(info, nullptr);
+        EXPECT_EQ(info->width, i);
+        EXPECT_FALSE(info->is_slice());
+    }
+    EXPECT_EQ(table.find(reinterpret_cast<vpiHandle>(num_handles + 1)), nullptr);
+
+    // entries are never overwritten
+    auto *handle = reinterpret_cast<vpiHandle>(1);
+    const auto *info = table.insert(handle, hgdb::HandleInfo{.type = vpiReg});
+    EXPECT_EQ(info->type, vpiNet);
+    EXPECT_EQ(table.size(), num_handles);
+}
@@ -253,3 +253,61 @@ TEST_F(ScheduleTestNoReverse, test_continue) {  // NOLINT
     EXPECT_TRUE(bps.empty());
 }
 
+TEST(Scheduler, clock_domain) {  // NOLINT
+    auto vpi = std::make_unique<MockVPIProvider>();
+    auto *top = vpi->add_module("top", "top");
+    vpi->set_top(top);
+    auto db = std::make_unique<hgdb::DebugDatabase>(hgdb::init_debug_db(""));
+    db->sync_schema();
+
+    auto constexpr instances = std::array{"top.inst0", "top.inst1", "top"};
+    for (auto i = 0u; i < instances.size(); i++) {
+        hgdb::store_instance(*db, i, instances[i]);
+    }
+    // inst0 and inst1 share the same line, which is normally evaluated together
+    hgdb::store_breakpoint(*db, 0, 0, "test.sv", 1);
+    hgdb::store_breakpoint(*db, 1, 1, "test.sv", 1);
+    hgdb::store_breakpoint(*db, 2, 2, "test.sv", 2);
+    // each child has its own clock
+    hgdb::store_annotation(*db, "clock", "top.inst0.clk");
+    hgdb::store_annotation(*db, "clock", "top.inst1.clk");
+    // top is assigned explicitly
+    hgdb::store_annotation(*db, hgdb::util::clock_domain_annotation, "top top.inst1.clk");
+
+    auto rtl = std::make_unique<hgdb::RTLSimulatorClient>(std::move(vpi));
+    auto db_client = std::make_unique<hgdb::DebugDatabaseClient>(std::move(db));
+
+    bool val1 = false, val2 = true;
+    hgdb::Scheduler scheduler(rtl.get(), db_client.get(), val1, val2);
+    EXPECT_EQ(scheduler.clock_signals().size(), 2);
+    auto breakpoints = db_client->get_breakpoints("test.sv");
+    for (auto const &bp : breakpoints) {
+        scheduler.add_breakpoint(bp, bp);
+    }
+    scheduler.reorder_breakpoints();
+
+    // first clock domain
+    scheduler.start_breakpoint_evaluation(0);
+    auto bps = scheduler.next_breakpoints();
+    EXPECT_EQ(bps.size(), 1);
+    EXPECT_EQ(bps[0]->id, 0);
+    EXPECT_TRUE(scheduler.next_breakpoints().empty());
+
+    // second clock domain
+    scheduler.start_breakpoint_evaluation(1);
+    bps = scheduler.next_breakpoints();
+    EXPECT_EQ(bps.size(), 1);
+    EXPECT_EQ(bps[0]->id, 1);
+    bps = scheduler.next_breakpoints();
+    EXPECT_EQ(bps.size(), 1);
+    EXPECT_EQ(bps[0]->id, 2);
+    EXPECT_TRUE(scheduler.next_breakpoints().empty());
+
+    // no clock domain evaluates everything
+    scheduler.start_breakpoint_evaluation();
+    bps = scheduler.next_breakpoints();
+    EXPECT_EQ(bps.size(), 2);
+    bps = scheduler.next_breakpoints();
+    EXPECT_EQ(bps.size(), 1);
+    EXPECT_TRUE(scheduler.next_breakpoints().empty());
+}
@@ -0,0 +1,113 @@
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <thread>
+
+#include "../src/shm.hh"
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+
+class ShmTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        name = fmt::format("hgdb-test-{0}", getpid());
+        // small ring so that messages wrap around and have to be streamed
+        server = std::make_unique<hgdb::ShmDebugServer>(name, 1024);
+        ASSERT_TRUE(server->is_open());
+        server->set_on_call_client_disconnect([this]() { num_disconnects++; });
+        server->set_on_message([this](const std::string &msg, uint64_t conn_id) {
+            if (msg == "binary") server->set_binary(conn_id, true);
+            server->send(msg, conn_id, server->is_binary(conn_id));
+            // broadcast only goes to clients with the same format
+            server->send(msg + msg);
+        });
+        server_thread = std::thread([this]() { server->run(0); });
+    }
+
+    void TearDown() override {
+        server->stop();
+        server_thread.join();
+    }
+
+    std::string name;
+    std::unique_ptr<hgdb::ShmDebugServer> server;
+    std::thread server_thread;
+    std::atomic<uint64_t> num_disconnects = 0;
+};
+
+TEST_F(ShmTest, round_trip) {  // NOLINT
+    using namespace std::chrono_literals;
+    {
+        hgdb::ShmClient client;
+        EXPECT_TRUE(client.connect(name));
+        for (auto i = 0; i < 100; i++) {
+            auto msg = std::to_string(i);
+            EXPECT_TRUE(client.send(msg));
+            EXPECT_EQ(*client.recv(), msg);
+            EXPECT_EQ(*client.recv(), msg + msg);
+        }
+        // larger than the ring
+        auto large = std::string(10000, 'a');
+        client.send(large);
+        EXPECT_EQ(*client.recv(), large);
+        EXPECT_EQ(*client.recv(), large + large);
+        EXPECT_FALSE(client.recv(10ms));
+
+        client.send("binary");
+        EXPECT_EQ(*client.recv(), "binary");
+        EXPECT_FALSE(client.recv(10ms));
+    }
+    // wait for the server to process the close
+    for (auto i = 0; i < 100 && num_disconnects == 0; i++) std::this_thread::sleep_for(10ms);
+    EXPECT_EQ(num_disconnects, 1);
+}
+
+TEST_F(ShmTest, client_crash) {  // NOLINT
+    using namespace std::chrono_literals;
+    auto pid = fork();
+    if (pid == 0) {
+        hgdb::ShmClient client;
+        if (!client.connect(name)) _exit(EXIT_FAILURE);
+        client.send("42");
+        client.recv();
+        // exit without closing the connection
+        _exit(EXIT_SUCCESS);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    EXPECT_EQ(WEXITSTATUS(status), EXIT_SUCCESS);
+
+    // the next client can take over once the server notices
+    hgdb::ShmClient client;
+    EXPECT_TRUE(client.connect(name));
+    for (auto i = 0; i < 100 && num_disconnects == 0; i++) std::this_thread::sleep_for(10ms);
+    EXPECT_EQ(num_disconnects, 1);
+    client.send("43");
+    EXPECT_EQ(*client.recv(), "43");
+}
+
+TEST_F(ShmTest, slow_client) {  // NOLINT
+    hgdb::ShmClient client;
+    EXPECT_TRUE(client.connect(name));
+    // much more than the ring holds. senders must not wait for a client that is not reading
+    auto large = std::string(100, 'a');
+    for (auto i = 0; i < 1000; i++) server->send(large);
+    // requests keep being handled while responses pile up
+    for (auto i = 0; i < 10; i++) EXPECT_TRUE(client.send(std::to_string(i)));
+    for (auto i = 0; i < 1000; i++) EXPECT_EQ(*client.recv(), large);
+    for (auto i = 0; i < 10; i++) {
+        auto msg = std::to_string(i);
+        EXPECT_EQ(*client.recv(), msg);
+        EXPECT_EQ(*client.recv(), msg + msg);
+    }
+}
+
+TEST_F(ShmTest, segment_in_use) {  // NOLINT
+    // the running server keeps its segment
+    hgdb::ShmDebugServer other(name);
+    EXPECT_FALSE(other.is_open());
+    hgdb::ShmClient client;
+    EXPECT_TRUE(client.connect(name));
+    client.send("42");
+    EXPECT_EQ(*client.recv(), "42");
+}
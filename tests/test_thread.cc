@@ -1,5 +1,6 @@
 #include <thread>
 #include <chrono>
+#include <vector>
 
 #include "../src/thread.hh"
 #include "gtest/gtest.h"
@@ -14,8 +15,40 @@ TEST(thread, wait_ready) {  // NOLINT
     });
     std::this_thread::sleep_for(10ms);
     EXPECT_FALSE(state);
+    EXPECT_TRUE(lock.paused());
     lock.ready();
+    EXPECT_FALSE(lock.paused());
     std::this_thread::sleep_for(10ms);
     EXPECT_TRUE(state);
+    EXPECT_FALSE(lock.paused());
     t.join();
-}
\ No newline at end of file
+}
+
+TEST(thread, mpsc_queue) {  // NOLINT
+    constexpr auto num_threads = 4;
+    constexpr auto num_values = 10000;
+    hgdb::MPSCQueue<int> queue;
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (auto i = 0; i < num_threads; i++) {
+        threads.emplace_back([&queue, i]() {
+            for (auto j = 0; j < num_values; j++) {
+                queue.push(i * num_values + j);
+            }
+        });
+    }
+
+    // consume while producers are running. values from the same producer stay in order
+    std::vector<int> last_values(num_threads, -1);
+    auto count = 0;
+    while (count < num_threads * num_values) {
+        auto value = queue.pop();
+        if (!value) continue;
+        auto producer = *value / num_values;
+        EXPECT_GT(*value, last_values[producer]);
+        last_values[producer] = *value;
+        count++;
+    }
+    for (auto &t : threads) t.join();
+    EXPECT_FALSE(queue.pop());
+}
@@ -175,6 +175,10 @@ public:
         return 0;
     }
 
+    void vpi_handle_resolved(vpiHandle handle, const std::string &name) override {
+        resolved_handles_.emplace(handle, name);
+    }
+
     // this is a noop since we don't actually allocate vpi Handle
     PLI_INT32 vpi_release_handle(vpiHandle) override { return 0; }
 
@@ -273,8 +277,10 @@ public:
 
     void set_time(uint64_t time) { time_ = time; }
 
-    void set_signal_value(vpiHandle handle, int64_t value) {
-        bool value_changed = signal_values_.find(handle) == signal_values_.end() ||
+    // some simulators also call value change callbacks on writes with the same value
+    void set_signal_value(vpiHandle handle, int64_t value, bool notify_same_value = false) {
+        bool value_changed = notify_same_value ||
+                             signal_values_.find(handle) == signal_values_.end() ||
                              signal_values_.at(handle) != value;
         signal_values_[handle] = value;
         // need to see if we need to call any callback
@@ -292,6 +298,7 @@ public:
     void set_top(vpiHandle top) { top_ = top; }
 
     [[nodiscard]] const std::vector<uint32_t> &vpi_ops() const { return vpi_ops_; }
+    [[nodiscard]] const auto &resolved_handles() const { return resolved_handles_; }
 
 protected:
     std::string str_buffer_;
@@ -315,6 +322,7 @@ protected:
     std::unordered_map<vpiHandle, cb_data> callbacks_;
 
     std::vector<uint32_t> vpi_ops_;
+    std::unordered_map<vpiHandle, std::string> resolved_handles_;
 
     std::vector<std::string> argv_str_;
     std::vector<char *> argv_;
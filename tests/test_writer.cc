@@ -0,0 +1,82 @@
+#include <filesystem>
+
+#include "gtest/gtest.h"
+#include "writer.hh"
+
+class WriterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        auto dir = std::filesystem::temp_directory_path();
+        auto const *test_name = ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        filename = dir / (std::string("hgdb_writer_") + test_name + ".db");
+        std::filesystem::remove(filename);
+    }
+
+    void TearDown() override { std::filesystem::remove(filename); }
+
+    std::string filename;
+};
+
+TEST_F(WriterTest, store_rows) {  // NOLINT
+    constexpr uint32_t num_bps = 100;
+    {
+        // small batch size to force multiple transactions
+        hgdb::SymbolTableWriter writer(filename, 16);
+        writer.store_instance(0, "top");
+        writer.store_instance(1, "top.inst");
+        for (auto i = 0u; i < num_bps; i++) {
+            writer.store_breakpoint(i, i % 2, __FILE__, i + 1, 0, i % 3 ? "a" : "");
+            writer.store_variable(i, "a");
+            writer.store_context_variable("a", i, i);
+        }
+        writer.store_scope(0, {3, 2, 1});
+        writer.store_annotation("clock", "top.clk");
+        writer.close();
+    }
+
+    auto db = hgdb::init_debug_db(filename);
+    EXPECT_EQ(db.count<hgdb::BreakPoint>(), num_bps);
+    EXPECT_EQ(db.count<hgdb::Instance>(), 2);
+    EXPECT_EQ(db.count<hgdb::ContextVariable>(), num_bps);
+    auto bp = db.get_pointer<hgdb::BreakPoint>(42);
+    ASSERT_TRUE(bp);
+    EXPECT_EQ(bp->filename, __FILE__);
+    EXPECT_EQ(bp->line_num, 43);
+    EXPECT_EQ(*bp->instance_id, 0);
+    EXPECT_EQ(bp->condition, "");
+    auto scope = db.get_pointer<hgdb::Scope>(0);
+    ASSERT_TRUE(scope);
+    EXPECT_EQ(scope->breakpoints, "3 2 1");
+    auto annotations = db.get_all<hgdb::Annotation>();
+    ASSERT_EQ(annotations.size(), 1);
+    EXPECT_EQ(annotations[0].value, "top.clk");
+}
+
+TEST_F(WriterTest, intern_variable) {  // NOLINT
+    {
+        hgdb::SymbolTableWriter writer(filename);
+        writer.store_variable(41, "a");
+        auto a = writer.intern_variable("a");
+        auto b = writer.intern_variable("a");
+        auto c = writer.intern_variable("a", false);
+        EXPECT_EQ(a, b);
+        EXPECT_NE(a, c);
+        // user provided id is not reused
+        EXPECT_GT(a, 41);
+    }
+
+    auto db = hgdb::init_debug_db(filename);
+    EXPECT_EQ(db.count<hgdb::Variable>(), 3);
+}
+
+TEST_F(WriterTest, columns) {  // NOLINT
+    hgdb::SymbolTableWriter writer(filename);
+    writer.store_instances({0, 1}, {"top", "top.inst"});
+    writer.store_breakpoints({0, 1}, {0, 1}, {__FILE__, __FILE__}, {1, 2});
+    EXPECT_THROW(writer.store_breakpoints({2}, {0, 1}, {__FILE__}, {1}),  // NOLINT
+                 std::invalid_argument);
+    writer.close();
+
+    auto db = hgdb::init_debug_db(filename);
+    EXPECT_EQ(db.count<hgdb::BreakPoint>(), 2);
+}
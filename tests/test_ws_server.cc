@@ -7,6 +7,7 @@
 
 constexpr auto stop_msg = "stop";
 constexpr auto topic_msg = "42";
+constexpr auto slow_msg = "slow";
 // for some reason gcc-10 and clang-11 still can't support constexpr std::string
 // specified in C++20
 // http://www.open-std.org/jtc1/sc22/wg21/docs/papers/2019/p0980r1.pdf
@@ -29,6 +30,8 @@ int main(int argc, char* argv[]) {
     std::thread t;
     // make it an echo server
     auto echo = [&server, &t](const std::string& msg, uint64_t conn_id) {
+        // occupies one server thread
+        if (msg == slow_msg) std::this_thread::sleep_for(2s);
         // this is broadcast
         server.send(msg);
 
@@ -75,6 +75,29 @@ def test_topic_pub(start_server, find_free_port):
         pass
 
 
+def test_concurrent_clients(start_server, find_free_port):
+    port = find_free_port()
+    s = start_server(port, "test_ws_server", wait=0.05)
+
+    async def send_msg():
+        uri = "ws://localhost:{0}".format(port)
+        payload = "hello world"
+        async with websockets.connect(uri) as ws1:
+            async with websockets.connect(uri) as ws2:
+                # takes 2 seconds to handle
+                await ws1.send("slow")
+                await ws2.send(payload)
+                # the other client is served by a different thread
+                echo = await asyncio.wait_for(ws2.recv(), 1)
+                assert echo == payload
+
+    asyncio.get_event_loop().run_until_complete(send_msg())
+    # kill the server
+    s.terminate()
+    while s.poll() is None:
+        pass
+
+
 if __name__ == "__main__":
     import os
     import sys
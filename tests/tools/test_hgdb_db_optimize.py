@@ -0,0 +1,71 @@
+import hgdb
+import os
+import sqlite3
+import subprocess
+import tempfile
+import pytest
+
+
+def create_db(db_filename):
+    db = hgdb.DebugSymbolTable(db_filename)
+    db.store_instance(42, "top.inst")
+    db.store_instance(1, "top")
+    # breakpoints are not sorted
+    bp_ids = [7, 3, 5, 1]
+    for idx, bp_id in enumerate(bp_ids):
+        db.store_breakpoint(bp_id, 42 if idx % 2 else 1, "/tmp/test.py", 4 - idx)
+        # duplicated variables
+        db.store_variable(100 + bp_id, "a")
+        db.store_context_variable("a", bp_id, 100 + bp_id)
+    db.store_scope(10, 5, 7)
+    db.store_scope(2, 3, 1)
+
+
+def get_breakpoints(db_filename):
+    conn = sqlite3.connect(db_filename)
+    c = conn.cursor()
+    c.execute("SELECT breakpoint.filename, breakpoint.line_num, instance.name FROM breakpoint JOIN instance ON "
+              "breakpoint.instance_id = instance.id ORDER BY breakpoint.id")
+    result = c.fetchall()
+    conn.close()
+    return result
+
+
+def test_hgdb_db_optimize(get_build_folder):
+    with tempfile.TemporaryDirectory() as temp:
+        db = os.path.join(temp, "debug.db")
+        create_db(db)
+        optimize = os.path.join(get_build_folder(), "tools", "hgdb-db-optimize", "hgdb-db-optimize")
+        if not os.path.exists(optimize):
+            pytest.skip("hgdb-db-optimize not available")
+        new_db = os.path.join(temp, "new.db")
+        output = subprocess.check_output([optimize, "-i", db, "-o", new_db]).decode("ascii")
+        assert "file size" in output
+
+        # breakpoints are sorted by location
+        bps = get_breakpoints(new_db)
+        assert sorted(get_breakpoints(db)) == bps
+        conn = sqlite3.connect(new_db)
+        c = conn.cursor()
+        c.execute("SELECT id FROM breakpoint ORDER BY line_num")
+        assert [r[0] for r in c.fetchall()] == [0, 1, 2, 3]
+        # variables are deduplicated
+        c.execute("SELECT COUNT(*) FROM variable")
+        assert c.fetchone()[0] == 1
+        c.execute("SELECT COUNT(DISTINCT breakpoint_id) FROM context_variable")
+        assert c.fetchone()[0] == 4
+        # scopes are remapped and keep the execution order
+        c.execute("SELECT breakpoints FROM scope ORDER BY scope")
+        assert [r[0] for r in c.fetchall()] == ["2 0", "1 3"]
+        # indices are created
+        c.execute("SELECT COUNT(*) FROM sqlite_master WHERE type='index' AND name='breakpoint_filename_line_num'")
+        assert c.fetchone()[0] == 1
+        conn.close()
+
+
+if __name__ == "__main__":
+    import sys
+
+    sys.path.append(os.getcwd())
+    from conftest import get_build_folder_fn
+    test_hgdb_db_optimize(get_build_folder_fn)
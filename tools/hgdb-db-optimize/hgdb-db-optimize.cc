@@ -0,0 +1,483 @@
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <unordered_map>
+
+#include "argparse/argparse.hpp"
+#include "fmt/format.h"
+#include "writer.hh"
+
+#define STRINGIFY2(X) #X
+#define STRINGIFY(X) STRINGIFY2(X)
+#define VERSION_STR STRINGIFY(VERSION_NUMBER)
+
+std::optional<argparse::ArgumentParser> get_args(int argc, char **argv) {
+    argparse::ArgumentParser program("HGDB symbol table optimizer", VERSION_STR);
+    std::string program_name;
+    if (std::getenv("HGDB_PYTHON_PACKAGE")) {
+        auto path = std::filesystem::path(program_name);
+        program_name = path.filename();
+    } else {
+        program_name = argv[0];
+    }
+
+    // make the program name look nicer
+    argv[0] = const_cast<char *>(program_name.c_str());
+
+    program.add_argument("-i", "--input").help("Input debug symbol table").required();
+    program.add_argument("-o", "--output")
+        .help("Output debug symbol table. If not set, the input will be optimized in place")
+        .default_value(std::string());
+    program.add_argument("-n", "--num-samples")
+        .help("Number of lookups used to benchmark queries")
+        .default_value(1000)
+        .scan<'i', int>();
+
+    try {
+        program.parse_args(argc, argv);
+        return program;
+    } catch (const std::runtime_error &err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << program;
+        return std::nullopt;
+    }
+}
+
+class Database {
+public:
+    explicit Database(const std::string &filename) {
+        if (sqlite3_open(filename.c_str(), &db_) != SQLITE_OK) {
+            std::string msg = db_ ? sqlite3_errmsg(db_) : "out of memory";
+            sqlite3_close(db_);
+            db_ = nullptr;
+            throw std::runtime_error(fmt::format("Unable to open {0}: {1}", filename, msg));
+        }
+    }
+
+    void exec(const std::string &sql) {
+        char *error = nullptr;
+        if (sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &error) != SQLITE_OK) {
+            std::string msg = error ? error : "unknown error";
+            sqlite3_free(error);
+            throw std::runtime_error(fmt::format("Unable to execute {0}: {1}", sql, msg));
+        }
+    }
+
+    // run the query and call the function on each row
+    void query(const std::string &sql, const std::function<void(sqlite3_stmt *)> &func) {
+        auto *stmt = prepare(sql);
+        step_all(stmt, func);
+        sqlite3_finalize(stmt);
+    }
+
+    int64_t query_int(const std::string &sql) {
+        int64_t result = 0;
+        query(sql, [&result](sqlite3_stmt *stmt) { result = sqlite3_column_int64(stmt, 0); });
+        return result;
+    }
+
+    sqlite3_stmt *prepare(const std::string &sql) {
+        sqlite3_stmt *stmt = nullptr;
+        if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            throw std::runtime_error(
+                fmt::format("Unable to prepare {0}: {1}", sql, sqlite3_errmsg(db_)));
+        }
+        return stmt;
+    }
+
+    void step_all(sqlite3_stmt *stmt, const std::function<void(sqlite3_stmt *)> &func) {
+        int res;
+        while ((res = sqlite3_step(stmt)) == SQLITE_ROW) {
+            if (func) func(stmt);
+        }
+        sqlite3_reset(stmt);
+        if (res != SQLITE_DONE) {
+            throw std::runtime_error(fmt::format("Unable to execute query: {0}", sqlite3_errmsg(db_)));
+        }
+    }
+
+    bool has_table(const std::string &name) {
+        return query_int(fmt::format(
+                   "SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' AND name = '{0}'",
+                   name)) > 0;
+    }
+
+    [[nodiscard]] sqlite3 *db() const { return db_; }
+
+    ~Database() { sqlite3_close(db_); }
+
+private:
+    sqlite3 *db_ = nullptr;
+};
+
+struct Statistics {
+    uint64_t file_size = 0;
+    uint64_t num_pages = 0;
+    uint64_t num_free_pages = 0;
+    uint64_t num_variables = 0;
+    uint64_t num_context_variables = 0;
+    uint64_t num_generator_variables = 0;
+    // query timings in milliseconds
+    double load_breakpoints = 0;
+    double breakpoint_by_location = 0;
+    double context_variable_by_breakpoint = 0;
+    double generator_variable_by_instance = 0;
+    double instance_by_name = 0;
+};
+
+template <typename T>
+double time_it(const T &func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// representative queries issued by the runtime
+Statistics compute_statistics(const std::string &filename, int num_samples) {
+    Statistics stats;
+    stats.file_size = std::filesystem::file_size(filename);
+
+    Database db(filename);
+    stats.num_pages = db.query_int("PRAGMA page_count");
+    stats.num_free_pages = db.query_int("PRAGMA freelist_count");
+    stats.num_variables = db.query_int("SELECT COUNT(*) FROM variable");
+    stats.num_context_variables = db.query_int("SELECT COUNT(*) FROM context_variable");
+    stats.num_generator_variables = db.query_int("SELECT COUNT(*) FROM generator_variable");
+
+    stats.load_breakpoints = time_it([&db]() { db.query("SELECT * FROM breakpoint", {}); });
+
+    // collect the samples first so that only the lookups are timed
+    std::vector<std::pair<std::string, int64_t>> locations;
+    db.query(fmt::format("SELECT DISTINCT filename, line_num FROM breakpoint LIMIT {0}",
+                         num_samples),
+             [&locations](sqlite3_stmt *stmt) {
+                 auto const *filename =
+                     reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+                 locations.emplace_back(filename ? filename : "",
+                                        sqlite3_column_int64(stmt, 1));
+             });
+    std::vector<int64_t> breakpoint_ids, instance_ids;
+    std::vector<std::string> instance_names;
+    db.query(fmt::format("SELECT id FROM breakpoint LIMIT {0}", num_samples),
+             [&breakpoint_ids](sqlite3_stmt *stmt) {
+                 breakpoint_ids.emplace_back(sqlite3_column_int64(stmt, 0));
+             });
+    db.query(fmt::format("SELECT id, name FROM instance LIMIT {0}", num_samples),
+             [&](sqlite3_stmt *stmt) {
+                 instance_ids.emplace_back(sqlite3_column_int64(stmt, 0));
+                 auto const *name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+                 instance_names.emplace_back(name ? name : "");
+             });
+
+    auto *stmt = db.prepare("SELECT * FROM breakpoint WHERE filename = ? AND line_num = ?");
+    stats.breakpoint_by_location = time_it([&]() {
+        for (auto const &[filename, line_num] : locations) {
+            sqlite3_bind_text(stmt, 1, filename.c_str(), static_cast<int>(filename.size()),
+                              SQLITE_STATIC);
+            sqlite3_bind_int64(stmt, 2, line_num);
+            db.step_all(stmt, {});
+        }
+    });
+    sqlite3_finalize(stmt);
+
+    stmt = db.prepare(
+        "SELECT * FROM context_variable JOIN variable ON context_variable.variable_id = "
+        "variable.id WHERE context_variable.breakpoint_id = ?");
+    stats.context_variable_by_breakpoint = time_it([&]() {
+        for (auto id : breakpoint_ids) {
+            sqlite3_bind_int64(stmt, 1, id);
+            db.step_all(stmt, {});
+        }
+    });
+    sqlite3_finalize(stmt);
+
+    stmt = db.prepare(
+        "SELECT * FROM generator_variable JOIN variable ON generator_variable.variable_id = "
+        "variable.id WHERE generator_variable.instance_id = ?");
+    stats.generator_variable_by_instance = time_it([&]() {
+        for (auto id : instance_ids) {
+            sqlite3_bind_int64(stmt, 1, id);
+            db.step_all(stmt, {});
+        }
+    });
+    sqlite3_finalize(stmt);
+
+    stmt = db.prepare("SELECT id FROM instance WHERE name = ?");
+    stats.instance_by_name = time_it([&]() {
+        for (auto const &name : instance_names) {
+            sqlite3_bind_text(stmt, 1, name.c_str(), static_cast<int>(name.size()),
+                              SQLITE_STATIC);
+            db.step_all(stmt, {});
+        }
+    });
+    sqlite3_finalize(stmt);
+
+    return stats;
+}
+
+void print_statistics(const Statistics &before, const Statistics &after) {
+    auto print_row = [](const std::string &name, auto b, auto a) {
+        std::cout << fmt::format("{0:<36}{1:>16}{2:>16}", name, b, a) << std::endl;
+    };
+    auto print_time = [](const std::string &name, double b, double a) {
+        std::cout << fmt::format("{0:<36}{1:>16.3f}{2:>16.3f}", name, b, a) << std::endl;
+    };
+    std::cout << fmt::format("{0:<36}{1:>16}{2:>16}", "", "before", "after") << std::endl;
+    print_row("file size (bytes)", before.file_size, after.file_size);
+    print_row("pages", before.num_pages, after.num_pages);
+    print_row("free pages", before.num_free_pages, after.num_free_pages);
+    print_row("variables", before.num_variables, after.num_variables);
+    print_row("context variables", before.num_context_variables, after.num_context_variables);
+    print_row("generator variables", before.num_generator_variables,
+              after.num_generator_variables);
+    print_time("load breakpoints (ms)", before.load_breakpoints, after.load_breakpoints);
+    print_time("breakpoint by location (ms)", before.breakpoint_by_location,
+               after.breakpoint_by_location);
+    print_time("context variables by bp (ms)", before.context_variable_by_breakpoint,
+               after.context_variable_by_breakpoint);
+    print_time("generator variables by inst (ms)", before.generator_variable_by_instance,
+               after.generator_variable_by_instance);
+    print_time("instance by name (ms)", before.instance_by_name, after.instance_by_name);
+}
+
+// rebuilds the symbol table in place. ids are renumbered so that related rows are next to each
+// other:
+//   - instances are sorted by hierarchy name
+//   - breakpoints are sorted by filename and line number. breakpoints on the same line keep
+//     their relative order, so the lexical execution order is unchanged
+//   - variables are deduplicated and sorted by the first instance/breakpoint referencing them
+class SymbolTableOptimizer {
+public:
+    explicit SymbolTableOptimizer(const std::string &filename) : db_(filename) {}
+
+    void optimize() {
+        // we don't want sqlite to check foreign keys halfway through renumbering
+        db_.exec("PRAGMA foreign_keys = OFF");
+        db_.exec("BEGIN TRANSACTION");
+        compute_id_maps();
+        backup_tables();
+        rebuild_tables();
+        rebuild_scopes();
+        db_.exec("COMMIT");
+
+        hgdb::create_symbol_table_indices(db_.db());
+        db_.exec("ANALYZE");
+        db_.exec("VACUUM");
+    }
+
+private:
+    Database db_;
+
+    static constexpr std::array tables_ = {"instance",         "breakpoint", "variable",
+                                           "context_variable", "generator_variable",
+                                           "annotation",       "event",      "scope"};
+
+    void compute_id_maps() {
+        db_.exec(
+            "CREATE TEMP TABLE instance_map (old_id INTEGER PRIMARY KEY, new_id INTEGER NOT "
+            "NULL)");
+        db_.exec(
+            "INSERT INTO instance_map SELECT id, ROW_NUMBER() OVER (ORDER BY name, id) - 1 FROM "
+            "instance");
+
+        db_.exec(
+            "CREATE TEMP TABLE breakpoint_map (old_id INTEGER PRIMARY KEY, new_id INTEGER NOT "
+            "NULL)");
+        db_.exec(
+            "INSERT INTO breakpoint_map SELECT id, ROW_NUMBER() OVER (ORDER BY filename, "
+            "line_num, id) - 1 FROM breakpoint");
+
+        // variables with identical content share the smallest id
+        db_.exec(
+            "CREATE TEMP TABLE variable_canonical (old_id INTEGER PRIMARY KEY, canonical_id "
+            "INTEGER NOT NULL)");
+        db_.exec(
+            "INSERT INTO variable_canonical SELECT id, MIN(id) OVER (PARTITION BY value, is_rtl) "
+            "FROM variable");
+
+        // generator variables come first since they are ordered by instances. unreferenced
+        // variables are kept at the end
+        db_.exec(
+            "CREATE TEMP TABLE variable_map (old_id INTEGER PRIMARY KEY, new_id INTEGER NOT "
+            "NULL)");
+        auto num_instances = db_.query_int("SELECT COUNT(*) FROM instance");
+        db_.exec(fmt::format(
+            "INSERT INTO variable_map SELECT canonical_id, ROW_NUMBER() OVER (ORDER BY "
+            "MIN(ref_order) IS NULL, MIN(ref_order), canonical_id) - 1 FROM ("
+            "SELECT variable_canonical.canonical_id AS canonical_id, ref.ref_order AS ref_order "
+            "FROM variable_canonical LEFT JOIN ("
+            "SELECT generator_variable.variable_id AS id, instance_map.new_id AS ref_order "
+            "FROM generator_variable JOIN instance_map ON generator_variable.instance_id = "
+            "instance_map.old_id "
+            "UNION ALL "
+            "SELECT context_variable.variable_id, {0} + breakpoint_map.new_id "
+            "FROM context_variable JOIN breakpoint_map ON context_variable.breakpoint_id = "
+            "breakpoint_map.old_id"
+            ") AS ref ON ref.id = variable_canonical.old_id"
+            ") GROUP BY canonical_id",
+            num_instances));
+        // full mapping from any old variable id to the new one
+        db_.exec(
+            "CREATE TEMP TABLE variable_full_map (old_id INTEGER PRIMARY KEY, new_id INTEGER "
+            "NOT NULL)");
+        db_.exec(
+            "INSERT INTO variable_full_map SELECT variable_canonical.old_id, variable_map.new_id "
+            "FROM variable_canonical JOIN variable_map ON variable_canonical.canonical_id = "
+            "variable_map.old_id");
+    }
+
+    void backup_tables() {
+        for (auto const *table : tables_) {
+            if (!db_.has_table(table)) continue;
+            // notice that the backup keeps the original insertion order
+            db_.exec(fmt::format(R"(CREATE TEMP TABLE "old_{0}" AS SELECT * FROM main."{0}")",
+                                 table));
+            db_.exec(fmt::format(R"(DELETE FROM main."{0}")", table));
+        }
+    }
+
+    void rebuild_tables() {
+        db_.exec(
+            "INSERT INTO main.instance (id, name, annotation) SELECT instance_map.new_id, "
+            "old_instance.name, old_instance.annotation FROM old_instance JOIN instance_map ON "
+            "old_instance.id = instance_map.old_id ORDER BY instance_map.new_id");
+
+        db_.exec(
+            "INSERT INTO main.breakpoint (id, instance_id, filename, line_num, column_num, "
+            R"(condition, "trigger") SELECT breakpoint_map.new_id, instance_map.new_id, )"
+            "old_breakpoint.filename, old_breakpoint.line_num, old_breakpoint.column_num, "
+            R"(old_breakpoint.condition, old_breakpoint."trigger" FROM old_breakpoint )"
+            "JOIN breakpoint_map ON old_breakpoint.id = breakpoint_map.old_id "
+            "LEFT JOIN instance_map ON old_breakpoint.instance_id = instance_map.old_id "
+            "ORDER BY breakpoint_map.new_id");
+
+        // only canonical variables are in the variable map
+        db_.exec(
+            "INSERT INTO main.variable (id, value, is_rtl) SELECT variable_map.new_id, "
+            "old_variable.value, old_variable.is_rtl FROM old_variable JOIN variable_map ON "
+            "old_variable.id = variable_map.old_id ORDER BY variable_map.new_id");
+
+        // duplicated rows are removed. within the same breakpoint/instance, variables keep
+        // their original order
+        db_.exec(
+            "INSERT INTO main.context_variable (name, breakpoint_id, variable_id) SELECT "
+            "old_context_variable.name, breakpoint_map.new_id, variable_full_map.new_id "
+            "FROM old_context_variable "
+            "LEFT JOIN breakpoint_map ON old_context_variable.breakpoint_id = "
+            "breakpoint_map.old_id "
+            "LEFT JOIN variable_full_map ON old_context_variable.variable_id = "
+            "variable_full_map.old_id "
+            "GROUP BY old_context_variable.name, breakpoint_map.new_id, "
+            "variable_full_map.new_id "
+            "ORDER BY breakpoint_map.new_id, MIN(old_context_variable.rowid)");
+
+        db_.exec(
+            "INSERT INTO main.generator_variable (name, instance_id, variable_id, annotation) "
+            "SELECT old_generator_variable.name, instance_map.new_id, variable_full_map.new_id, "
+            "old_generator_variable.annotation FROM old_generator_variable "
+            "LEFT JOIN instance_map ON old_generator_variable.instance_id = "
+            "instance_map.old_id "
+            "LEFT JOIN variable_full_map ON old_generator_variable.variable_id = "
+            "variable_full_map.old_id "
+            "GROUP BY old_generator_variable.name, instance_map.new_id, "
+            "variable_full_map.new_id, old_generator_variable.annotation "
+            "ORDER BY instance_map.new_id, MIN(old_generator_variable.rowid)");
+
+        if (db_.has_table("annotation")) {
+            db_.exec(
+                "INSERT INTO main.annotation (name, value) SELECT name, value FROM "
+                "old_annotation GROUP BY name, value ORDER BY MIN(rowid)");
+        }
+
+        if (db_.has_table("event")) {
+            db_.exec(
+                R"(INSERT INTO main.event (name, "transaction", action, fields, matches, )"
+                R"(breakpoint_id) SELECT old_event.name, old_event."transaction", )"
+                "old_event.action, old_event.fields, old_event.matches, breakpoint_map.new_id "
+                "FROM old_event LEFT JOIN breakpoint_map ON old_event.breakpoint_id = "
+                "breakpoint_map.old_id ORDER BY old_event.rowid");
+        }
+    }
+
+    void rebuild_scopes() {
+        if (!db_.has_table("scope")) return;
+        std::unordered_map<int64_t, int64_t> breakpoint_map;
+        db_.query("SELECT old_id, new_id FROM breakpoint_map",
+                  [&breakpoint_map](sqlite3_stmt *stmt) {
+                      breakpoint_map.emplace(sqlite3_column_int64(stmt, 0),
+                                             sqlite3_column_int64(stmt, 1));
+                  });
+
+        // scope ids only define the execution order, so they can be renumbered as well.
+        // ids that don't point to any breakpoint are removed
+        std::vector<std::string> scopes;
+        db_.query(R"(SELECT breakpoints FROM old_scope ORDER BY "scope")",
+                  [&](sqlite3_stmt *stmt) {
+                      auto const *value =
+                          reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+                      std::stringstream ss(value ? value : "");
+                      std::string token;
+                      std::vector<std::string> ids;
+                      while (ss >> token) {
+                          char *end = nullptr;
+                          auto id = std::strtoll(token.c_str(), &end, 10);
+                          if (*end != '\0' || !breakpoint_map.contains(id)) continue;
+                          ids.emplace_back(std::to_string(breakpoint_map.at(id)));
+                      }
+                      if (!ids.empty()) {
+                          scopes.emplace_back(fmt::format("{0}", fmt::join(ids.begin(), ids.end(), " ")));
+                      }
+                  });
+
+        auto *stmt =
+            db_.prepare(R"(INSERT INTO main.scope ("scope", breakpoints) VALUES (?, ?))");
+        for (auto i = 0u; i < scopes.size(); i++) {
+            auto const &scope = scopes[i];
+            sqlite3_bind_int64(stmt, 1, i);
+            sqlite3_bind_text(stmt, 2, scope.c_str(), static_cast<int>(scope.size()),
+                              SQLITE_STATIC);
+            db_.step_all(stmt, {});
+        }
+        sqlite3_finalize(stmt);
+    }
+};
+
+int main(int argc, char *argv[]) {
+    auto args = get_args(argc, argv);
+    if (!args) {
+        return EXIT_FAILURE;
+    }
+    auto input = args->get<std::string>("-i");
+    auto output = args->get<std::string>("-o");
+    auto num_samples = args->get<int>("-n");
+    if (output.empty()) output = input;
+
+    namespace fs = std::filesystem;
+    if (!fs::exists(input)) {
+        std::cerr << "ERROR: " << input << " does not exist" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try {
+        auto before = compute_statistics(input, num_samples);
+        if (!fs::exists(output) || !fs::equivalent(input, output)) {
+            fs::copy_file(input, output, fs::copy_options::overwrite_existing);
+        }
+        {
+            SymbolTableOptimizer optimizer(output);
+            optimizer.optimize();
+        }
+        auto after = compute_statistics(output, num_samples);
+        print_statistics(before, after);
+    } catch (const std::exception &ex) {
+        std::cerr << "ERROR: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}